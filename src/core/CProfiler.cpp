@@ -0,0 +1,185 @@
+#include "core/CProfiler.h"
+#include "core/SystemInfo.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+
+using namespace dbr;
+
+namespace
+{
+
+thread_local uint32_t currentFrame = CProfiler::InvalidFrame;
+
+std::ostream& writeFrame(std::ostream& stream, const uint32_t frameIndex)
+{
+	if (frameIndex == CProfiler::InvalidFrame)
+		return stream << "null";
+	return stream << frameIndex;
+}
+
+struct SSummary
+{
+	std::string_view name;
+	CProfiler::E_EVENT_TYPE type;
+	uint32_t count = 0u;
+	double totalMicroseconds = 0.0;
+	uint64_t totalValue = 0ull;
+	uint64_t maxValue = 0ull;
+};
+
+// in order of first appearance
+std::vector<SSummary> summarize(const std::vector<CProfiler::SEvent>& events)
+{
+	std::vector<SSummary> summaries;
+	for (const auto& event : events)
+	{
+		auto found = std::find_if(summaries.begin(), summaries.end(), [&event](const SSummary& summary) { return summary.name == event.name && summary.type == event.type; });
+		if (found == summaries.end())
+			found = summaries.insert(summaries.end(), { event.name,event.type });
+
+		found->count++;
+		found->totalMicroseconds += event.durationMicroseconds;
+		found->totalValue += event.value;
+		found->maxValue = std::max(found->maxValue, event.value);
+	}
+	return summaries;
+}
+
+bool writeTo(const std::string& path, const std::function<void(std::ostream&)>& write)
+{
+	if (path == "-")
+	{
+		write(std::cout);
+		return bool(std::cout);
+	}
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "ERROR: Could not open " << path << " for writing\n";
+		return false;
+	}
+	write(file);
+	return bool(file);
+}
+
+}
+
+void CProfiler::recordScope(std::string_view name, steady_clock_t::time_point begin, steady_clock_t::time_point end, uint64_t bytes)
+{
+	SEvent event;
+	event.type = EET_SCOPE;
+	event.name = name;
+	event.frameIndex = currentFrame;
+	event.threadIndex = getThreadIndex();
+	event.beginMicroseconds = std::chrono::duration<double, std::micro>(begin - m_origin).count();
+	event.durationMicroseconds = std::chrono::duration<double, std::micro>(end - begin).count();
+	event.value = bytes;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.push_back(event);
+}
+
+void CProfiler::recordCounter(std::string_view name, uint64_t value)
+{
+	SEvent event;
+	event.type = EET_COUNTER;
+	event.name = name;
+	event.frameIndex = currentFrame;
+	event.threadIndex = getThreadIndex();
+	event.beginMicroseconds = std::chrono::duration<double, std::micro>(steady_clock_t::now() - m_origin).count();
+	event.value = value;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.push_back(event);
+}
+
+void CProfiler::recordPeakResidentMemory()
+{
+	recordCounter("peak_rss", getPeakResidentMemory());
+}
+
+std::vector<CProfiler::SEvent> CProfiler::getEvents() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_events;
+}
+
+bool CProfiler::writeJSONLines(const std::string& path) const
+{
+	const auto events = getEvents();
+	return writeTo(path, [&events](std::ostream& stream)
+	{
+		stream << std::fixed << std::setprecision(3);
+		for (const auto& event : events)
+		{
+			stream << "{\"type\":\"" << (event.type == EET_SCOPE ? "scope" : "counter") << "\",\"name\":\"" << event.name << "\",\"frame\":";
+			writeFrame(stream, event.frameIndex) << ",\"thread\":" << event.threadIndex;
+			if (event.type == EET_SCOPE)
+				stream << ",\"begin_us\":" << event.beginMicroseconds << ",\"duration_us\":" << event.durationMicroseconds << ",\"bytes\":" << event.value << "}\n";
+			else
+				stream << ",\"time_us\":" << event.beginMicroseconds << ",\"value\":" << event.value << "}\n";
+		}
+
+		for (const auto& summary : summarize(events))
+		{
+			stream << "{\"type\":\"summary\",\"name\":\"" << summary.name << "\",\"count\":" << summary.count;
+			if (summary.type == EET_SCOPE)
+			{
+				const double totalMilliseconds = summary.totalMicroseconds / 1000.0;
+				stream << ",\"total_ms\":" << totalMilliseconds << ",\"mean_ms\":" << totalMilliseconds / double(summary.count) << ",\"bytes\":" << summary.totalValue;
+				if (summary.totalValue && summary.totalMicroseconds > 0.0)
+					stream << ",\"mb_per_s\":" << double(summary.totalValue) / summary.totalMicroseconds;
+				stream << "}\n";
+			}
+			else
+				stream << ",\"max\":" << summary.maxValue << "}\n";
+		}
+	});
+}
+
+bool CProfiler::writeChromeTrace(const std::string& path) const
+{
+	const auto events = getEvents();
+	return writeTo(path, [&events](std::ostream& stream)
+	{
+		stream << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		for (size_t i = 0ull; i < events.size(); i++)
+		{
+			const auto& event = events[i];
+			stream << "{\"name\":\"" << event.name << "\",\"cat\":\"dbr\",\"pid\":1,\"tid\":" << event.threadIndex << ",\"ts\":" << event.beginMicroseconds;
+			if (event.type == EET_SCOPE)
+			{
+				stream << ",\"ph\":\"X\",\"dur\":" << event.durationMicroseconds << ",\"args\":{\"frame\":";
+				writeFrame(stream, event.frameIndex) << ",\"bytes\":" << event.value << "}}";
+			}
+			else
+				stream << ",\"ph\":\"C\",\"args\":{\"" << event.name << "\":" << event.value << "}}";
+			stream << (i + 1ull < events.size() ? ",\n" : "\n");
+		}
+		stream << "]}\n";
+	});
+}
+
+void CProfiler::setCurrentFrame(uint32_t frameIndex)
+{
+	currentFrame = frameIndex;
+}
+
+uint32_t CProfiler::getCurrentFrame()
+{
+	return currentFrame;
+}
+
+uint32_t CProfiler::getThreadIndex()
+{
+	// small stable numbers read better in a trace viewer than hashed `std::thread::id`s
+	static std::atomic<uint32_t> threadCount = 0u;
+	thread_local const uint32_t threadIndex = threadCount++;
+	return threadIndex;
+}
@@ -0,0 +1,98 @@
+#ifndef __DBR_C_PROFILER_H_INCLUDED__
+#define __DBR_C_PROFILER_H_INCLUDED__
+
+#include "core/Clock.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+
+namespace dbr
+{
+
+/*
+	Collects timed scopes and counters from any thread and writes them out as JSON lines or as a Chrome trace
+	(load it in chrome://tracing or https://ui.perfetto.dev).
+
+	Event names have to outlive the profiler, string literals are the intended use.
+	Everything is attributed to the frame the recording thread is currently working on, see `setCurrentFrame`.
+*/
+class CProfiler
+{
+	public:
+		static constexpr uint32_t InvalidFrame = ~0u;
+
+		enum E_EVENT_TYPE : uint8_t
+		{
+			EET_SCOPE,
+			EET_COUNTER
+		};
+
+		struct SEvent
+		{
+			E_EVENT_TYPE type = EET_SCOPE;
+			std::string_view name;
+			uint32_t frameIndex = InvalidFrame;
+			uint32_t threadIndex = 0u;
+			//! relative to the creation of the profiler
+			double beginMicroseconds = 0.0;
+			double durationMicroseconds = 0.0;
+			//! bytes moved by a scope, or the value of a counter
+			uint64_t value = 0ull;
+		};
+
+		//! Times its own lifetime, does nothing with a null profiler so call sites don't need to check
+		class CScope
+		{
+			public:
+				CScope(CProfiler* profiler, std::string_view name, uint64_t bytes = 0ull)
+					: m_profiler(profiler), m_name(name), m_bytes(bytes), m_begin(profiler ? steady_clock_t::now() : steady_clock_t::time_point()) {}
+				~CScope()
+				{
+					if (m_profiler)
+						m_profiler->recordScope(m_name, m_begin, steady_clock_t::now(), m_bytes);
+				}
+
+				CScope(const CScope&) = delete;
+				CScope& operator=(const CScope&) = delete;
+
+				inline void addBytes(uint64_t bytes) { m_bytes += bytes; }
+
+			private:
+				CProfiler* const m_profiler;
+				const std::string_view m_name;
+				uint64_t m_bytes;
+				const steady_clock_t::time_point m_begin;
+		};
+
+		CProfiler() : m_origin(steady_clock_t::now()) {}
+
+		void recordScope(std::string_view name, steady_clock_t::time_point begin, steady_clock_t::time_point end, uint64_t bytes = 0ull);
+		void recordCounter(std::string_view name, uint64_t value);
+		//! Samples the host's peak resident set size as the `peak_rss` counter
+		void recordPeakResidentMemory();
+
+		std::vector<SEvent> getEvents() const;
+
+		//! One JSON object per event followed by a per stage summary, `-` writes to stdout
+		bool writeJSONLines(const std::string& path) const;
+		//! Chrome trace event format
+		bool writeChromeTrace(const std::string& path) const;
+
+		//! Frame the calling thread works on, set by whoever hands out the work (i.e. `CFramePipeline`)
+		static void setCurrentFrame(uint32_t frameIndex);
+		static uint32_t getCurrentFrame();
+
+	private:
+		static uint32_t getThreadIndex();
+
+		const steady_clock_t::time_point m_origin;
+		mutable std::mutex m_mutex;
+		std::vector<SEvent> m_events;
+};
+
+}
+
+#endif // __DBR_C_PROFILER_H_INCLUDED__
@@ -0,0 +1,104 @@
+#include "core/CThreadPool.h"
+
+#include <atomic>
+#include <algorithm>
+
+using namespace dbr;
+
+CThreadPool::CThreadPool(uint32_t threadCount)
+{
+	if (!threadCount)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	m_workers.reserve(threadCount);
+	for (uint32_t i = 0u; i < threadCount; i++)
+		m_workers.emplace_back(&CThreadPool::workerMain, this);
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_cv.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void CThreadPool::push(std::function<void()>&& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_cv.notify_one();
+}
+
+void CThreadPool::workerMain()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]() { return m_quit || !m_jobs.empty(); });
+
+			if (m_jobs.empty())
+				return;
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+		job();
+	}
+}
+
+void CThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+	if (count == 0ull)
+		return;
+
+	if (count == 1ull)
+	{
+		func(0ull);
+		return;
+	}
+
+	// helpers may get scheduled after we're done, so they only hold the shared state and never touch `func` past the last index
+	struct SState
+	{
+		std::atomic<size_t> next = 0ull;
+		std::atomic<size_t> done = 0ull;
+		size_t count;
+		const std::function<void(size_t)>* func;
+		std::mutex mutex;
+		std::condition_variable cv;
+	};
+	auto state = std::make_shared<SState>();
+	state->count = count;
+	state->func = &func;
+
+	auto work = [](SState& s)
+	{
+		for (size_t i; (i = s.next.fetch_add(1ull)) < s.count;)
+		{
+			(*s.func)(i);
+			if (s.done.fetch_add(1ull) + 1ull == s.count)
+			{
+				std::lock_guard<std::mutex> lock(s.mutex);
+				s.cv.notify_all();
+			}
+		}
+	};
+
+	const size_t helperCount = std::min<size_t>(count - 1ull, m_workers.size());
+	for (size_t i = 0ull; i < helperCount; i++)
+		push([state, work]() { work(*state); });
+
+	work(*state);
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->cv.wait(lock, [&]() { return state->done.load() == count; });
+}
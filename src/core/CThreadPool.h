@@ -0,0 +1,58 @@
+#ifndef __DBR_C_THREAD_POOL_H_INCLUDED__
+#define __DBR_C_THREAD_POOL_H_INCLUDED__
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace dbr
+{
+
+//! Fixed size pool of worker threads, used by the CPU side of the harness for everything that is embarrassingly parallel.
+class CThreadPool
+{
+	public:
+		//! `threadCount == 0` picks `std::thread::hardware_concurrency()`
+		explicit CThreadPool(uint32_t threadCount = 0u);
+		~CThreadPool();
+
+		CThreadPool(const CThreadPool&) = delete;
+		CThreadPool& operator=(const CThreadPool&) = delete;
+
+		inline uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+		template<typename F>
+		auto enqueue(F&& func) -> std::future<std::invoke_result_t<F>>
+		{
+			using result_t = std::invoke_result_t<F>;
+			auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(func));
+			auto future = task->get_future();
+			push([task]() { (*task)(); });
+			return future;
+		}
+
+		//! Calls `func(i)` for every `i` in `[0,count)`, blocks until all are done.
+		//! The calling thread participates, so it is safe to call from within a task running on this pool.
+		void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+	private:
+		void push(std::function<void()>&& job);
+		void workerMain();
+
+		std::vector<std::thread> m_workers;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		bool m_quit = false;
+};
+
+}
+
+#endif // __DBR_C_THREAD_POOL_H_INCLUDED__
@@ -0,0 +1,18 @@
+#ifndef __DBR_CLOCK_H_INCLUDED__
+#define __DBR_CLOCK_H_INCLUDED__
+
+#include <chrono>
+
+namespace dbr
+{
+
+using steady_clock_t = std::chrono::steady_clock;
+
+inline double getMilliseconds(const steady_clock_t::time_point begin, const steady_clock_t::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+}
+
+#endif // __DBR_CLOCK_H_INCLUDED__
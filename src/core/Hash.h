@@ -0,0 +1,58 @@
+#ifndef __DBR_HASH_H_INCLUDED__
+#define __DBR_HASH_H_INCLUDED__
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace dbr
+{
+
+//! Final avalanche of a 64 bit value, from MurmurHash3
+inline uint64_t mixHash(uint64_t value)
+{
+	value ^= value >> 33u;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33u;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33u;
+	return value;
+}
+
+/*
+	64 bit content hash for telling whether megabytes of pixels are the same as last time, not meant to resist attacks.
+
+	Four independent multiply-rotate lanes over 8 byte words keep several multiplies in flight per cycle,
+	so hashing a tile costs about as much as reading it once.
+*/
+inline uint64_t hashMemory(const void* data, size_t size, uint64_t seed = 0ull)
+{
+	constexpr uint64_t Prime1 = 0x9e3779b185ebca87ull;
+	constexpr uint64_t Prime2 = 0xc2b2ae3d27d4eb4full;
+	auto round = [](uint64_t lane, uint64_t word) -> uint64_t
+	{
+		lane += word * Prime2;
+		lane = (lane << 31u) | (lane >> 33u);
+		return lane * Prime1;
+	};
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t lanes[4] = { seed + Prime1 + Prime2,seed + Prime2,seed,seed - Prime1 };
+	size_t offset = 0ull;
+	for (; offset + 32ull <= size; offset += 32ull)
+	for (uint32_t i = 0u; i < 4u; i++)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes + offset + i * 8ull, sizeof(word));
+		lanes[i] = round(lanes[i], word);
+	}
+
+	uint64_t retval = mixHash(lanes[0]) ^ (mixHash(lanes[1]) * Prime1) ^ (mixHash(lanes[2]) * Prime2) ^ mixHash(lanes[3] + size);
+	for (; offset < size; offset++)
+		retval = (retval ^ bytes[offset]) * Prime1;
+	return mixHash(retval);
+}
+
+}
+
+#endif // __DBR_HASH_H_INCLUDED__
@@ -0,0 +1,59 @@
+#include "core/SystemInfo.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#include <fstream>
+#include <string>
+#endif
+
+namespace dbr
+{
+
+size_t getAvailableHostMemory()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX status = {};
+	status.dwLength = sizeof(status);
+	if (!GlobalMemoryStatusEx(&status))
+		return 0ull;
+	return static_cast<size_t>(status.ullAvailPhys);
+#else
+	// `MemAvailable` counts reclaimable page cache, which `_SC_AVPHYS_PAGES` doesn't
+	std::ifstream meminfo("/proc/meminfo");
+	std::string line;
+	while (std::getline(meminfo, line))
+	if (line.rfind("MemAvailable:", 0) == 0)
+		return std::stoull(line.substr(sizeof("MemAvailable:") - 1ull)) * 1024ull; // always in kB
+
+	const long pages = sysconf(_SC_AVPHYS_PAGES);
+	const long pageSize = sysconf(_SC_PAGESIZE);
+	if (pages < 0 || pageSize < 0)
+		return 0ull;
+	return size_t(pages) * size_t(pageSize);
+#endif
+}
+
+size_t getPeakResidentMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0ull;
+	return static_cast<size_t>(counters.PeakWorkingSetSize);
+#else
+	rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0ull;
+#ifdef __APPLE__
+	return size_t(usage.ru_maxrss); // already in bytes
+#else
+	return size_t(usage.ru_maxrss) * 1024ull;
+#endif
+#endif
+}
+
+}
@@ -0,0 +1,16 @@
+#ifndef __DBR_SYSTEM_INFO_H_INCLUDED__
+#define __DBR_SYSTEM_INFO_H_INCLUDED__
+
+#include <cstddef>
+
+namespace dbr
+{
+
+//! Physical memory that can be allocated without swapping, 0 if it can't be determined
+size_t getAvailableHostMemory();
+//! High water mark of the process' resident set size in bytes, 0 if it can't be determined
+size_t getPeakResidentMemory();
+
+}
+
+#endif // __DBR_SYSTEM_INFO_H_INCLUDED__
@@ -0,0 +1,94 @@
+#ifndef __DBR_HALF_H_INCLUDED__
+#define __DBR_HALF_H_INCLUDED__
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#if defined(__F16C__) || defined(__AVX2__)
+	#include <immintrin.h>
+	#define DBR_HAS_F16C
+#endif
+
+namespace dbr
+{
+
+//! Branch-light IEEE binary16 <-> binary32 conversions, written so that the batch loops auto-vectorize when there's no F16C.
+inline float halfToFloat(const uint16_t h)
+{
+	const uint32_t sign = uint32_t(h & 0x8000u) << 16u;
+	const uint32_t exponentMantissa = uint32_t(h & 0x7fffu) << 13u;
+
+	// rebias the exponent with a multiply so denormals come out right too
+	float magic;
+	const uint32_t magicBits = 0x77800000u; // 2^112
+	std::memcpy(&magic, &magicBits, sizeof(float));
+	float value;
+	std::memcpy(&value, &exponentMantissa, sizeof(float));
+	value *= magic;
+
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(float));
+	if (exponentMantissa >= 0x0f800000u) // Inf or NaN
+		bits |= 0x7f800000u;
+	bits |= sign;
+
+	std::memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+//! Round to nearest even, overflow goes to Inf, NaN stays NaN.
+inline uint16_t floatToHalf(const float f)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &f, sizeof(float));
+
+	const uint32_t sign = (bits >> 16u) & 0x8000u;
+	bits &= 0x7fffffffu;
+
+	uint16_t result;
+	if (bits >= 0x47800000u) // overflow or Inf/NaN
+		result = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+	else if (bits < 0x38800000u) // denormal or zero
+	{
+		float value;
+		std::memcpy(&value, &bits, sizeof(float));
+		value += 0.5f; // denormals line up with the float mantissa bits after this add
+		uint32_t denormBits;
+		std::memcpy(&denormBits, &value, sizeof(float));
+		result = static_cast<uint16_t>(denormBits - 0x3f000000u);
+	}
+	else
+	{
+		const uint32_t mantissaOdd = (bits >> 13u) & 1u;
+		bits += 0xc8000fffu + mantissaOdd; // rebias exponent and round
+		result = static_cast<uint16_t>(bits >> 13u);
+	}
+	return static_cast<uint16_t>(result | sign);
+}
+
+inline void convertHalfToFloat(const uint16_t* in, float* out, const size_t count)
+{
+	size_t i = 0ull;
+#ifdef DBR_HAS_F16C
+	for (; i + 8ull <= count; i += 8ull)
+		_mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+#endif
+	for (; i < count; i++)
+		out[i] = halfToFloat(in[i]);
+}
+
+inline void convertFloatToHalf(const float* in, uint16_t* out, const size_t count)
+{
+	size_t i = 0ull;
+#ifdef DBR_HAS_F16C
+	for (; i + 8ull <= count; i += 8ull)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+	for (; i < count; i++)
+		out[i] = floatToHalf(in[i]);
+}
+
+}
+
+#endif // __DBR_HALF_H_INCLUDED__
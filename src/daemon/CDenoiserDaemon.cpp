@@ -0,0 +1,162 @@
+#include "daemon/CDenoiserDaemon.h"
+#include "pipeline/CFramePipeline.h"
+#include "pipeline/CDDSFrameStages.h"
+#include "core/Clock.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <filesystem>
+
+using namespace dbr;
+
+namespace
+{
+
+// how often the accept loop looks at the stop flag
+constexpr uint32_t AcceptPollMilliseconds = 200u;
+
+}
+
+CDenoiserDaemon::CDenoiserDaemon(const std::vector<CDenoiserSession*>& sessions, const SConfig& config)
+	: m_sessions(sessions), m_config(config), m_jobs(config.queueCapacity ? config.queueCapacity : 1u)
+{
+}
+
+bool CDenoiserDaemon::run()
+{
+	CLineSocketListener listener;
+	if (!listener.listen(m_config.socketPath, int(m_config.queueCapacity + m_sessions.size())))
+	{
+		std::cerr << "ERROR: Could not listen on " << m_config.socketPath << ", is another daemon serving it?\n";
+		return false;
+	}
+	std::cout << "Daemon listening on " << m_config.socketPath << " with " << m_sessions.size() << " worker(s) and room for "
+		<< m_config.queueCapacity << " queued job(s)" << std::endl;
+
+	std::vector<std::thread> workers;
+	for (auto* session : m_sessions)
+		workers.emplace_back(&CDenoiserDaemon::workerMain, this, session);
+
+	s_stopRequested = false;
+	while (!s_stopRequested)
+	{
+		CLineSocket client = listener.accept(AcceptPollMilliseconds);
+		if (!client.isOpen())
+			continue;
+
+		client.setReceiveTimeout(m_config.requestTimeoutMilliseconds);
+		SJob job;
+		bool shutdown = false;
+		if (!readRequest(client, job, shutdown))
+			continue;
+		if (shutdown)
+		{
+			client.writeLine("shutting down");
+			break;
+		}
+
+		// the reply has to go out before the job is queued, a worker could otherwise reply to it first
+		const size_t ahead = m_jobs.size();
+		if (ahead >= m_config.queueCapacity)
+		{
+			m_statistics.busy++;
+			client.writeLine("busy " + std::to_string(m_config.queueCapacity));
+			continue;
+		}
+		client.writeLine("accepted " + std::to_string(ahead));
+		job.client = std::move(client);
+		// only this thread pushes, so there's still room
+		m_jobs.tryPush(std::move(job));
+		m_statistics.accepted++;
+	}
+
+	// queued jobs still get done, nothing new gets in
+	listener.close();
+	m_jobs.close();
+	for (auto& worker : workers)
+		worker.join();
+	return true;
+}
+
+bool CDenoiserDaemon::readRequest(CLineSocket& client, SJob& outJob, bool& outShutdown)
+{
+	auto fail = [&client](const std::string& message) -> bool
+	{
+		client.writeLine("error " + message);
+		return false;
+	};
+
+	std::string line;
+	while (client.readLine(line))
+	{
+		std::istringstream tokens(line);
+		std::string command;
+		tokens >> command;
+		if (command == "end")
+			return outJob.frames.empty() ? fail("no frames") : true;
+		else if (command == "shutdown")
+		{
+			outShutdown = true;
+			return true;
+		}
+		else if (command == "pipelined")
+			outJob.pipelined = true;
+		else if (command == "frame")
+		{
+			SFrameDesc& frame = outJob.frames.emplace_back();
+			for (auto& input : frame.inputs)
+				tokens >> input;
+			tokens >> frame.output;
+			if (frame.output.empty())
+				return fail("expected `frame <color> <albedo> <normal> <output>`");
+
+			for (const auto* path : { &frame.inputs[0],&frame.inputs[1],&frame.inputs[2],&frame.output })
+			if (!std::filesystem::path(*path).is_absolute())
+				return fail("relative path " + *path);
+		}
+		else
+			return fail("unknown request `" + line + "`");
+	}
+	return fail("incomplete request");
+}
+
+void CDenoiserDaemon::workerMain(CDenoiserSession* session)
+{
+	// the stages keep their buffers and threads from job to job, only the frame list they refer to changes
+	std::vector<SFrameDesc> frames;
+	CDDSFrameLoader loader(frames);
+	loader.setPrefetchDistance(m_config.prefetchDistance);
+	CSessionFrameDenoiser denoiser(*session);
+	CDDSFrameSaver saver(frames);
+	CFramePipeline pipeline(&loader, &denoiser, &saver, m_config.stagingDepth, session->getBackend());
+
+	while (auto job = m_jobs.pop())
+	{
+		frames = std::move(job->frames);
+		CLineSocket& client = job->client;
+
+		const auto begin = steady_clock_t::now();
+		CFramePipeline::SStatistics statistics;
+		const bool status = pipeline.run(job->pipelined, statistics, [&frames, &client](const SFrameStaging& output, const SFrameTimings& timings)
+		{
+			std::ostringstream message;
+			message << "frame " << output.frameIndex + 1u << "/" << frames.size() << " " << output.width << "x" << output.height << " " << timings.total();
+			client.writeLine(message.str());
+		});
+		const double milliseconds = getMilliseconds(begin, steady_clock_t::now());
+
+		// a client that went away in the meantime doesn't undo the job
+		if (status)
+		{
+			m_statistics.completed++;
+			m_statistics.frames += frames.size();
+			client.writeLine("done ok " + std::to_string(frames.size()) + " " + std::to_string(milliseconds));
+		}
+		else
+		{
+			m_statistics.failed++;
+			client.writeLine("done failed");
+		}
+	}
+}
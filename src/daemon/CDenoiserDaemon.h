@@ -0,0 +1,90 @@
+#ifndef __DBR_C_DENOISER_DAEMON_H_INCLUDED__
+#define __DBR_C_DENOISER_DAEMON_H_INCLUDED__
+
+#include "daemon/CLineSocket.h"
+#include "denoiser/CDenoiserSession.h"
+#include "io/FrameList.h"
+#include "pipeline/CBoundedQueue.h"
+
+#include <atomic>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	Serves denoise jobs over a Unix domain socket, so a render farm wrapper calling it once per frame doesn't pay
+	for process start, backend initialization and denoiser setup every time.
+
+	Every worker owns one of the sessions, its backend and denoiser cache stay warm for the daemon's lifetime, as do the
+	staging buffers of its frame pipeline, and runs one job at a time. Accepted jobs wait in a bounded queue, a job
+	arriving while it's full gets turned away as `busy` straight away so back-pressure reaches the client instead of
+	piling up in the daemon.
+
+	One request per connection, text lines:
+		frame <color> <albedo> <normal> <output>	one or more, absolute paths since the daemon's working directory is its own
+		pipelined									optional, overlap loading and saving with denoising
+		end
+	or just `shutdown`, which finishes the jobs accepted so far and stops. Replies:
+		accepted <jobs queued before it> | busy <queue capacity> | error <message>
+		frame <n>/<count> <width>x<height> <milliseconds>	for every frame once it's saved
+		done ok <frame count> <milliseconds> | done failed, details are in the daemon's log
+*/
+class CDenoiserDaemon
+{
+	public:
+		struct SConfig
+		{
+			std::string socketPath;
+			uint32_t queueCapacity = 4u;
+			//! of every worker's frame pipeline
+			uint32_t stagingDepth = 2u;
+			//! frames of a job whose inputs get read ahead into the page cache
+			uint32_t prefetchDistance = 2u;
+			//! a client that connects and doesn't finish its request in that time gets dropped
+			uint32_t requestTimeoutMilliseconds = 5000u;
+		};
+
+		struct SStatistics
+		{
+			std::atomic<uint32_t> accepted = 0u;
+			std::atomic<uint32_t> busy = 0u;
+			std::atomic<uint32_t> completed = 0u;
+			std::atomic<uint32_t> failed = 0u;
+			std::atomic<uint64_t> frames = 0ull;
+		};
+
+		//! One worker per session, sessions can't be shared since their backends can't be called concurrently
+		CDenoiserDaemon(const std::vector<CDenoiserSession*>& sessions, const SConfig& config);
+
+		//! Serves until a `shutdown` request or `requestStop`, returns false if the socket couldn't be set up
+		bool run();
+
+		//! Async signal safe, i.e. for SIGINT and SIGTERM handlers
+		static void requestStop() { s_stopRequested = true; }
+
+		inline const SStatistics& getStatistics() const { return m_statistics; }
+
+	private:
+		struct SJob
+		{
+			CLineSocket client;
+			std::vector<SFrameDesc> frames;
+			bool pipelined = false;
+		};
+
+		//! Returns false and replies with the error if the request is malformed
+		bool readRequest(CLineSocket& client, SJob& outJob, bool& outShutdown);
+		void workerMain(CDenoiserSession* session);
+
+		const std::vector<CDenoiserSession*> m_sessions;
+		const SConfig m_config;
+		CBoundedQueue<SJob> m_jobs;
+		SStatistics m_statistics;
+
+		static inline std::atomic<bool> s_stopRequested = false;
+};
+
+}
+
+#endif // __DBR_C_DENOISER_DAEMON_H_INCLUDED__
@@ -0,0 +1,195 @@
+#include "daemon/CLineSocket.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+using namespace dbr;
+
+#ifndef _WIN32
+namespace
+{
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS, `SO_NOSIGPIPE` gets set on the socket instead
+#endif
+
+int configureSocket(int fd)
+{
+#ifdef SO_NOSIGPIPE
+	const int enable = 1;
+	if (fd >= 0)
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+	return fd;
+}
+
+bool makeAddress(const std::string& path, sockaddr_un& outAddress)
+{
+	std::memset(&outAddress, 0, sizeof(outAddress));
+	outAddress.sun_family = AF_UNIX;
+	// needs the terminator
+	if (path.empty() || path.size() >= sizeof(outAddress.sun_path))
+		return false;
+	std::memcpy(outAddress.sun_path, path.c_str(), path.size() + 1ull);
+	return true;
+}
+
+}
+#endif
+
+bool CLineSocket::connect(const std::string& path)
+{
+	close();
+#ifdef _WIN32
+	return false;
+#else
+	sockaddr_un address;
+	if (!makeAddress(path, address))
+		return false;
+
+	m_fd = configureSocket(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (m_fd < 0)
+		return false;
+	if (::connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		close();
+		return false;
+	}
+	return true;
+#endif
+}
+
+bool CLineSocket::setReceiveTimeout(uint32_t milliseconds)
+{
+#ifdef _WIN32
+	return false;
+#else
+	timeval timeout;
+	timeout.tv_sec = milliseconds / 1000u;
+	timeout.tv_usec = (milliseconds % 1000u) * 1000u;
+	return m_fd >= 0 && setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0;
+#endif
+}
+
+bool CLineSocket::readLine(std::string& outLine)
+{
+#ifdef _WIN32
+	return false;
+#else
+	while (true)
+	{
+		const size_t end = m_buffer.find('\n');
+		if (end != std::string::npos)
+		{
+			outLine.assign(m_buffer, 0ull, end);
+			m_buffer.erase(0ull, end + 1ull);
+			return true;
+		}
+
+		char chunk[4096];
+		const ssize_t received = m_fd >= 0 ? recv(m_fd, chunk, sizeof(chunk), 0) : -1;
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return false;
+		m_buffer.append(chunk, size_t(received));
+	}
+#endif
+}
+
+bool CLineSocket::writeLine(std::string_view line)
+{
+#ifdef _WIN32
+	return false;
+#else
+	if (m_fd < 0)
+		return false;
+
+	std::string message(line);
+	message += '\n';
+	for (size_t sent = 0ull; sent < message.size();)
+	{
+		const ssize_t result = send(m_fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			return false;
+		sent += size_t(result);
+	}
+	return true;
+#endif
+}
+
+void CLineSocket::close()
+{
+#ifndef _WIN32
+	if (m_fd >= 0)
+		::close(m_fd);
+#endif
+	m_fd = -1;
+	m_buffer.clear();
+}
+
+bool CLineSocketListener::listen(const std::string& path, int backlog)
+{
+	close();
+#ifdef _WIN32
+	return false;
+#else
+	sockaddr_un address;
+	if (!makeAddress(path, address))
+		return false;
+
+	// a socket file nobody answers on is left over from a listener that died
+	CLineSocket probe;
+	if (probe.connect(path))
+		return false;
+	unlink(path.c_str());
+
+	m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_fd < 0)
+		return false;
+	if (bind(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_fd, backlog) != 0)
+	{
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+	m_path = path;
+	return true;
+#endif
+}
+
+CLineSocket CLineSocketListener::accept(uint32_t timeoutMilliseconds)
+{
+#ifdef _WIN32
+	return {};
+#else
+	if (m_fd < 0)
+		return {};
+
+	pollfd request = { m_fd,POLLIN,0 };
+	if (poll(&request, 1, int(timeoutMilliseconds)) <= 0 || !(request.revents & POLLIN))
+		return {};
+	return CLineSocket(configureSocket(::accept(m_fd, nullptr, nullptr)));
+#endif
+}
+
+void CLineSocketListener::close()
+{
+#ifndef _WIN32
+	if (m_fd >= 0)
+	{
+		::close(m_fd);
+		unlink(m_path.c_str());
+	}
+#endif
+	m_fd = -1;
+	m_path.clear();
+}
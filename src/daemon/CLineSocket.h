@@ -0,0 +1,78 @@
+#ifndef __DBR_C_LINE_SOCKET_H_INCLUDED__
+#define __DBR_C_LINE_SOCKET_H_INCLUDED__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dbr
+{
+
+/*
+	A connected Unix domain stream socket exchanging `\n` terminated text lines, what the daemon and its client talk over.
+
+	Writes never raise `SIGPIPE`, a peer that went away just makes them fail.
+	Not available on Windows, where every call fails.
+*/
+class CLineSocket
+{
+	public:
+		CLineSocket() = default;
+		explicit CLineSocket(int fd) : m_fd(fd) {}
+		~CLineSocket() { close(); }
+
+		CLineSocket(const CLineSocket&) = delete;
+		CLineSocket& operator=(const CLineSocket&) = delete;
+		CLineSocket(CLineSocket&& other) noexcept { operator=(std::move(other)); }
+		inline CLineSocket& operator=(CLineSocket&& other) noexcept
+		{
+			std::swap(m_fd, other.m_fd);
+			std::swap(m_buffer, other.m_buffer);
+			return *this;
+		}
+
+		bool connect(const std::string& path);
+		//! Reads fail once nothing arrived for that long, so a stuck peer can't hold up whoever waits on it
+		bool setReceiveTimeout(uint32_t milliseconds);
+
+		//! Without the `\n`, returns false on end of stream, timeout or error
+		bool readLine(std::string& outLine);
+		bool writeLine(std::string_view line);
+		void close();
+
+		inline bool isOpen() const { return m_fd >= 0; }
+		inline int getHandle() const { return m_fd; }
+
+	private:
+		int m_fd = -1;
+		//! received past the last line handed out
+		std::string m_buffer;
+};
+
+/*
+	Listens on a Unix domain socket path, which mustn't be in use by a live listener.
+	A stale socket file from a listener that died gets replaced, the file is removed again on `close`.
+*/
+class CLineSocketListener
+{
+	public:
+		CLineSocketListener() = default;
+		~CLineSocketListener() { close(); }
+
+		CLineSocketListener(const CLineSocketListener&) = delete;
+		CLineSocketListener& operator=(const CLineSocketListener&) = delete;
+
+		bool listen(const std::string& path, int backlog);
+		//! Waits up to `timeoutMilliseconds` for a connection, returns a closed socket if none came
+		CLineSocket accept(uint32_t timeoutMilliseconds);
+		void close();
+
+	private:
+		int m_fd = -1;
+		std::string m_path;
+};
+
+}
+
+#endif // __DBR_C_LINE_SOCKET_H_INCLUDED__
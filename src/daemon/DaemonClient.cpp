@@ -0,0 +1,85 @@
+#include "daemon/DaemonClient.h"
+#include "daemon/CLineSocket.h"
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+namespace dbr
+{
+
+bool submitDaemonJob(const std::string& socketPath, const std::vector<SFrameDesc>& frames, bool pipelined)
+{
+	auto absolute = [](const std::string& path) -> std::string
+	{
+		return std::filesystem::absolute(path).lexically_normal().string();
+	};
+
+	std::string request;
+	for (const auto& frame : frames)
+		request += "frame " + absolute(frame.inputs[0]) + " " + absolute(frame.inputs[1]) + " " + absolute(frame.inputs[2]) + " " + absolute(frame.output) + "\n";
+	if (pipelined)
+		request += "pipelined\n";
+	request += "end";
+
+	uint32_t backoffMilliseconds = 50u;
+	bool reportedBusy = false;
+	while (true)
+	{
+		CLineSocket daemon;
+		if (!daemon.connect(socketPath) || !daemon.writeLine(request))
+		{
+			std::cerr << "ERROR: No daemon is serving " << socketPath << "\n";
+			return false;
+		}
+
+		std::string reply;
+		if (!daemon.readLine(reply))
+		{
+			std::cerr << "ERROR: The daemon on " << socketPath << " hung up\n";
+			return false;
+		}
+
+		if (reply.rfind("busy", 0) == 0)
+		{
+			if (!reportedBusy)
+				std::cout << "Daemon queue is full, waiting for room" << std::endl;
+			reportedBusy = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(backoffMilliseconds));
+			backoffMilliseconds = std::min(backoffMilliseconds * 2u, 1000u);
+			continue;
+		}
+		if (reply.rfind("accepted", 0) != 0)
+		{
+			std::cerr << "ERROR: The daemon refused the job: " << reply << "\n";
+			return false;
+		}
+
+		std::cout << "Daemon accepted the job behind " << reply.substr(std::string_view("accepted ").size()) << " queued one(s)" << std::endl;
+		while (daemon.readLine(reply))
+		{
+			std::cout << "Daemon " << reply << std::endl;
+			if (reply.rfind("done", 0) == 0)
+				return reply.rfind("done ok", 0) == 0;
+		}
+		std::cerr << "ERROR: The daemon on " << socketPath << " hung up before finishing the job\n";
+		return false;
+	}
+}
+
+bool requestDaemonShutdown(const std::string& socketPath)
+{
+	CLineSocket daemon;
+	std::string reply;
+	if (!daemon.connect(socketPath) || !daemon.writeLine("shutdown") || !daemon.readLine(reply))
+	{
+		std::cerr << "ERROR: No daemon is serving " << socketPath << "\n";
+		return false;
+	}
+	std::cout << "Daemon " << reply << std::endl;
+	return true;
+}
+
+}
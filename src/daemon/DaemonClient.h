@@ -0,0 +1,24 @@
+#ifndef __DBR_DAEMON_CLIENT_H_INCLUDED__
+#define __DBR_DAEMON_CLIENT_H_INCLUDED__
+
+#include "io/FrameList.h"
+
+#include <string>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	Hands the frames to the `CDenoiserDaemon` listening on `socketPath` as one job and prints its progress as it comes in.
+	Relative paths get made absolute first. While the daemon's queue is full the job gets offered again with a growing backoff.
+	Returns true once the daemon reports every frame done.
+*/
+bool submitDaemonJob(const std::string& socketPath, const std::vector<SFrameDesc>& frames, bool pipelined);
+
+//! Returns once the daemon has stopped taking jobs, the ones it accepted still get finished
+bool requestDaemonShutdown(const std::string& socketPath);
+
+}
+
+#endif // __DBR_DAEMON_CLIENT_H_INCLUDED__
@@ -0,0 +1,133 @@
+#include "denoiser/CAutotuner.h"
+#include "core/Clock.h"
+#include "core/Hash.h"
+#include "core/half.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace dbr;
+
+CAutotuner::CAutotuner(IDenoiserBackend* backend, CDenoiserCache* cache, const CDenoiserSession::SConfig& config)
+	: m_backend(backend), m_cache(cache), m_config(config)
+{
+}
+
+std::vector<CAutotuner::SCandidate> CAutotuner::getDefaultCandidates(uint32_t width, uint32_t height) const
+{
+	std::vector<uint32_t> overlaps = { m_config.overlap };
+	SDenoiserMemoryRequirements requirements;
+	if (!m_config.overlap && m_cache->getMemoryRequirements({ m_config.model,m_config.inputKind,256u,256u }, requirements) && requirements.overlapWindowSizeInPixels)
+		overlaps.push_back(requirements.overlapWindowSizeInPixels * 2u);
+
+	std::vector<SCandidate> retval;
+	for (const uint32_t overlap : overlaps)
+	{
+		for (uint32_t size = 256u; size < std::max(width, height); size *= 2u)
+			retval.push_back({ std::min(size,width),std::min(size,height),overlap });
+		retval.push_back({ width,height,overlap });
+		retval.push_back({ 0u,0u,overlap });
+	}
+	return retval;
+}
+
+bool CAutotuner::tune(uint32_t width, uint32_t height, const std::vector<SCandidate>& candidates, uint32_t runs, std::vector<SResult>& outResults, const result_callback_t& onResult)
+{
+	outResults.clear();
+	if (!width || !height || !runs)
+		return false;
+
+	// the formats `negotiateTransferFormat` picks for the usual half float inputs
+	const CDenoiserSession::input_formats_t inputFormats = { EPF_HALF4,EPF_HALF3,EPF_HALF3 };
+	const size_t pixelCount = size_t(width) * height;
+	std::vector<uint16_t> layers[EIK_RGB_ALBEDO_NORMAL];
+	for (uint32_t k = 0u; k < EIK_RGB_ALBEDO_NORMAL; k++)
+	{
+		const uint32_t channelCount = getPixelFormatChannelCount(inputFormats[k]);
+		layers[k].resize(pixelCount * channelCount);
+		for (size_t i = 0ull; i < layers[k].size(); i++)
+		{
+			const float unorm = float(mixHash(i * EIK_RGB_ALBEDO_NORMAL + k) >> 40u) / float(1u << 24u);
+			// color spans a few stops of HDR, normals the whole sphere, alpha stays opaque
+			float value = k == 0u ? unorm * unorm * 8.f : k == 2u ? unorm * 2.f - 1.f : unorm;
+			if (channelCount == 4u && i % 4ull == 3ull)
+				value = 1.f;
+			layers[k][i] = floatToHalf(value);
+		}
+	}
+	const void* inputs[EIK_RGB_ALBEDO_NORMAL] = { layers[0].data(),layers[1].data(),layers[2].data() };
+	std::vector<uint8_t> output(size_t(getPixelFormatStride(m_config.format)) * pixelCount);
+	const SHDRParameters hdrParameters;
+
+	const size_t budget = m_config.memoryBudget ? m_config.memoryBudget : (m_backend->getAvailableMemory() + m_cache->getIdleMemoryConsumption()) / 10ull * 9ull;
+	for (const auto& candidate : candidates)
+	{
+		CDenoiserSession::SConfig config = m_config;
+		config.tileWidth = candidate.tileWidth;
+		config.tileHeight = candidate.tileHeight;
+		config.overlap = candidate.overlap;
+		config.validateHostStatistics = false;
+		config.tuningProfile = nullptr;
+		CDenoiserSession session(m_backend, config, nullptr, m_cache);
+
+		SResult result;
+		result.candidate = candidate;
+		if (session.prepare(width, height, inputFormats))
+		{
+			const STilePlan& plan = session.getTilePlan();
+			result.tileWidth = plan.tileWidth;
+			result.tileHeight = plan.tileHeight;
+			result.overlap = plan.overlap;
+			result.tileCount = static_cast<uint32_t>(plan.tiles.size());
+			result.memoryConsumption = session.getMemoryConsumption();
+
+			const bool measured = std::any_of(outResults.begin(), outResults.end(), [&result](const SResult& other) -> bool
+			{
+				return other.tileWidth == result.tileWidth && other.tileHeight == result.tileHeight && other.overlap == result.overlap;
+			});
+			if (measured)
+				continue;
+
+			result.valid = plan.getTotalSizeInBytes() <= budget;
+			result.milliseconds = std::numeric_limits<double>::max();
+			for (uint32_t r = 0u; result.valid && r < runs; r++)
+			{
+				const auto begin = steady_clock_t::now();
+				result.valid = session.denoise(inputs, output.data(), &hdrParameters);
+				result.milliseconds = std::min(result.milliseconds, getMilliseconds(begin, steady_clock_t::now()));
+			}
+			if (result.valid)
+				result.megapixelsPerSecond = double(pixelCount) / (result.milliseconds * 1000.0);
+			else
+				result.milliseconds = 0.0;
+		}
+
+		outResults.push_back(result);
+		if (onResult)
+			onResult(result);
+	}
+	return getBest(outResults);
+}
+
+const CAutotuner::SResult* CAutotuner::getBest(const std::vector<SResult>& results)
+{
+	const SResult* retval = nullptr;
+	for (const auto& result : results)
+	if (result.valid && (!retval || result.megapixelsPerSecond > retval->megapixelsPerSecond))
+		retval = &result;
+	return retval;
+}
+
+CTuningProfile::SEntry CAutotuner::makeProfileEntry(const SResult& best, uint32_t width, uint32_t height) const
+{
+	CTuningProfile::SEntry retval;
+	retval.backend = m_backend->getName();
+	retval.width = width;
+	retval.height = height;
+	retval.tileWidth = best.tileWidth;
+	retval.tileHeight = best.tileHeight;
+	retval.overlap = best.candidate.overlap;
+	retval.megapixelsPerSecond = best.megapixelsPerSecond;
+	retval.memoryConsumption = best.memoryConsumption;
+	return retval;
+}
@@ -0,0 +1,74 @@
+#ifndef __DBR_C_AUTOTUNER_H_INCLUDED__
+#define __DBR_C_AUTOTUNER_H_INCLUDED__
+
+#include "denoiser/CDenoiserSession.h"
+#include "denoiser/CTuningProfile.h"
+
+#include <functional>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	Measures backend tilings for one resolution on synthetic inputs and picks the fastest that fits the memory budget.
+
+	The denoiser's cost doesn't depend on the content, so noise of the right formats times the same as real frames.
+	Every candidate gets a session of its own, they share the cache so overlaps of the same tile size only get set up once.
+	Runs get the HDR parameters handed in like the host computed ones, so only uploads, the tiled invocation and the download count.
+*/
+class CAutotuner
+{
+	public:
+		struct SCandidate
+		{
+			//! both 0 takes the tile planner's pick for the budget
+			uint32_t tileWidth = 0u;
+			uint32_t tileHeight = 0u;
+			//! 0 is the overlap the backend asks for
+			uint32_t overlap = 0u;
+		};
+
+		struct SResult
+		{
+			SCandidate candidate;
+			//! what the session actually got prepared with
+			uint32_t tileWidth = 0u;
+			uint32_t tileHeight = 0u;
+			uint32_t overlap = 0u;
+			uint32_t tileCount = 0u;
+			//! fastest of the runs
+			double milliseconds = 0.0;
+			double megapixelsPerSecond = 0.0;
+			size_t memoryConsumption = 0ull;
+			//! false if it couldn't be set up, denoised or didn't fit the budget
+			bool valid = false;
+		};
+		using result_callback_t = std::function<void(const SResult&)>;
+
+		//! `config` gives the model, input kind, output format and budget, its tiling and tuning profile are ignored
+		CAutotuner(IDenoiserBackend* backend, CDenoiserCache* cache, const CDenoiserSession::SConfig& config);
+
+		/*
+			Square tiles from 256 on up in powers of two, the whole image and the planner's pick, each with the backend's overlap
+			and twice that much, or only with the overlap `config` asks for.
+		*/
+		std::vector<SCandidate> getDefaultCandidates(uint32_t width, uint32_t height) const;
+
+		//! Times every candidate `runs` times, candidates that come out with the same tiling as an earlier one are skipped
+		bool tune(uint32_t width, uint32_t height, const std::vector<SCandidate>& candidates, uint32_t runs, std::vector<SResult>& outResults, const result_callback_t& onResult = {});
+
+		//! The valid result with the highest throughput, nullptr if there's none
+		static const SResult* getBest(const std::vector<SResult>& results);
+		//! A profile entry for `best` at its resolution
+		CTuningProfile::SEntry makeProfileEntry(const SResult& best, uint32_t width, uint32_t height) const;
+
+	private:
+		IDenoiserBackend* const m_backend;
+		CDenoiserCache* const m_cache;
+		const CDenoiserSession::SConfig m_config;
+};
+
+}
+
+#endif // __DBR_C_AUTOTUNER_H_INCLUDED__
@@ -0,0 +1,498 @@
+#include "denoiser/CDenoiserBackendCPU.h"
+#include "core/half.h"
+#include "core/SystemInfo.h"
+#include "denoiser/ColorStatistics.h"
+
+#include <cmath>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <new>
+
+using namespace dbr;
+
+namespace
+{
+
+constexpr size_t AllocationAlignment = 64ull;
+
+// only valid for `x<=0`, vectorizes unlike `std::exp`
+inline float fastNegExp(float x)
+{
+	x = std::max(x, -87.f);
+	const float t = x * 1.44269504f;
+	float whole = float(int32_t(t));
+	whole = whole > t ? whole - 1.f : whole;
+	const float f = t - whole;
+	const float p = 1.f + f * (0.69314718f + f * (0.24022651f + f * (0.05550411f + f * (0.00961813f + f * 0.00133336f))));
+	const int32_t bits = (int32_t(whole) + 127) << 23;
+	float scale;
+	std::memcpy(&scale, &bits, sizeof(float));
+	return p * scale;
+}
+
+inline const uint8_t* getRow(const SImage2D& image, const uint32_t y)
+{
+	return reinterpret_cast<const uint8_t*>(image.data) + size_t(y) * image.rowStrideInBytes;
+}
+
+// Reads `count` pixels whose x coordinates come from `columns` into up to 4 planes, missing channels are set to 1
+template<typename T, uint32_t Channels>
+void loadRowT(const uint8_t* row, const uint32_t pixelStride, const uint32_t* columns, const uint32_t count, float* const* planes, const uint32_t planeCount)
+{
+	for (uint32_t i = 0u; i < count; i++)
+	{
+		const T* pixel = reinterpret_cast<const T*>(row + size_t(columns[i]) * pixelStride);
+		for (uint32_t c = 0u; c < planeCount; c++)
+		{
+			float value = 1.f;
+			if (c < Channels)
+			{
+				if constexpr (std::is_same_v<T, uint16_t>)
+					value = halfToFloat(pixel[c]);
+				else
+					value = pixel[c];
+			}
+			planes[c][i] = value;
+		}
+	}
+}
+
+void loadRow(const SImage2D& image, const uint32_t y, const uint32_t* columns, const uint32_t count, float* const* planes, const uint32_t planeCount)
+{
+	const uint8_t* row = getRow(image, y);
+	switch (image.format)
+	{
+		case EPF_HALF3:
+			loadRowT<uint16_t, 3u>(row, image.pixelStrideInBytes, columns, count, planes, planeCount);
+			break;
+		case EPF_HALF4:
+			loadRowT<uint16_t, 4u>(row, image.pixelStrideInBytes, columns, count, planes, planeCount);
+			break;
+		case EPF_FLOAT3:
+			loadRowT<float, 3u>(row, image.pixelStrideInBytes, columns, count, planes, planeCount);
+			break;
+		default:
+			loadRowT<float, 4u>(row, image.pixelStrideInBytes, columns, count, planes, planeCount);
+			break;
+	}
+}
+
+template<typename T, uint32_t Channels>
+void storeRowT(uint8_t* row, const uint32_t pixelStride, const uint32_t count, const float* const* planes)
+{
+	for (uint32_t i = 0u; i < count; i++)
+	{
+		T* pixel = reinterpret_cast<T*>(row + size_t(i) * pixelStride);
+		for (uint32_t c = 0u; c < Channels; c++)
+		{
+			if constexpr (std::is_same_v<T, uint16_t>)
+				pixel[c] = floatToHalf(planes[c][i]);
+			else
+				pixel[c] = planes[c][i];
+		}
+	}
+}
+
+void storeRow(const SImage2D& image, const uint32_t x, const uint32_t y, const uint32_t count, const float* const* planes)
+{
+	uint8_t* row = reinterpret_cast<uint8_t*>(image.data) + size_t(y) * image.rowStrideInBytes + size_t(x) * image.pixelStrideInBytes;
+	switch (image.format)
+	{
+		case EPF_HALF3:
+			storeRowT<uint16_t, 3u>(row, image.pixelStrideInBytes, count, planes);
+			break;
+		case EPF_HALF4:
+			storeRowT<uint16_t, 4u>(row, image.pixelStrideInBytes, count, planes);
+			break;
+		case EPF_FLOAT3:
+			storeRowT<float, 3u>(row, image.pixelStrideInBytes, count, planes);
+			break;
+		default:
+			storeRowT<float, 4u>(row, image.pixelStrideInBytes, count, planes);
+			break;
+	}
+}
+
+// log-average luminance mapped to the exposure that brings it to middle grey, the same quantity `optixDenoiserComputeIntensity` estimates
+float computeIntensityFromImage(CThreadPool& threadPool, const SImage2D& input, SColorStatistics* rowStatistics)
+{
+	const uint32_t formatStride = getPixelFormatStride(input.format);
+	threadPool.parallelFor(input.height, [&](size_t y)
+	{
+		rowStatistics[y] = {};
+		const uint8_t* row = getRow(input, static_cast<uint32_t>(y));
+		if (input.pixelStrideInBytes == formatStride)
+		{
+			accumulateColorStatistics(input.format, row, 0ull, input.width, rowStatistics[y]);
+			return;
+		}
+
+		std::vector<uint8_t> packed(size_t(input.width) * formatStride);
+		for (uint32_t x = 0u; x < input.width; x++)
+			std::memcpy(packed.data() + size_t(x) * formatStride, row + size_t(x) * input.pixelStrideInBytes, formatStride);
+		accumulateColorStatistics(input.format, packed.data(), 0ull, input.width, rowStatistics[y]);
+	});
+
+	// merged in row order so the result doesn't depend on scheduling
+	SColorStatistics statistics;
+	for (uint32_t y = 0u; y < input.height; y++)
+		statistics.merge(rowStatistics[y]);
+	return statistics.getIntensity();
+}
+
+}
+
+std::unique_ptr<CDenoiserBackendCPU> CDenoiserBackendCPU::create(uint32_t threadCount, const SFilterParams& filterParams)
+{
+	if (filterParams.sigmaSpatial <= 0.f || filterParams.sigmaColor <= 0.f || filterParams.sigmaAlbedo <= 0.f || filterParams.sigmaNormal <= 0.f)
+		return nullptr;
+
+	return std::unique_ptr<CDenoiserBackendCPU>(new CDenoiserBackendCPU(threadCount, filterParams));
+}
+
+CDenoiserBackendCPU::CDenoiserBackendCPU(uint32_t threadCount, const SFilterParams& filterParams)
+	: m_threadPool(std::make_unique<CThreadPool>(threadCount)), m_filterParams(filterParams)
+{
+}
+
+address_t CDenoiserBackendCPU::allocate(size_t size)
+{
+	if (!size)
+		return 0ull;
+
+	void* ptr = ::operator new(size, std::align_val_t(AllocationAlignment), std::nothrow);
+	return reinterpret_cast<address_t>(ptr);
+}
+
+void CDenoiserBackendCPU::deallocate(address_t address)
+{
+	if (address)
+		::operator delete(reinterpret_cast<void*>(address), std::align_val_t(AllocationAlignment));
+}
+
+void* CDenoiserBackendCPU::allocateHost(size_t size)
+{
+	// "device" memory already is host memory
+	return reinterpret_cast<void*>(allocate(size));
+}
+
+void CDenoiserBackendCPU::deallocateHost(void* ptr)
+{
+	deallocate(reinterpret_cast<address_t>(ptr));
+}
+
+bool CDenoiserBackendCPU::copyHostToDevice(address_t dst, const void* src, size_t size)
+{
+	if (!dst || !src)
+		return false;
+
+	std::memcpy(reinterpret_cast<void*>(dst), src, size);
+	return true;
+}
+
+bool CDenoiserBackendCPU::copyDeviceToHost(void* dst, address_t src, size_t size)
+{
+	if (!dst || !src)
+		return false;
+
+	std::memcpy(dst, reinterpret_cast<const void*>(src), size);
+	return true;
+}
+
+size_t CDenoiserBackendCPU::getAvailableMemory() const
+{
+	return getAvailableHostMemory();
+}
+
+denoiser_t CDenoiserBackendCPU::createDenoiser(E_MODEL_KIND model, E_INPUT_KIND inputKind)
+{
+	auto& denoiser = m_denoisers.emplace_back(std::make_unique<SDenoiser>());
+	denoiser->model = model;
+	denoiser->inputKind = inputKind;
+	return reinterpret_cast<denoiser_t>(denoiser.get());
+}
+
+size_t CDenoiserBackendCPU::getScratchSliceSize(uint32_t tileWidth) const
+{
+	const size_t apron = m_filterParams.radius * 2u;
+	// 12 planes of the band with its apron: color, tonemapped color, albedo, normal; plus 4 accumulator rows
+	const size_t planeFloats = (tileWidth + apron) * (BandHeight + apron) * 12ull + tileWidth * 4ull;
+	// column remapping table
+	const size_t columnBytes = (tileWidth + apron) * sizeof(uint32_t);
+	const size_t bytes = planeFloats * sizeof(float) + columnBytes;
+	return (bytes + AllocationAlignment - 1ull) / AllocationAlignment * AllocationAlignment;
+}
+
+bool CDenoiserBackendCPU::computeMemoryRequirements(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements) const
+{
+	if (!denoiser || !tileWidth || !tileHeight)
+		return false;
+
+	outRequirements.stateSizeInBytes = 0ull;
+	outRequirements.scratchSizeInBytes = getScratchSliceSize(tileWidth) * getScratchSliceCount();
+	outRequirements.overlapWindowSizeInPixels = m_filterParams.radius;
+	return true;
+}
+
+bool CDenoiserBackendCPU::setup(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, address_t /*state*/, size_t /*stateSize*/, address_t scratch, size_t scratchSize)
+{
+	SDenoiserMemoryRequirements requirements;
+	if (!computeMemoryRequirements(denoiser, tileWidth, tileHeight, requirements))
+		return false;
+	if (scratchSize < requirements.scratchSizeInBytes || !scratch)
+		return false;
+
+	getDenoiser(denoiser)->setupTileWidth = tileWidth;
+	getDenoiser(denoiser)->setupTileHeight = tileHeight;
+
+	std::lock_guard<std::mutex> lock(m_sliceMutex);
+	m_freeSlices.resize(getScratchSliceCount());
+	for (uint32_t i = 0u; i < m_freeSlices.size(); i++)
+		m_freeSlices[i] = i;
+	return true;
+}
+
+size_t CDenoiserBackendCPU::getIntensityScratchSize(uint32_t /*width*/, uint32_t height) const
+{
+	return sizeof(SColorStatistics) * size_t(height);
+}
+
+bool CDenoiserBackendCPU::computeIntensity(denoiser_t denoiser, const SImage2D& input, address_t outIntensity, address_t scratch, size_t scratchSize)
+{
+	if (!denoiser || !outIntensity || !input.data)
+		return false;
+	if (scratchSize < getIntensityScratchSize(input.width, input.height))
+		return false;
+
+	SColorStatistics* rowStatistics = reinterpret_cast<SColorStatistics*>(scratch);
+	*reinterpret_cast<float*>(outIntensity) = computeIntensityFromImage(*m_threadPool, input, rowStatistics);
+	return true;
+}
+
+bool CDenoiserBackendCPU::invokeTiled(
+	denoiser_t denoiser,
+	const SDenoiserParams& params,
+	address_t /*state*/, size_t /*stateSize*/,
+	const SImage2D* inputs, uint32_t inputCount,
+	const SImage2D& output,
+	address_t scratch, size_t scratchSize,
+	uint32_t overlap, uint32_t tileWidth, uint32_t tileHeight)
+{
+	if (!denoiser)
+		return false;
+	const SDenoiser& instance = *getDenoiser(denoiser);
+	if (!inputCount || inputCount < instance.inputKind)
+		return false;
+	// same restriction as OptiX, setup has to have been done for the tile size
+	if (tileWidth > instance.setupTileWidth || tileHeight > instance.setupTileHeight || !tileWidth || !tileHeight)
+		return false;
+	for (uint32_t k = 0u; k < inputCount; k++)
+	if (inputs[k].width != output.width || inputs[k].height != output.height)
+		return false;
+
+	const SImage2D& color = inputs[0];
+	const bool hasAlbedo = instance.inputKind >= EIK_RGB_ALBEDO;
+	const bool hasNormal = instance.inputKind >= EIK_RGB_ALBEDO_NORMAL;
+
+	float intensity = 1.f;
+	if (instance.model == EMK_HDR)
+	{
+		if (params.hdrIntensity)
+			intensity = *reinterpret_cast<const float*>(params.hdrIntensity);
+		else
+		{
+			std::vector<SColorStatistics> rowStatistics(color.height);
+			intensity = computeIntensityFromImage(*m_threadPool, color, rowStatistics.data());
+		}
+	}
+
+	const uint32_t radius = m_filterParams.radius;
+	const int32_t iRadius = static_cast<int32_t>(radius);
+	const float invColor = 0.5f / (m_filterParams.sigmaColor * m_filterParams.sigmaColor);
+	const float invAlbedo = hasAlbedo ? 0.5f / (m_filterParams.sigmaAlbedo * m_filterParams.sigmaAlbedo) : 0.f;
+	const float invNormal = hasNormal ? 1.f / m_filterParams.sigmaNormal : 0.f;
+
+	std::vector<float> spatialTerms((radius * 2u + 1u) * (radius * 2u + 1u));
+	for (int32_t dy = -iRadius; dy <= iRadius; dy++)
+	for (int32_t dx = -iRadius; dx <= iRadius; dx++)
+		spatialTerms[(dy + iRadius) * (radius * 2u + 1u) + dx + iRadius] = -float(dx * dx + dy * dy) * 0.5f / (m_filterParams.sigmaSpatial * m_filterParams.sigmaSpatial);
+
+	const uint32_t tileCountX = (output.width + tileWidth - 1u) / tileWidth;
+	const uint32_t tileCountY = (output.height + tileHeight - 1u) / tileHeight;
+	const uint32_t bandsPerTile = (tileHeight + BandHeight - 1u) / BandHeight;
+
+	const size_t sliceSize = getScratchSliceSize(instance.setupTileWidth);
+	if (scratchSize < sliceSize * getScratchSliceCount())
+		return false;
+
+	m_threadPool->parallelFor(size_t(tileCountX) * tileCountY * bandsPerTile, [&](size_t task)
+	{
+		const uint32_t band = static_cast<uint32_t>(task % bandsPerTile);
+		const uint32_t tile = static_cast<uint32_t>(task / bandsPerTile);
+		const uint32_t tileX = (tile % tileCountX) * tileWidth;
+		const uint32_t tileY = (tile / tileCountX) * tileHeight;
+
+		// interior of this task
+		const uint32_t x0 = tileX;
+		const uint32_t x1 = std::min(tileX + tileWidth, output.width);
+		const uint32_t y0 = tileY + band * BandHeight;
+		const uint32_t y1 = std::min(std::min(y0 + BandHeight, tileY + tileHeight), output.height);
+		if (y0 >= y1)
+			return;
+		const uint32_t width = x1 - x0;
+		const uint32_t height = y1 - y0;
+
+		// the filter only sees what the tile with its overlap would see, replicating the border beyond that
+		const int32_t visibleX0 = std::max<int32_t>(int32_t(tileX) - int32_t(overlap), 0);
+		const int32_t visibleY0 = std::max<int32_t>(int32_t(tileY) - int32_t(overlap), 0);
+		const int32_t visibleX1 = std::min<int32_t>(int32_t(x1 + overlap), int32_t(output.width)) - 1;
+		const int32_t visibleY1 = std::min<int32_t>(int32_t(std::min(tileY + tileHeight, output.height) + overlap), int32_t(output.height)) - 1;
+
+		uint32_t slice;
+		{
+			std::lock_guard<std::mutex> lock(m_sliceMutex);
+			assert(!m_freeSlices.empty()); // more concurrent tasks than threads in the pool?
+			slice = m_freeSlices.back();
+			m_freeSlices.pop_back();
+		}
+
+		const uint32_t regionWidth = width + radius * 2u;
+		const uint32_t regionHeight = height + radius * 2u;
+		const size_t planeSize = size_t(regionWidth) * regionHeight;
+
+		float* planeMemory = reinterpret_cast<float*>(scratch + sliceSize * slice);
+		float* colorPlanes[4] = { planeMemory, planeMemory + planeSize, planeMemory + planeSize * 2u, nullptr };
+		float* mappedPlanes[3] = { planeMemory + planeSize * 3u, planeMemory + planeSize * 4u, planeMemory + planeSize * 5u };
+		float* albedoPlanes[3] = { planeMemory + planeSize * 6u, planeMemory + planeSize * 7u, planeMemory + planeSize * 8u };
+		float* normalPlanes[3] = { planeMemory + planeSize * 9u, planeMemory + planeSize * 10u, planeMemory + planeSize * 11u };
+		float* accumulators = planeMemory + planeSize * 12u;
+		uint32_t* columns = reinterpret_cast<uint32_t*>(accumulators + size_t(instance.setupTileWidth) * 4u);
+
+		for (uint32_t i = 0u; i < regionWidth; i++)
+			columns[i] = static_cast<uint32_t>(std::clamp<int32_t>(int32_t(x0 + i) - iRadius, visibleX0, visibleX1));
+
+		for (uint32_t j = 0u; j < regionHeight; j++)
+		{
+			const uint32_t sy = static_cast<uint32_t>(std::clamp<int32_t>(int32_t(y0 + j) - iRadius, visibleY0, visibleY1));
+			const size_t offset = size_t(j) * regionWidth;
+
+			float* rowColor[3] = { colorPlanes[0] + offset, colorPlanes[1] + offset, colorPlanes[2] + offset };
+			loadRow(color, sy, columns, regionWidth, rowColor, 3u);
+			for (uint32_t c = 0u; c < 3u; c++)
+			{
+				const float* src = rowColor[c];
+				float* dst = mappedPlanes[c] + offset;
+				if (instance.model == EMK_HDR)
+				{
+					for (uint32_t i = 0u; i < regionWidth; i++)
+					{
+						const float v = std::max(src[i], 0.f) * intensity;
+						dst[i] = v / (1.f + v);
+					}
+				}
+				else
+					std::copy(src, src + regionWidth, dst);
+			}
+
+			float* rowAlbedo[3] = { albedoPlanes[0] + offset, albedoPlanes[1] + offset, albedoPlanes[2] + offset };
+			float* rowNormal[3] = { normalPlanes[0] + offset, normalPlanes[1] + offset, normalPlanes[2] + offset };
+			if (hasAlbedo)
+				loadRow(inputs[1], sy, columns, regionWidth, rowAlbedo, 3u);
+			else
+			for (auto* plane : rowAlbedo)
+				std::fill_n(plane, regionWidth, 0.f);
+			if (hasNormal)
+				loadRow(inputs[2], sy, columns, regionWidth, rowNormal, 3u);
+			else
+			for (auto* plane : rowNormal)
+				std::fill_n(plane, regionWidth, 0.f);
+		}
+
+		float* accR = accumulators;
+		float* accG = accumulators + width;
+		float* accB = accumulators + width * 2u;
+		float* accW = accumulators + width * 3u;
+		for (uint32_t y = 0u; y < height; y++)
+		{
+			std::fill_n(accumulators, width * 4u, 0.f);
+
+			const size_t centerOffset = size_t(y + radius) * regionWidth + radius;
+			const float* cR = mappedPlanes[0] + centerOffset;
+			const float* cG = mappedPlanes[1] + centerOffset;
+			const float* cB = mappedPlanes[2] + centerOffset;
+			const float* aR = albedoPlanes[0] + centerOffset;
+			const float* aG = albedoPlanes[1] + centerOffset;
+			const float* aB = albedoPlanes[2] + centerOffset;
+			const float* nX = normalPlanes[0] + centerOffset;
+			const float* nY = normalPlanes[1] + centerOffset;
+			const float* nZ = normalPlanes[2] + centerOffset;
+
+			for (int32_t dy = -iRadius; dy <= iRadius; dy++)
+			for (int32_t dx = -iRadius; dx <= iRadius; dx++)
+			{
+				const float spatialTerm = spatialTerms[(dy + iRadius) * (radius * 2u + 1u) + dx + iRadius];
+				const ptrdiff_t tapOffset = ptrdiff_t(centerOffset) + ptrdiff_t(dy) * regionWidth + dx;
+				const float* qR = mappedPlanes[0] + tapOffset;
+				const float* qG = mappedPlanes[1] + tapOffset;
+				const float* qB = mappedPlanes[2] + tapOffset;
+				const float* qaR = albedoPlanes[0] + tapOffset;
+				const float* qaG = albedoPlanes[1] + tapOffset;
+				const float* qaB = albedoPlanes[2] + tapOffset;
+				const float* qnX = normalPlanes[0] + tapOffset;
+				const float* qnY = normalPlanes[1] + tapOffset;
+				const float* qnZ = normalPlanes[2] + tapOffset;
+				const float* vR = colorPlanes[0] + tapOffset;
+				const float* vG = colorPlanes[1] + tapOffset;
+				const float* vB = colorPlanes[2] + tapOffset;
+
+				for (uint32_t x = 0u; x < width; x++)
+				{
+					const float dcR = cR[x] - qR[x], dcG = cG[x] - qG[x], dcB = cB[x] - qB[x];
+					const float daR = aR[x] - qaR[x], daG = aG[x] - qaG[x], daB = aB[x] - qaB[x];
+					const float normalDot = nX[x] * qnX[x] + nY[x] * qnY[x] + nZ[x] * qnZ[x];
+					const float exponent = spatialTerm
+						- (dcR * dcR + dcG * dcG + dcB * dcB) * invColor
+						- (daR * daR + daG * daG + daB * daB) * invAlbedo
+						- std::max(1.f - normalDot, 0.f) * invNormal;
+					const float weight = fastNegExp(exponent);
+					accR[x] += weight * vR[x];
+					accG[x] += weight * vG[x];
+					accB[x] += weight * vB[x];
+					accW[x] += weight;
+				}
+			}
+
+			// the center tap always has a weight of 1, so there's no division by zero
+			const size_t inputOffset = size_t(y + radius) * regionWidth + radius;
+			const float blend = params.blendFactor;
+			for (uint32_t x = 0u; x < width; x++)
+			{
+				const float invWeight = (1.f - blend) / accW[x];
+				accR[x] = accR[x] * invWeight + colorPlanes[0][inputOffset + x] * blend;
+				accG[x] = accG[x] * invWeight + colorPlanes[1][inputOffset + x] * blend;
+				accB[x] = accB[x] * invWeight + colorPlanes[2][inputOffset + x] * blend;
+			}
+
+			// alpha is passed through from the color input like OptiX does without `denoiseAlpha`,
+			// all channels land in the weight row and the last one written per pixel is alpha (or 1 for RGB inputs)
+			if (getPixelFormatChannelCount(output.format) == 4u)
+			{
+				float* alphaPlanes[4] = { accW, accW, accW, accW };
+				loadRow(color, y0 + y, columns + radius, width, alphaPlanes, 4u);
+			}
+			const float* outPlanes[4] = { accR, accG, accB, accW };
+			storeRow(output, x0, y0 + y, width, outPlanes);
+		}
+
+		std::lock_guard<std::mutex> lock(m_sliceMutex);
+		m_freeSlices.push_back(slice);
+	});
+
+	return true;
+}
+
+void CDenoiserBackendCPU::destroyDenoiser(denoiser_t denoiser)
+{
+	m_denoisers.erase(std::remove_if(m_denoisers.begin(), m_denoisers.end(), [denoiser](const auto& instance) { return reinterpret_cast<denoiser_t>(instance.get()) == denoiser; }), m_denoisers.end());
+}
@@ -0,0 +1,104 @@
+#ifndef __DBR_C_DENOISER_BACKEND_CPU_H_INCLUDED__
+#define __DBR_C_DENOISER_BACKEND_CPU_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+#include "core/CThreadPool.h"
+
+#include <mutex>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	Reference denoiser for machines without a GPU, a cross-bilateral filter guided by the albedo and normal layers.
+
+	It is nowhere near the quality of the AI denoiser, its purpose is to exercise every other part of the harness
+	(loading, conversion, tiling, saving) with realistic memory traffic and a compute cost that scales with the image.
+	"Device" memory is plain aligned host memory, so the copies are `memcpy`s.
+*/
+class CDenoiserBackendCPU final : public IDenoiserBackend
+{
+	public:
+		struct SFilterParams
+		{
+			uint32_t radius = 3u;
+			float sigmaSpatial = 2.f;
+			float sigmaColor = 0.3f; //!< in tonemapped [0,1) space
+			float sigmaAlbedo = 0.1f;
+			float sigmaNormal = 0.1f; //!< on `1-dot(n0,n1)`
+		};
+
+		//! `threadCount == 0` uses all hardware threads
+		static std::unique_ptr<CDenoiserBackendCPU> create(uint32_t threadCount, const SFilterParams& filterParams);
+		static inline std::unique_ptr<CDenoiserBackendCPU> create(uint32_t threadCount = 0u)
+		{
+			return create(threadCount, SFilterParams());
+		}
+
+		~CDenoiserBackendCPU() override = default;
+
+		std::string_view getName() const override { return "cpu"; }
+
+		address_t allocate(size_t size) override;
+		void deallocate(address_t address) override;
+		bool copyHostToDevice(address_t dst, const void* src, size_t size) override;
+		bool copyDeviceToHost(void* dst, address_t src, size_t size) override;
+		bool synchronize() override { return true; }
+		void* allocateHost(size_t size) override;
+		void deallocateHost(void* ptr) override;
+		size_t getAvailableMemory() const override;
+
+		denoiser_t createDenoiser(E_MODEL_KIND model, E_INPUT_KIND inputKind) override;
+		bool computeMemoryRequirements(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements) const override;
+		bool setup(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, address_t state, size_t stateSize, address_t scratch, size_t scratchSize) override;
+
+		size_t getIntensityScratchSize(uint32_t width, uint32_t height) const override;
+		bool computeIntensity(denoiser_t denoiser, const SImage2D& input, address_t outIntensity, address_t scratch, size_t scratchSize) override;
+
+		bool invokeTiled(
+			denoiser_t denoiser,
+			const SDenoiserParams& params,
+			address_t state, size_t stateSize,
+			const SImage2D* inputs, uint32_t inputCount,
+			const SImage2D& output,
+			address_t scratch, size_t scratchSize,
+			uint32_t overlap, uint32_t tileWidth, uint32_t tileHeight
+		) override;
+
+		void destroyDenoiser(denoiser_t denoiser) override;
+
+		inline CThreadPool& getThreadPool() { return *m_threadPool; }
+		inline const SFilterParams& getFilterParams() const { return m_filterParams; }
+
+	private:
+		CDenoiserBackendCPU(uint32_t threadCount, const SFilterParams& filterParams);
+
+		// every worker filters one band of rows of a tile at a time, in its own slice of the scratch memory
+		static constexpr uint32_t BandHeight = 32u;
+
+		size_t getScratchSliceSize(uint32_t tileWidth) const;
+		inline uint32_t getScratchSliceCount() const { return m_threadPool->getThreadCount() + 1u; }
+
+		//! What a `denoiser_t` of this backend points to
+		struct SDenoiser
+		{
+			E_MODEL_KIND model = EMK_HDR;
+			E_INPUT_KIND inputKind = EIK_RGB;
+			uint32_t setupTileWidth = 0u;
+			uint32_t setupTileHeight = 0u;
+		};
+		static inline SDenoiser* getDenoiser(denoiser_t denoiser) { return reinterpret_cast<SDenoiser*>(denoiser); }
+
+		std::unique_ptr<CThreadPool> m_threadPool;
+		const SFilterParams m_filterParams;
+
+		std::vector<std::unique_ptr<SDenoiser>> m_denoisers;
+
+		std::mutex m_sliceMutex;
+		std::vector<uint32_t> m_freeSlices;
+};
+
+}
+
+#endif // __DBR_C_DENOISER_BACKEND_CPU_H_INCLUDED__
@@ -0,0 +1,294 @@
+#include "denoiser/CDenoiserBackendOptiX.h"
+#include "denoiser/OptiXCheck.h"
+
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+
+#include <optix_stubs.h>
+#include <optix_function_table_definition.h>
+#include <optix_denoiser_tiling.h>
+
+using namespace dbr;
+
+namespace
+{
+
+void DBROptixDefaultCallback(unsigned int level, const char* tag, const char* message, void* cbdata)
+{
+	uint32_t contextID = reinterpret_cast<const uint32_t&>(cbdata);
+	printf("OptiX Context:%d [%s]: %s\n", contextID, tag, message);
+}
+
+OptixPixelFormat getOptiXPixelFormat(const E_PIXEL_FORMAT format)
+{
+	switch (format)
+	{
+		case EPF_HALF3:
+			return OPTIX_PIXEL_FORMAT_HALF3;
+		case EPF_HALF4:
+			return OPTIX_PIXEL_FORMAT_HALF4;
+		case EPF_FLOAT3:
+			return OPTIX_PIXEL_FORMAT_FLOAT3;
+		default:
+			return OPTIX_PIXEL_FORMAT_FLOAT4;
+	}
+}
+
+OptixImage2D getOptiXImage(const SImage2D& image)
+{
+	OptixImage2D retval;
+	retval.data = image.data;
+	retval.width = image.width;
+	retval.height = image.height;
+	retval.rowStrideInBytes = image.rowStrideInBytes;
+	retval.pixelStrideInBytes = image.pixelStrideInBytes;
+	retval.format = getOptiXPixelFormat(image.format);
+	return retval;
+}
+
+}
+
+std::unique_ptr<CDenoiserBackendOptiX> CDenoiserBackendOptiX::create(int deviceOrdinal)
+{
+	if (!CU_CHECK(cuInit(0)) || !OPTIX_CHECK(optixInit()))
+		return nullptr;
+
+	CUdevice device;
+	if (!CU_CHECK(cuDeviceGet(&device, deviceOrdinal)))
+		return nullptr;
+
+	std::unique_ptr<CDenoiserBackendOptiX> retval(new CDenoiserBackendOptiX());
+
+	// create context
+	if (!CU_CHECK(cuCtxCreate_v2(&retval->m_context, CU_CTX_SCHED_YIELD | CU_CTX_MAP_HOST | CU_CTX_LMEM_RESIZE_TO_MAX, device)))
+		return nullptr;
+	{
+		uint32_t version = 0u;
+
+		CU_CHECK(cuCtxGetApiVersion(retval->m_context, &version));
+
+		if (version < 3020)
+			return nullptr;
+
+		CU_CHECK(cuCtxSetCacheConfig(CU_FUNC_CACHE_PREFER_L1));
+	}
+
+	if (!CU_CHECK(cuStreamCreate(&retval->m_stream, CU_STREAM_NON_BLOCKING)))
+		return nullptr;
+
+	/*
+		Init Optix Context
+	*/
+
+	if (!OPTIX_CHECK(optixDeviceContextCreate(retval->m_context, {}, &retval->m_optixContext)))
+		return nullptr;
+	OPTIX_CHECK(optixDeviceContextSetLogCallback(retval->m_optixContext, DBROptixDefaultCallback, reinterpret_cast<void*>(retval->m_context), 3));
+
+	return retval;
+}
+
+CDenoiserBackendOptiX::~CDenoiserBackendOptiX()
+{
+	if (m_context)
+		cuCtxSetCurrent(m_context);
+
+	for (OptixDenoiser denoiser : m_denoisers)
+		optixDenoiserDestroy(denoiser);
+	m_denoisers.clear();
+	if (m_optixContext)
+		optixDeviceContextDestroy(m_optixContext);
+	if (m_stream)
+		cuStreamDestroy_v2(m_stream);
+	if (m_context)
+		cuCtxDestroy_v2(m_context);
+}
+
+address_t CDenoiserBackendOptiX::allocate(size_t size)
+{
+	CUdeviceptr retval = 0ull;
+	if (!CU_CHECK(cuCtxSetCurrent(m_context)) || !CU_CHECK(cuMemAlloc(&retval, size)))
+		return 0ull;
+	return retval;
+}
+
+void CDenoiserBackendOptiX::deallocate(address_t address)
+{
+	if (!address)
+		return;
+
+	CU_CHECK(cuCtxSetCurrent(m_context));
+	CU_CHECK(cuMemFree(address));
+}
+
+// on the denoiser stream, the legacy stream synchronous copies aren't ordered with the non blocking stream the denoiser runs on
+bool CDenoiserBackendOptiX::copyHostToDevice(address_t dst, const void* src, size_t size)
+{
+	return CU_CHECK(cuCtxSetCurrent(m_context)) && CU_CHECK(cuMemcpyHtoDAsync_v2(dst, src, size, m_stream));
+}
+
+bool CDenoiserBackendOptiX::copyDeviceToHost(void* dst, address_t src, size_t size)
+{
+	return CU_CHECK(cuCtxSetCurrent(m_context)) && CU_CHECK(cuMemcpyDtoHAsync_v2(dst, src, size, m_stream));
+}
+
+bool CDenoiserBackendOptiX::synchronize()
+{
+	return CU_CHECK(cuCtxSetCurrent(m_context)) && CU_CHECK(cuStreamSynchronize(m_stream));
+}
+
+void* CDenoiserBackendOptiX::allocateHost(size_t size)
+{
+	// page locked memory lets the copy engine DMA straight from it, instead of going through a driver bounce buffer
+	void* retval = nullptr;
+	if (!size || !CU_CHECK(cuCtxSetCurrent(m_context)) || !CU_CHECK(cuMemHostAlloc(&retval, size, CU_MEMHOSTALLOC_PORTABLE)))
+		return nullptr;
+	return retval;
+}
+
+void CDenoiserBackendOptiX::deallocateHost(void* ptr)
+{
+	if (!ptr)
+		return;
+
+	CU_CHECK(cuCtxSetCurrent(m_context));
+	CU_CHECK(cuMemFreeHost(ptr));
+}
+
+size_t CDenoiserBackendOptiX::getAvailableMemory() const
+{
+	size_t freeMemory = 0ull, totalMemory = 0ull;
+	if (!CU_CHECK(cuCtxSetCurrent(m_context)) || !CU_CHECK(cuMemGetInfo_v2(&freeMemory, &totalMemory)))
+		return 0ull;
+	return freeMemory;
+}
+
+/*
+	Creating Denoisers
+*/
+
+denoiser_t CDenoiserBackendOptiX::createDenoiser(E_MODEL_KIND model, E_INPUT_KIND inputKind)
+{
+	OptixDenoiserOptions options = {};
+	switch (inputKind)
+	{
+		case EIK_RGB:
+			options.inputKind = OPTIX_DENOISER_INPUT_RGB;
+			break;
+		case EIK_RGB_ALBEDO:
+			options.inputKind = OPTIX_DENOISER_INPUT_RGB_ALBEDO;
+			break;
+		default:
+			options.inputKind = OPTIX_DENOISER_INPUT_RGB_ALBEDO_NORMAL;
+			break;
+	}
+
+	OptixDenoiser denoiser = nullptr;
+	if (!CU_CHECK(cuCtxSetCurrent(m_context)) || !OPTIX_CHECK(optixDenoiserCreate(m_optixContext, &options, &denoiser)))
+		return 0ull;
+
+	if (!denoiser)
+		return 0ull;
+
+	const auto modelKind = model == EMK_LDR ? OPTIX_DENOISER_MODEL_KIND_LDR : OPTIX_DENOISER_MODEL_KIND_HDR;
+	if (optixDenoiserSetModel(denoiser, modelKind, nullptr, 0ull) != OPTIX_SUCCESS)
+	{
+		OPTIX_CHECK(optixDenoiserDestroy(denoiser));
+		return 0ull;
+	}
+
+	m_denoisers.push_back(denoiser);
+	return reinterpret_cast<denoiser_t>(denoiser);
+}
+
+bool CDenoiserBackendOptiX::computeMemoryRequirements(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements) const
+{
+	if (!denoiser)
+		return false;
+
+	OptixDenoiserSizes denoiserMemReqs;
+	if (!CU_CHECK(cuCtxSetCurrent(m_context)) || !OPTIX_CHECK(optixDenoiserComputeMemoryResources(getOptiXDenoiser(denoiser), tileWidth, tileHeight, &denoiserMemReqs)))
+		return false;
+
+	outRequirements.stateSizeInBytes = denoiserMemReqs.stateSizeInBytes;
+	outRequirements.scratchSizeInBytes = denoiserMemReqs.withOverlapScratchSizeInBytes;
+	outRequirements.overlapWindowSizeInPixels = denoiserMemReqs.overlapWindowSizeInPixels;
+	return true;
+}
+
+bool CDenoiserBackendOptiX::setup(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, address_t state, size_t stateSize, address_t scratch, size_t scratchSize)
+{
+	if (!denoiser)
+		return false;
+
+	return CU_CHECK(cuCtxSetCurrent(m_context)) && OPTIX_CHECK(optixDenoiserSetup(getOptiXDenoiser(denoiser), m_stream, tileWidth, tileHeight, state, stateSize, scratch, scratchSize));
+}
+
+size_t CDenoiserBackendOptiX::getIntensityScratchSize(uint32_t width, uint32_t height) const
+{
+	// This function needs scratch memory with a size of at least sizeof(int)*(2+inputImage::width*inputImage::height)
+	return sizeof(int) * (2ull + size_t(width) * size_t(height));
+}
+
+bool CDenoiserBackendOptiX::computeIntensity(denoiser_t denoiser, const SImage2D& input, address_t outIntensity, address_t scratch, size_t scratchSize)
+{
+	if (!denoiser)
+		return false;
+
+	assert(scratchSize >= getIntensityScratchSize(input.width, input.height));
+	const OptixImage2D optixInput = getOptiXImage(input);
+	return CU_CHECK(cuCtxSetCurrent(m_context)) && OPTIX_CHECK(optixDenoiserComputeIntensity(getOptiXDenoiser(denoiser), m_stream, &optixInput, outIntensity, scratch, scratchSize));
+}
+
+bool CDenoiserBackendOptiX::invokeTiled(
+	denoiser_t denoiser,
+	const SDenoiserParams& params,
+	address_t state, size_t stateSize,
+	const SImage2D* inputs, uint32_t inputCount,
+	const SImage2D& output,
+	address_t scratch, size_t scratchSize,
+	uint32_t overlap, uint32_t tileWidth, uint32_t tileHeight)
+{
+	if (!denoiser || inputCount > EIK_RGB_ALBEDO_NORMAL)
+		return false;
+
+	OptixDenoiserParams optixDenoiserParams;
+	optixDenoiserParams.denoiseAlpha = params.denoiseAlpha ? 1u : 0u;
+	optixDenoiserParams.blendFactor = params.blendFactor;
+	optixDenoiserParams.hdrIntensity = params.hdrIntensity;
+	optixDenoiserParams.hdrAverageColor = params.hdrAverageColor;
+
+	OptixImage2D denoiserInputs[EIK_RGB_ALBEDO_NORMAL];
+	for (uint32_t k = 0u; k < inputCount; k++)
+		denoiserInputs[k] = getOptiXImage(inputs[k]);
+	const OptixImage2D denoiserOutput = getOptiXImage(output);
+
+	if (!CU_CHECK(cuCtxSetCurrent(m_context)))
+		return false;
+
+	return OPTIX_CHECK(optixUtilDenoiserInvokeTiled(
+		getOptiXDenoiser(denoiser),
+		m_stream,
+		&optixDenoiserParams,
+		state,
+		stateSize,
+		denoiserInputs,
+		inputCount,
+		&denoiserOutput,
+		scratch,
+		scratchSize,
+		overlap,
+		tileWidth,
+		tileHeight));
+}
+
+void CDenoiserBackendOptiX::destroyDenoiser(denoiser_t denoiser)
+{
+	const auto found = std::find(m_denoisers.begin(), m_denoisers.end(), getOptiXDenoiser(denoiser));
+	if (found == m_denoisers.end())
+		return;
+
+	CU_CHECK(cuCtxSetCurrent(m_context));
+	OPTIX_CHECK(optixDenoiserDestroy(*found));
+	m_denoisers.erase(found);
+}
@@ -0,0 +1,69 @@
+#ifndef __DBR_C_DENOISER_BACKEND_OPTIX_H_INCLUDED__
+#define __DBR_C_DENOISER_BACKEND_OPTIX_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <cuda.h>
+#include <optix.h>
+
+#include <vector>
+
+namespace dbr
+{
+
+//! The OptiX 7.2 AI denoiser running on a single CUDA device and stream
+class CDenoiserBackendOptiX final : public IDenoiserBackend
+{
+	public:
+		static std::unique_ptr<CDenoiserBackendOptiX> create(int deviceOrdinal = 0);
+
+		~CDenoiserBackendOptiX() override;
+
+		std::string_view getName() const override { return "optix"; }
+
+		address_t allocate(size_t size) override;
+		void deallocate(address_t address) override;
+		bool copyHostToDevice(address_t dst, const void* src, size_t size) override;
+		bool copyDeviceToHost(void* dst, address_t src, size_t size) override;
+		bool synchronize() override;
+		void* allocateHost(size_t size) override;
+		void deallocateHost(void* ptr) override;
+		size_t getAvailableMemory() const override;
+
+		denoiser_t createDenoiser(E_MODEL_KIND model, E_INPUT_KIND inputKind) override;
+		bool computeMemoryRequirements(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements) const override;
+		bool setup(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, address_t state, size_t stateSize, address_t scratch, size_t scratchSize) override;
+
+		size_t getIntensityScratchSize(uint32_t width, uint32_t height) const override;
+		bool computeIntensity(denoiser_t denoiser, const SImage2D& input, address_t outIntensity, address_t scratch, size_t scratchSize) override;
+
+		bool invokeTiled(
+			denoiser_t denoiser,
+			const SDenoiserParams& params,
+			address_t state, size_t stateSize,
+			const SImage2D* inputs, uint32_t inputCount,
+			const SImage2D& output,
+			address_t scratch, size_t scratchSize,
+			uint32_t overlap, uint32_t tileWidth, uint32_t tileHeight
+		) override;
+
+		void destroyDenoiser(denoiser_t denoiser) override;
+
+		inline CUcontext getCUDAContext() const { return m_context; }
+		inline CUstream getCUDAStream() const { return m_stream; }
+
+	private:
+		CDenoiserBackendOptiX() = default;
+
+		static inline OptixDenoiser getOptiXDenoiser(denoiser_t denoiser) { return reinterpret_cast<OptixDenoiser>(denoiser); }
+
+		CUcontext m_context = nullptr;
+		CUstream m_stream = nullptr;
+		OptixDeviceContext m_optixContext = nullptr;
+		//! every denoiser still alive, so none outlive the context
+		std::vector<OptixDenoiser> m_denoisers;
+};
+
+}
+
+#endif // __DBR_C_DENOISER_BACKEND_OPTIX_H_INCLUDED__
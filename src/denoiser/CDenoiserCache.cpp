@@ -0,0 +1,201 @@
+#include "denoiser/CDenoiserCache.h"
+
+#include <cassert>
+#include <algorithm>
+
+using namespace dbr;
+
+namespace
+{
+
+inline bool isSameDenoiserKind(const CDenoiserCache::SKey& a, const CDenoiserCache::SKey& b)
+{
+	return a.model == b.model && a.inputKind == b.inputKind;
+}
+
+}
+
+CDenoiserCache::CDenoiserCache(IDenoiserBackend* backend, size_t memoryCap) : m_backend(backend), m_memoryCap(memoryCap)
+{
+	assert(m_backend);
+}
+
+CDenoiserCache::~CDenoiserCache()
+{
+	while (!m_entries.empty())
+		destroy(m_entries.begin());
+	for (const auto& spare : m_spareDenoisers)
+		m_backend->destroyDenoiser(spare.second);
+}
+
+bool CDenoiserCache::getMemoryRequirements(const SKey& key, SDenoiserMemoryRequirements& outRequirements)
+{
+	const auto found = m_requirements.find(key);
+	if (found != m_requirements.end())
+	{
+		outRequirements = found->second;
+		return true;
+	}
+
+	// any denoiser of the same kind can be asked, whatever it's set up for
+	denoiser_t denoiser = 0ull;
+	for (const SEntry& entry : m_entries)
+	if (isSameDenoiserKind(entry.instance.key, key))
+		denoiser = entry.instance.denoiser;
+	for (const auto& spare : m_spareDenoisers)
+	if (isSameDenoiserKind(spare.first, key))
+		denoiser = spare.second;
+	if (!denoiser)
+	{
+		denoiser = m_backend->createDenoiser(key.model, key.inputKind);
+		if (!denoiser)
+			return false;
+		m_spareDenoisers.emplace_back(SKey{ key.model,key.inputKind,0u,0u }, denoiser);
+	}
+
+	if (!m_backend->computeMemoryRequirements(denoiser, key.tileWidth, key.tileHeight, outRequirements))
+		return false;
+	m_requirements[key] = outRequirements;
+	return true;
+}
+
+const CDenoiserCache::SInstance* CDenoiserCache::acquire(const SKey& key)
+{
+	for (SEntry& entry : m_entries)
+	if (!entry.inUse && entry.instance.key == key)
+	{
+		entry.inUse = true;
+		entry.lastUse = ++m_useCounter;
+		m_statistics.hits++;
+		return &entry.instance;
+	}
+	m_statistics.misses++;
+
+	SDenoiserMemoryRequirements requirements;
+	if (!getMemoryRequirements(key, requirements))
+		return nullptr;
+
+	SEntry entry;
+	entry.instance.key = key;
+	entry.instance.stateSize = requirements.stateSizeInBytes;
+	entry.instance.scratchSize = requirements.scratchSizeInBytes;
+	entry.instance.overlapWindowSizeInPixels = requirements.overlapWindowSizeInPixels;
+	entry.instance.denoiser = takeDenoiser(key);
+	if (!entry.instance.denoiser)
+		return nullptr;
+
+	auto allocate = [this](SInstance& instance) -> bool
+	{
+		instance.state = m_backend->allocate(instance.stateSize);
+		instance.scratch = m_backend->allocate(instance.scratchSize);
+		return (instance.state || !instance.stateSize) && (instance.scratch || !instance.scratchSize);
+	};
+	auto deallocate = [this](SInstance& instance) -> void
+	{
+		m_backend->deallocate(instance.state);
+		m_backend->deallocate(instance.scratch);
+		instance.state = instance.scratch = 0ull;
+	};
+	// what idle instances hold might be exactly what's missing
+	if (!allocate(entry.instance))
+	{
+		deallocate(entry.instance);
+		trim(0ull);
+		if (!allocate(entry.instance))
+		{
+			deallocate(entry.instance);
+			m_backend->destroyDenoiser(entry.instance.denoiser);
+			return nullptr;
+		}
+	}
+
+	const SInstance& instance = entry.instance;
+	if (!m_backend->setup(instance.denoiser, key.tileWidth, key.tileHeight, instance.state, instance.stateSize, instance.scratch, instance.scratchSize))
+	{
+		deallocate(entry.instance);
+		m_backend->destroyDenoiser(entry.instance.denoiser);
+		return nullptr;
+	}
+
+	entry.inUse = true;
+	entry.lastUse = ++m_useCounter;
+	m_memoryConsumption += instance.getMemoryConsumption();
+	m_entries.push_back(entry);
+	return &m_entries.back().instance;
+}
+
+void CDenoiserCache::release(const SInstance* instance)
+{
+	if (!instance)
+		return;
+
+	for (SEntry& entry : m_entries)
+	if (&entry.instance == instance)
+	{
+		assert(entry.inUse);
+		entry.inUse = false;
+		entry.lastUse = ++m_useCounter;
+		break;
+	}
+	trim(m_memoryCap);
+}
+
+void CDenoiserCache::trim(size_t memoryCap)
+{
+	size_t idle = getIdleMemoryConsumption();
+	while (idle > memoryCap)
+	{
+		const auto candidate = findEvictionCandidate();
+		if (candidate == m_entries.end())
+			break;
+
+		idle -= candidate->instance.getMemoryConsumption();
+		destroy(candidate);
+		m_statistics.evictions++;
+	}
+}
+
+size_t CDenoiserCache::getIdleMemoryConsumption() const
+{
+	size_t retval = 0ull;
+	for (const SEntry& entry : m_entries)
+	if (!entry.inUse)
+		retval += entry.instance.getMemoryConsumption();
+	return retval;
+}
+
+denoiser_t CDenoiserCache::takeDenoiser(const SKey& key)
+{
+	const auto spare = std::find_if(m_spareDenoisers.begin(), m_spareDenoisers.end(), [&key](const auto& candidate) { return isSameDenoiserKind(candidate.first, key); });
+	if (spare == m_spareDenoisers.end())
+		return m_backend->createDenoiser(key.model, key.inputKind);
+
+	const denoiser_t retval = spare->second;
+	m_spareDenoisers.erase(spare);
+	return retval;
+}
+
+void CDenoiserCache::destroy(std::list<SEntry>::iterator entry)
+{
+	SInstance& instance = entry->instance;
+	m_backend->deallocate(instance.state);
+	m_backend->deallocate(instance.scratch);
+	m_memoryConsumption -= instance.getMemoryConsumption();
+
+	// creating the denoiser is the expensive part, so one per kind survives to be set up again
+	const bool spareExists = std::any_of(m_spareDenoisers.begin(), m_spareDenoisers.end(), [&instance](const auto& spare) { return isSameDenoiserKind(spare.first, instance.key); });
+	if (spareExists)
+		m_backend->destroyDenoiser(instance.denoiser);
+	else
+		m_spareDenoisers.emplace_back(SKey{ instance.key.model,instance.key.inputKind,0u,0u }, instance.denoiser);
+	m_entries.erase(entry);
+}
+
+std::list<CDenoiserCache::SEntry>::iterator CDenoiserCache::findEvictionCandidate()
+{
+	auto retval = m_entries.end();
+	for (auto it = m_entries.begin(); it != m_entries.end(); it++)
+	if (!it->inUse && (retval == m_entries.end() || it->lastUse < retval->lastUse))
+		retval = it;
+	return retval;
+}
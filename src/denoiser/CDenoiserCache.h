@@ -0,0 +1,119 @@
+#ifndef __DBR_C_DENOISER_CACHE_H_INCLUDED__
+#define __DBR_C_DENOISER_CACHE_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <list>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	Denoisers that are set up and ready to invoke, together with their state and scratch, for every tile shape used recently.
+
+	Creating a denoiser, querying its memory requirements and setting it up for a tile size all cost a lot more than
+	a denoising pass on a preview sized frame, so a job alternating between resolutions would otherwise pay them every frame.
+	Instances nobody uses any more are kept until the memory they hold exceeds the cap, then the least recently used go first.
+	The denoiser of an evicted instance is kept around to be set up again for the next tile shape of the same model and input kind.
+
+	Not thread safe, like the backend it wraps.
+*/
+class CDenoiserCache
+{
+	public:
+		struct SKey
+		{
+			E_MODEL_KIND model = EMK_HDR;
+			E_INPUT_KIND inputKind = EIK_RGB_ALBEDO_NORMAL;
+			uint32_t tileWidth = 0u;
+			uint32_t tileHeight = 0u;
+
+			inline bool operator<(const SKey& other) const
+			{
+				return std::tie(model, inputKind, tileWidth, tileHeight) < std::tie(other.model, other.inputKind, other.tileWidth, other.tileHeight);
+			}
+			inline bool operator==(const SKey& other) const
+			{
+				return std::tie(model, inputKind, tileWidth, tileHeight) == std::tie(other.model, other.inputKind, other.tileWidth, other.tileHeight);
+			}
+		};
+
+		//! A denoiser set up for `key`, valid until handed back with `release`
+		struct SInstance
+		{
+			SKey key;
+			denoiser_t denoiser = 0ull;
+			address_t state = 0ull;
+			size_t stateSize = 0ull;
+			address_t scratch = 0ull;
+			size_t scratchSize = 0ull;
+			uint32_t overlapWindowSizeInPixels = 0u;
+
+			inline size_t getMemoryConsumption() const { return stateSize + scratchSize; }
+		};
+
+		struct SStatistics
+		{
+			uint32_t hits = 0u;
+			uint32_t misses = 0u;
+			uint32_t evictions = 0u;
+		};
+
+		//! `memoryCap` bounds the state and scratch held by instances not in use, 0 keeps none of them
+		CDenoiserCache(IDenoiserBackend* backend, size_t memoryCap = 0ull);
+		~CDenoiserCache();
+
+		CDenoiserCache(const CDenoiserCache&) = delete;
+		CDenoiserCache& operator=(const CDenoiserCache&) = delete;
+
+		//! Answered from memory after the first query of a key, the tile planner asks about many tile sizes per resolution
+		bool getMemoryRequirements(const SKey& key, SDenoiserMemoryRequirements& outRequirements);
+
+		//! Returns nullptr if the denoiser could not be created, allocated or set up. The instance can't get evicted until it's released.
+		const SInstance* acquire(const SKey& key);
+		void release(const SInstance* instance);
+
+		//! Destroys instances not in use until the ones left hold no more than `memoryCap`
+		void trim(size_t memoryCap);
+		inline void setMemoryCap(size_t memoryCap) { m_memoryCap = memoryCap; trim(m_memoryCap); }
+
+		//! State and scratch of every instance, in use or not
+		inline size_t getMemoryConsumption() const { return m_memoryConsumption; }
+		//! The part of `getMemoryConsumption` that `trim` could give back
+		size_t getIdleMemoryConsumption() const;
+		inline size_t getInstanceCount() const { return m_entries.size(); }
+		inline const SStatistics& getStatistics() const { return m_statistics; }
+		inline IDenoiserBackend* getBackend() const { return m_backend; }
+
+	private:
+		struct SEntry
+		{
+			SInstance instance;
+			uint64_t lastUse = 0ull;
+			bool inUse = false;
+		};
+
+		//! A denoiser of `key.model` and `key.inputKind`, spare or newly created
+		denoiser_t takeDenoiser(const SKey& key);
+		void destroy(std::list<SEntry>::iterator entry);
+		//! Least recently used entry not in use, `end()` if there's none
+		std::list<SEntry>::iterator findEvictionCandidate();
+
+		IDenoiserBackend* const m_backend;
+		size_t m_memoryCap;
+
+		std::list<SEntry> m_entries;
+		std::map<SKey, SDenoiserMemoryRequirements> m_requirements;
+		//! not set up for anything, at most one per model and input kind, the tile size of their key is 0
+		std::vector<std::pair<SKey, denoiser_t>> m_spareDenoisers;
+		size_t m_memoryConsumption = 0ull;
+		uint64_t m_useCounter = 0ull;
+		SStatistics m_statistics;
+};
+
+}
+
+#endif // __DBR_C_DENOISER_CACHE_H_INCLUDED__
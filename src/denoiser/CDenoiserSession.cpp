@@ -0,0 +1,240 @@
+#include "denoiser/CDenoiserSession.h"
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+
+using namespace dbr;
+
+CDenoiserSession::CDenoiserSession(IDenoiserBackend* backend, const SConfig& config, CProfiler* profiler, CDenoiserCache* cache)
+	: m_backend(backend), m_config(config), m_profiler(profiler), m_cache(cache)
+{
+	assert(m_backend);
+	if (!m_cache)
+	{
+		m_ownedCache = std::make_unique<CDenoiserCache>(m_backend);
+		m_cache = m_ownedCache.get();
+	}
+	assert(m_cache->getBackend() == m_backend);
+}
+
+CDenoiserSession::~CDenoiserSession()
+{
+	release();
+}
+
+bool CDenoiserSession::prepare(uint32_t width, uint32_t height, const input_formats_t& inputFormats)
+{
+	if (isPrepared() && width == m_width && height == m_height && inputFormats == m_inputFormats)
+		return true;
+
+	CProfiler::CScope scope(m_profiler, "setup");
+
+	// the denoiser goes back to the cache in case the resolution comes back, the pixel buffers get reused if big enough
+	releaseInstance();
+	m_width = m_height = 0u;
+	m_tilingTuned = false;
+	if (!width || !height)
+		return false;
+
+	/*
+		Compute memory resources for denoiser
+	*/
+
+	CTilePlanner::SRequest request;
+	request.width = width;
+	request.height = height;
+	request.format = m_config.format;
+	request.inputCount = m_config.inputKind;
+	request.inputFormats = inputFormats;
+	const bool forcedTileSize = m_config.tileWidth && m_config.tileHeight;
+	const CTuningProfile::SEntry* tuned = m_config.tuningProfile && !forcedTileSize ? m_config.tuningProfile->find(m_backend->getName(), width, height) : nullptr;
+	request.overlap = tuned && !m_config.overlap ? tuned->overlap : m_config.overlap;
+	// leave some headroom for the driver and fragmentation when going by what's reported free, memory the session and cache could give back counts as free
+	const size_t reclaimable = m_cache->getIdleMemoryConsumption() + m_inputCapacity + m_outputCapacity;
+	request.memoryBudget = m_config.memoryBudget ? m_config.memoryBudget : (m_backend->getAvailableMemory() + reclaimable) / 10ull * 9ull;
+
+	auto getRequirements = [this](uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements) -> bool
+	{
+		return m_cache->getMemoryRequirements({ m_config.model,m_config.inputKind,tileWidth,tileHeight }, outRequirements);
+	};
+	bool planned;
+	if (forcedTileSize)
+		planned = CTilePlanner::planFixed(request, m_config.tileWidth, m_config.tileHeight, getRequirements, m_plan);
+	else
+	{
+		// the budget can be tighter than when the profile was tuned, i.e. other processes holding memory
+		m_tilingTuned = tuned && CTilePlanner::planFixed(request, tuned->tileWidth, tuned->tileHeight, getRequirements, m_plan) && m_plan.getTotalSizeInBytes() <= request.memoryBudget;
+		if (!m_tilingTuned)
+			request.overlap = m_config.overlap;
+		planned = m_tilingTuned || CTilePlanner::plan(request, getRequirements, m_plan);
+	}
+	if (!planned)
+	{
+		release();
+		return false;
+	}
+
+	/*
+		Get a denoiser set up for the tile size, with its state and scratch
+	*/
+
+	m_instance = m_cache->acquire({ m_config.model,m_config.inputKind,m_plan.tileWidth,m_plan.tileHeight });
+	if (!m_instance)
+	{
+		release();
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_inputFormats = inputFormats;
+
+	// grow only, so switching back and forth between resolutions doesn't reallocate either
+	auto reserve = [this](address_t& buffer, size_t& capacity, const size_t size) -> bool
+	{
+		if (capacity >= size)
+			return true;
+		m_backend->deallocate(buffer);
+		buffer = m_backend->allocate(size);
+		capacity = buffer ? size : 0ull;
+		return buffer;
+	};
+	const size_t imageSize = getImageSize();
+	if (!m_hdrParameters)
+		m_hdrParameters = m_backend->allocate(sizeof(SHDRParameters));
+	if (!m_hdrParameters || !reserve(m_inputPixelBuffer, m_inputCapacity, getInputTransferSize()) || !reserve(m_outputPixelBuffer, m_outputCapacity, imageSize))
+	{
+		release();
+		return false;
+	}
+
+	m_canComputeIntensity = m_outputCapacity >= m_backend->getIntensityScratchSize(width, height);
+	m_prepareCount++;
+	if (m_profiler)
+		m_profiler->recordCounter("backend_memory", getMemoryConsumption());
+	return true;
+}
+
+void CDenoiserSession::release()
+{
+	releaseInstance();
+	for (address_t* buffer : { &m_hdrParameters, &m_inputPixelBuffer, &m_outputPixelBuffer })
+	{
+		m_backend->deallocate(*buffer);
+		*buffer = 0ull;
+	}
+	m_inputCapacity = m_outputCapacity = 0ull;
+
+	m_width = m_height = 0u;
+	m_inputFormats = {};
+	m_plan = {};
+	m_tilingTuned = false;
+	m_canComputeIntensity = false;
+	m_intensityComparison = {};
+}
+
+void CDenoiserSession::releaseInstance()
+{
+	m_cache->release(m_instance);
+	m_instance = nullptr;
+}
+
+SImage2D CDenoiserSession::getImage(address_t data, E_PIXEL_FORMAT format) const
+{
+	SImage2D retval;
+	retval.data = data;
+	retval.width = m_width;
+	retval.height = m_height;
+	retval.pixelStrideInBytes = getPixelFormatStride(format);
+	retval.rowStrideInBytes = m_width * retval.pixelStrideInBytes;
+	retval.format = format;
+	return retval;
+}
+
+bool CDenoiserSession::denoise(const void* const* inputs, void* output, const SHDRParameters* hostParameters)
+{
+	if (!isPrepared())
+		return false;
+
+	const size_t imageSize = getImageSize();
+
+	/*
+		Fill backend buffers with appropriate texture data
+	*/
+
+	SImage2D denoiserInputs[EIK_RGB_ALBEDO_NORMAL];
+	{
+		CProfiler::CScope scope(m_profiler, "h2d", getInputTransferSize());
+		address_t inputAddress = m_inputPixelBuffer;
+		for (uint32_t k = 0u; k < m_config.inputKind; k++)
+		{
+			denoiserInputs[k] = getImage(inputAddress, m_inputFormats[k]);
+			if (!m_backend->copyHostToDevice(denoiserInputs[k].data, inputs[k], getInputSize(k)))
+				return false;
+			inputAddress += getInputSize(k);
+		}
+	}
+	const SImage2D denoiserOutput = getImage(m_outputPixelBuffer, m_config.format);
+
+	const bool runIntensityPass = !hostParameters || m_config.validateHostStatistics;
+	if (runIntensityPass)
+	{
+		if (!m_canComputeIntensity)
+		{
+			std::cerr << "ERROR: The " << m_backend->getName() << " intensity pass needs more scratch than the output buffer at " << m_width << "x" << m_height << "\n";
+			return false;
+		}
+
+		CProfiler::CScope scope(m_profiler, "intensity");
+		if (!m_backend->computeIntensity(m_instance->denoiser, denoiserInputs[0], m_hdrParameters, m_outputPixelBuffer, imageSize))
+			return false;
+		// otherwise the asynchronous intensity pass would get billed to the tiled invocation
+		if (m_profiler && !m_backend->synchronize())
+			return false;
+	}
+
+	SDenoiserParams denoiserParams;
+	denoiserParams.denoiseAlpha = false;
+	denoiserParams.blendFactor = 0.f;
+	denoiserParams.hdrIntensity = m_hdrParameters;
+	denoiserParams.hdrAverageColor = 0ull;
+
+	if (hostParameters)
+	{
+		if (m_config.validateHostStatistics)
+		{
+			float backendIntensity;
+			if (!m_backend->copyDeviceToHost(&backendIntensity, m_hdrParameters, sizeof(float)) || !m_backend->synchronize())
+				return false;
+			m_intensityComparison = { hostParameters->intensity,backendIntensity,true };
+		}
+
+		CProfiler::CScope scope(m_profiler, "hdr_parameters", sizeof(SHDRParameters));
+		if (!m_backend->copyHostToDevice(m_hdrParameters, hostParameters, sizeof(SHDRParameters)))
+			return false;
+		denoiserParams.hdrAverageColor = m_hdrParameters + offsetof(SHDRParameters, averageColor);
+	}
+
+	{
+		CProfiler::CScope scope(m_profiler, "invoke_tiled");
+		const bool invoked = m_backend->invokeTiled(
+			m_instance->denoiser,
+			denoiserParams,
+			m_instance->state,
+			m_instance->stateSize,
+			denoiserInputs,
+			m_config.inputKind,
+			denoiserOutput,
+			m_instance->scratch,
+			m_instance->scratchSize,
+			m_plan.overlap,
+			m_plan.tileWidth,
+			m_plan.tileHeight);
+		if (!invoked || !m_backend->synchronize())
+			return false;
+	}
+
+	CProfiler::CScope scope(m_profiler, "d2h", imageSize);
+	return m_backend->copyDeviceToHost(output, m_outputPixelBuffer, imageSize) && m_backend->synchronize();
+}
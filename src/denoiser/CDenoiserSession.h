@@ -0,0 +1,146 @@
+#ifndef __DBR_C_DENOISER_SESSION_H_INCLUDED__
+#define __DBR_C_DENOISER_SESSION_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+#include "denoiser/CTilePlanner.h"
+#include "denoiser/CDenoiserCache.h"
+#include "denoiser/CTuningProfile.h"
+#include "denoiser/ColorStatistics.h"
+#include "core/CProfiler.h"
+
+#include <cmath>
+
+namespace dbr
+{
+
+/*
+	Everything a backend needs to denoise frames of one resolution: the denoiser itself, its state and scratch,
+	the intensity value and the input/output pixel buffers.
+
+	Set up by `prepare` and reused by every `denoise` call until the resolution changes, so a sequence only pays
+	the setup cost once per resolution instead of once per frame. The denoiser with its state and scratch comes from
+	a `CDenoiserCache`, so coming back to a resolution seen before doesn't pay it again either.
+*/
+class CDenoiserSession
+{
+	public:
+		struct SConfig
+		{
+			E_MODEL_KIND model = EMK_HDR;
+			E_INPUT_KIND inputKind = EIK_RGB_ALBEDO_NORMAL;
+			//! of the output, and of the inputs unless `prepare` gets told otherwise
+			E_PIXEL_FORMAT format = EPF_HALF4;
+			//! both non-zero forces a tile size, otherwise `CTilePlanner` picks the largest that fits `memoryBudget`
+			uint32_t tileWidth = 0u;
+			uint32_t tileHeight = 0u;
+			//! 0 uses the overlap the backend asks for
+			uint32_t overlap = 0u;
+			//! 0 budgets whatever the backend reports as available, less some headroom
+			size_t memoryBudget = 0ull;
+			//! when `denoise` gets host computed HDR parameters, still run the backend intensity pass and keep both for comparison
+			bool validateHostStatistics = false;
+			//! tiling measured fastest for a resolution on this machine, used unless a tile size is forced and while it fits the budget
+			const CTuningProfile* tuningProfile = nullptr;
+		};
+
+		//! Intensity of the last frame computed on the host and by the backend, only filled with `SConfig::validateHostStatistics`
+		struct SIntensityComparison
+		{
+			float host = 0.f;
+			float backend = 0.f;
+			bool valid = false;
+
+			inline float getRelativeDifference() const { return backend != 0.f ? std::abs(host - backend) / std::abs(backend) : std::abs(host); }
+		};
+
+		/*
+			With a `profiler` every backend call gets timed, which costs a stream synchronization after the intensity pass.
+			Sessions can share a `cache` of the same backend, without one the session keeps only the denoiser it uses.
+		*/
+		CDenoiserSession(IDenoiserBackend* backend, const SConfig& config, CProfiler* profiler = nullptr, CDenoiserCache* cache = nullptr);
+		~CDenoiserSession();
+
+		CDenoiserSession(const CDenoiserSession&) = delete;
+		CDenoiserSession& operator=(const CDenoiserSession&) = delete;
+
+		using input_formats_t = std::array<E_PIXEL_FORMAT, EIK_RGB_ALBEDO_NORMAL>;
+
+		//! Returns true straight away if the session is already prepared for this resolution and input formats
+		bool prepare(uint32_t width, uint32_t height, const input_formats_t& inputFormats);
+		//! All inputs in the configured format
+		inline bool prepare(uint32_t width, uint32_t height)
+		{
+			return prepare(width, height, { m_config.format,m_config.format,m_config.format });
+		}
+		//! Frees the pixel buffers and hands the denoiser back to the cache
+		void release();
+
+		/*
+			`inputs` are tightly packed images in the formats the session got prepared with, one per input layer, `output` is in the configured format.
+
+			With `hostParameters`, i.e. gathered while the color got loaded, those get uploaded instead of running the backend intensity pass.
+		*/
+		bool denoise(const void* const* inputs, void* output, const SHDRParameters* hostParameters = nullptr);
+
+		inline bool isPrepared() const { return m_instance; }
+		inline uint32_t getWidth() const { return m_width; }
+		inline uint32_t getHeight() const { return m_height; }
+		inline const SConfig& getConfig() const { return m_config; }
+		inline const input_formats_t& getInputFormats() const { return m_inputFormats; }
+		//! Tiling the session got prepared with
+		inline const STilePlan& getTilePlan() const { return m_plan; }
+		//! Whether that tiling came from the tuning profile
+		inline bool isTilingTuned() const { return m_tilingTuned; }
+		inline IDenoiserBackend* getBackend() const { return m_backend; }
+		inline CDenoiserCache* getCache() const { return m_cache; }
+
+		//! Size of the tightly packed output image in bytes
+		inline size_t getImageSize() const { return size_t(getPixelFormatStride(m_config.format)) * m_width * m_height; }
+		//! Size of one tightly packed input layer in bytes
+		inline size_t getInputSize(uint32_t layer) const { return size_t(getPixelFormatStride(m_inputFormats[layer])) * m_width * m_height; }
+		//! What every `denoise` uploads
+		inline size_t getInputTransferSize() const
+		{
+			size_t retval = 0ull;
+			for (uint32_t k = 0u; k < m_config.inputKind; k++)
+				retval += getInputSize(k);
+			return retval;
+		}
+		//! Backend memory held by the session
+		inline size_t getMemoryConsumption() const { return (m_instance ? m_instance->getMemoryConsumption() : 0ull) + m_inputCapacity + m_outputCapacity; }
+		//! How many times the session had to prepare for a new resolution or input formats, a sequence of one resolution should report 1
+		inline uint32_t getPrepareCount() const { return m_prepareCount; }
+		inline const SIntensityComparison& getIntensityComparison() const { return m_intensityComparison; }
+
+	private:
+		SImage2D getImage(address_t data, E_PIXEL_FORMAT format) const;
+		void releaseInstance();
+
+		IDenoiserBackend* const m_backend;
+		const SConfig m_config;
+		CProfiler* const m_profiler;
+		std::unique_ptr<CDenoiserCache> m_ownedCache;
+		CDenoiserCache* m_cache;
+		const CDenoiserCache::SInstance* m_instance = nullptr;
+
+		uint32_t m_width = 0u;
+		uint32_t m_height = 0u;
+		uint32_t m_prepareCount = 0u;
+		input_formats_t m_inputFormats = {};
+		STilePlan m_plan;
+		bool m_tilingTuned = false;
+		//! the backend intensity pass borrows the output buffer as scratch, which not every backend fits in
+		bool m_canComputeIntensity = false;
+		SIntensityComparison m_intensityComparison;
+
+		//! an `SHDRParameters`, the backend intensity pass only writes its first member
+		address_t m_hdrParameters = 0ull;
+		address_t m_inputPixelBuffer = 0ull;
+		address_t m_outputPixelBuffer = 0ull;
+		size_t m_inputCapacity = 0ull;
+		size_t m_outputCapacity = 0ull;
+};
+
+}
+
+#endif // __DBR_C_DENOISER_SESSION_H_INCLUDED__
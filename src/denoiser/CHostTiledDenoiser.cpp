@@ -0,0 +1,478 @@
+#include "denoiser/CHostTiledDenoiser.h"
+#include "core/half.h"
+#include "core/Hash.h"
+#include "core/Clock.h"
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <iostream>
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+using namespace dbr;
+
+namespace
+{
+
+// same granularity as the loader's conversion, for gathering the frame's color statistics
+constexpr size_t StatisticsChunkPixels = 64ull * 1024ull;
+// rows composited per task
+constexpr uint32_t CompositeRowsPerTask = 8u;
+
+inline bool isHalf(const E_PIXEL_FORMAT format)
+{
+	return format == EPF_HALF3 || format == EPF_HALF4;
+}
+
+}
+
+CHostTiledDenoiser::CHostTiledDenoiser(const std::vector<CDenoiserSession*>& sessions, const SConfig& config, CThreadPool* pool, CProfiler* profiler)
+	: m_scheduler(static_cast<uint32_t>(sessions.size())), m_config(config), m_pool(pool), m_profiler(profiler)
+{
+	assert(!sessions.empty() && m_pool);
+	for (CDenoiserSession* session : sessions)
+	{
+		assert(session->getConfig().format == sessions.front()->getConfig().format);
+		m_workers.push_back({ session,nullptr,0ull });
+	}
+}
+
+CHostTiledDenoiser::~CHostTiledDenoiser()
+{
+	for (SWorker& worker : m_workers)
+	if (worker.inputs)
+		worker.session->getBackend()->deallocateHost(worker.inputs);
+}
+
+std::vector<CHostTiledDenoiser::SWeightSpan> CHostTiledDenoiser::computeWeightSpans(uint32_t size, uint32_t tileSize, uint32_t feather)
+{
+	/*
+		Every seam gets a linear ramp of `feather` pixels centered on it, where the weight of one tile falls exactly as fast
+		as its neighbour's rises, so the weights of every pixel sum to 1 and the product of the two axes' weights does too.
+		Without feathering the ramp degenerates into a step at the seam.
+	*/
+	const float halfFeather = float(feather) * 0.5f;
+	auto ramp = [feather](const float distance) -> float
+	{
+		if (!feather)
+			return distance >= 0.f ? 1.f : 0.f;
+		return std::clamp(distance / float(feather), 0.f, 1.f);
+	};
+
+	const uint32_t tileCount = (size + tileSize - 1u) / tileSize;
+	std::vector<SWeightSpan> retval(tileCount);
+	for (uint32_t t = 0u; t < tileCount; t++)
+	{
+		const uint32_t begin = t * tileSize;
+		const uint32_t end = std::min(begin + tileSize, size);
+		const uint32_t reachBegin = begin > feather ? begin - feather : 0u;
+		const uint32_t reachEnd = std::min(end + feather, size);
+
+		SWeightSpan& span = retval[t];
+		span.begin = reachEnd;
+		std::vector<float> weights(reachEnd - reachBegin);
+		for (uint32_t p = reachBegin; p < reachEnd; p++)
+		{
+			const float center = float(p) + 0.5f;
+			const float rising = begin ? ramp(center - (float(begin) - halfFeather)) : 1.f;
+			const float falling = end != size ? ramp(float(end) + halfFeather - center) : 1.f;
+			weights[p - reachBegin] = rising * falling;
+			if (weights[p - reachBegin] > 0.f)
+				span.begin = std::min(span.begin, p);
+		}
+
+		uint32_t last = span.begin;
+		for (uint32_t p = span.begin; p < reachEnd; p++)
+		if (weights[p - reachBegin] > 0.f)
+			last = p + 1u;
+		span.weights.assign(weights.begin() + (span.begin - reachBegin), weights.begin() + (last - reachBegin));
+	}
+	return retval;
+}
+
+bool CHostTiledDenoiser::prepare(uint32_t width, uint32_t height, const CDenoiserSession::input_formats_t& inputFormats, bool banded)
+{
+	if (m_width && width == m_width && height == m_height && inputFormats == m_inputFormats && banded == m_banded)
+		return true;
+
+	m_width = m_height = 0u;
+	if (!width || !height || !m_config.tileWidth || !m_config.tileHeight)
+		return false;
+
+	CDenoiserSession& firstSession = *m_workers.front().session;
+	const auto& sessionConfig = firstSession.getConfig();
+	m_tileWidth = std::min(m_config.tileWidth, width);
+	m_tileHeight = std::min(m_config.tileHeight, height);
+	m_overlap = m_config.overlap;
+	if (!m_overlap)
+	{
+		SDenoiserMemoryRequirements requirements;
+		if (!firstSession.getCache()->getMemoryRequirements({ sessionConfig.model,sessionConfig.inputKind,m_tileWidth,m_tileHeight }, requirements))
+			return false;
+		m_overlap = requirements.overlapWindowSizeInPixels;
+	}
+	// the ramp has to stay inside the padding on both sides of the seam and can't span more than a whole tile
+	m_feather = std::min({ m_config.feather == SConfig::DefaultFeather ? m_overlap : m_config.feather,m_overlap * 2u,m_tileWidth,m_tileHeight });
+	m_inputFormats = inputFormats;
+
+	m_tileCountX = (width + m_tileWidth - 1u) / m_tileWidth;
+	const uint32_t tileCountY = (height + m_tileHeight - 1u) / m_tileHeight;
+	m_tiles.clear();
+	for (uint32_t ty = 0u; ty < tileCountY; ty++)
+	for (uint32_t tx = 0u; tx < m_tileCountX; tx++)
+	{
+		STileRegion& tile = m_tiles.emplace_back();
+		tile.x = tx * m_tileWidth;
+		tile.y = ty * m_tileHeight;
+		tile.width = std::min(m_tileWidth, width - tile.x);
+		tile.height = std::min(m_tileHeight, height - tile.y);
+	}
+	m_columnSpans = computeWeightSpans(width, m_tileWidth, m_feather);
+	m_rowSpans = computeWeightSpans(height, m_tileHeight, m_feather);
+	// the feather never spans more than a tile, so only the rows around one seam are blended from two tile rows
+	m_banded = banded;
+	m_residentTileRows = m_banded ? std::min(2u, tileCountY) : tileCountY;
+
+	const STileRegion& region = m_config.regionOfInterest;
+	m_regionOfInterest = { 0u,0u,width,height };
+	if (region.width && region.height && !m_banded)
+	{
+		if (region.x >= width || region.y >= height)
+		{
+			std::cerr << "ERROR: The region of interest at " << region.x << "," << region.y << " is outside the " << width << "x" << height << " frame\n";
+			return false;
+		}
+		m_regionOfInterest = { region.x,region.y,std::min(region.width,width - region.x),std::min(region.height,height - region.y) };
+	}
+	// a tile is needed wherever its blend weights reach into the region, with feathering that's past its own edges
+	m_activeTiles.clear();
+	m_tileActive.assign(m_tiles.size(), 0u);
+	for (uint32_t i = 0u; i < m_tiles.size(); i++)
+	{
+		const SWeightSpan& rowSpan = m_rowSpans[i / m_tileCountX];
+		const SWeightSpan& columnSpan = m_columnSpans[i % m_tileCountX];
+		if (rowSpan.begin < m_regionOfInterest.y + m_regionOfInterest.height && rowSpan.end() > m_regionOfInterest.y &&
+			columnSpan.begin < m_regionOfInterest.x + m_regionOfInterest.width && columnSpan.end() > m_regionOfInterest.x)
+		{
+			m_activeTiles.push_back(i);
+			m_tileActive[i] = 1u;
+		}
+	}
+	// whatever got denoised before doesn't line up with the new tiles
+	m_tileHashes.assign(m_config.tileCache && !m_banded ? m_tiles.size() : 0ull, 0ull);
+	m_hasHeldHDRParameters = false;
+
+	const size_t tileOutputsSize = getTileOutputSize() * m_tileCountX * m_residentTileRows;
+	if (m_tileOutputCapacity < tileOutputsSize)
+	{
+		m_tileOutputs.reset(new (std::nothrow) uint8_t[tileOutputsSize]);
+		m_tileOutputCapacity = m_tileOutputs ? tileOutputsSize : 0ull;
+		if (!m_tileOutputs)
+			return false;
+	}
+
+	size_t inputsSize = 0ull;
+	for (uint32_t k = 0u; k < sessionConfig.inputKind; k++)
+		inputsSize += getPaddedLayerSize(k);
+	for (SWorker& worker : m_workers)
+	{
+		if (!worker.session->prepare(getPaddedTileWidth(), getPaddedTileHeight(), inputFormats))
+			return false;
+
+		if (worker.capacity >= inputsSize)
+			continue;
+		IDenoiserBackend* backend = worker.session->getBackend();
+		if (worker.inputs)
+			backend->deallocateHost(worker.inputs);
+		worker.inputs = static_cast<uint8_t*>(backend->allocateHost(inputsSize));
+		worker.capacity = worker.inputs ? inputsSize : 0ull;
+		if (!worker.inputs)
+			return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_prepareCount++;
+	return true;
+}
+
+size_t CHostTiledDenoiser::getHostMemoryConsumption() const
+{
+	size_t retval = m_tileOutputCapacity;
+	for (const SWorker& worker : m_workers)
+		retval += worker.capacity;
+	return retval;
+}
+
+void CHostTiledDenoiser::getTileRowInputRows(uint32_t tileRow, uint32_t& outBegin, uint32_t& outEnd) const
+{
+	const int64_t paddedY = int64_t(tileRow) * m_tileHeight - m_overlap;
+	outBegin = static_cast<uint32_t>(std::max<int64_t>(paddedY, 0));
+	outEnd = static_cast<uint32_t>(std::min<int64_t>(paddedY + getPaddedTileHeight(), m_height));
+}
+
+void CHostTiledDenoiser::extractTile(const void* const* inputs, uint32_t inputFirstRow, const STileRegion& tile, uint8_t* outInputs) const
+{
+	const uint32_t paddedWidth = getPaddedTileWidth();
+	const int64_t paddedX = int64_t(tile.x) - m_overlap;
+	const int64_t paddedY = int64_t(tile.y) - m_overlap;
+	// columns of the padded tile that are inside the image, the rest replicate the edge pixels
+	const uint32_t left = static_cast<uint32_t>(std::clamp<int64_t>(-paddedX, 0, paddedWidth));
+	const uint32_t inside = static_cast<uint32_t>(std::clamp<int64_t>(int64_t(m_width) - std::max<int64_t>(paddedX, 0), 0, paddedWidth - left));
+
+	for (uint32_t k = 0u; k < m_workers.front().session->getConfig().inputKind; k++)
+	{
+		const size_t stride = getPixelFormatStride(m_inputFormats[k]);
+		const uint8_t* src = static_cast<const uint8_t*>(inputs[k]);
+		for (uint32_t y = 0u; y < getPaddedTileHeight(); y++)
+		{
+			const int64_t srcY = std::clamp<int64_t>(paddedY + y, 0, int64_t(m_height) - 1);
+			const uint8_t* srcRow = src + size_t(srcY - inputFirstRow) * m_width * stride;
+			uint8_t* dstRow = outInputs + size_t(y) * paddedWidth * stride;
+
+			for (uint32_t x = 0u; x < left; x++)
+				std::memcpy(dstRow + x * stride, srcRow, stride);
+			std::memcpy(dstRow + left * stride, srcRow + size_t(std::max<int64_t>(paddedX, 0)) * stride, inside * stride);
+			const uint8_t* lastPixel = srcRow + size_t(m_width - 1u) * stride;
+			for (uint32_t x = left + inside; x < paddedWidth; x++)
+				std::memcpy(dstRow + x * stride, lastPixel, stride);
+		}
+		outInputs += getPaddedLayerSize(k);
+	}
+}
+
+void CHostTiledDenoiser::compositeRowRange(uint32_t beginY, uint32_t endY, void* output, uint32_t outputFirstRow) const
+{
+	const uint32_t beginX = m_regionOfInterest.x;
+	const uint32_t endX = beginX + m_regionOfInterest.width;
+	const E_PIXEL_FORMAT format = getOutputFormat();
+	const uint32_t channelCount = getPixelFormatChannelCount(format);
+	const size_t stride = getPixelFormatStride(format);
+	const uint32_t paddedWidth = getPaddedTileWidth();
+
+	std::vector<float> accumulator(size_t(m_width) * channelCount);
+	std::vector<float> decoded(size_t(paddedWidth) * channelCount);
+	for (uint32_t y = beginY; y < endY; y++)
+	{
+		std::fill(accumulator.begin(), accumulator.end(), 0.f);
+
+		// tiles always get added in the same order, so the result doesn't depend on which worker denoised what
+		const uint32_t firstRow = y / m_tileHeight;
+		for (uint32_t ty = firstRow ? firstRow - 1u : 0u; ty < std::min<uint32_t>(firstRow + 2u, uint32_t(m_rowSpans.size())); ty++)
+		{
+			const SWeightSpan& rowSpan = m_rowSpans[ty];
+			if (y < rowSpan.begin || y >= rowSpan.end())
+				continue;
+			const float rowWeight = rowSpan.weights[y - rowSpan.begin];
+			const uint32_t localY = y + m_overlap - ty * m_tileHeight;
+
+			for (uint32_t tx = 0u; tx < m_tileCountX; tx++)
+			{
+				// tiles outside the region of interest only blend into pixels outside it
+				if (!m_tileActive[size_t(ty) * m_tileCountX + tx])
+					continue;
+				const SWeightSpan& columnSpan = m_columnSpans[tx];
+				const uint32_t localX = columnSpan.begin + m_overlap - tx * m_tileWidth;
+				const size_t count = columnSpan.weights.size();
+				const uint8_t* tileRow = getTileOutput(size_t(ty) * m_tileCountX + tx) + (size_t(localY) * paddedWidth + localX) * stride;
+				if (isHalf(format))
+					convertHalfToFloat(reinterpret_cast<const uint16_t*>(tileRow), decoded.data(), count * channelCount);
+				else
+					std::memcpy(decoded.data(), tileRow, count * stride);
+
+				float* out = accumulator.data() + size_t(columnSpan.begin) * channelCount;
+				for (size_t i = 0ull; i < count; i++)
+				{
+					const float weight = columnSpan.weights[i] * rowWeight;
+					for (uint32_t c = 0u; c < channelCount; c++)
+						out[i * channelCount + c] += weight * decoded[i * channelCount + c];
+				}
+			}
+		}
+
+		uint8_t* outRow = static_cast<uint8_t*>(output) + (size_t(y - outputFirstRow) * m_width + beginX) * stride;
+		const float* regionRow = accumulator.data() + size_t(beginX) * channelCount;
+		const size_t valueCount = size_t(endX - beginX) * channelCount;
+		if (isHalf(format))
+			convertFloatToHalf(regionRow, reinterpret_cast<uint16_t*>(outRow), valueCount);
+		else
+			std::memcpy(outRow, regionRow, valueCount * sizeof(float));
+	}
+}
+
+void CHostTiledDenoiser::compositeRows(uint32_t beginY, uint32_t endY, void* output, uint32_t outputFirstRow)
+{
+	beginY = std::max(beginY, m_regionOfInterest.y);
+	endY = std::min(endY, m_regionOfInterest.y + m_regionOfInterest.height);
+	if (beginY >= endY)
+		return;
+
+	CProfiler::CScope scope(m_profiler, "tile_composite", size_t(getPixelFormatStride(getOutputFormat())) * m_width * (endY - beginY));
+	const uint32_t taskCount = (endY - beginY + CompositeRowsPerTask - 1u) / CompositeRowsPerTask;
+	m_pool->parallelFor(taskCount, [&](size_t task)
+	{
+		const uint32_t taskBeginY = beginY + static_cast<uint32_t>(task) * CompositeRowsPerTask;
+		compositeRowRange(taskBeginY, std::min(taskBeginY + CompositeRowsPerTask, endY), output, outputFirstRow);
+	});
+}
+
+bool CHostTiledDenoiser::denoiseTiles(const uint32_t* tiles, size_t tileCount, const void* const* inputs, uint32_t inputFirstRow, const SHDRParameters& hdrParameters,
+	const std::function<bool(uint32_t)>& onTileDone)
+{
+	const bool tileCache = !m_tileHashes.empty();
+	const uint64_t hdrParametersHash = hashMemory(&hdrParameters, sizeof(hdrParameters));
+	std::atomic<uint32_t> hits = 0u;
+	std::vector<double> missMilliseconds(m_workers.size(), 0.0);
+	const bool success = m_scheduler.run(*m_pool, 0ull, tileCount, [&](uint32_t w, size_t i) -> bool
+	{
+		const uint32_t tile = tiles[i];
+		const SWorker& worker = m_workers[w];
+		const void* tileInputs[EIK_RGB_ALBEDO_NORMAL];
+		size_t inputsSize = 0ull;
+		for (uint32_t k = 0u; k < worker.session->getConfig().inputKind; k++)
+		{
+			tileInputs[k] = worker.inputs + inputsSize;
+			inputsSize += getPaddedLayerSize(k);
+		}
+
+		{
+			CProfiler::CScope scope(m_profiler, "tile_extract", inputsSize);
+			extractTile(inputs, inputFirstRow, m_tiles[tile], worker.inputs);
+		}
+
+		// the padded inputs decide everything about the tile's output, so an unchanged hash means its output is still there
+		uint64_t hash = 0ull;
+		if (tileCache)
+		{
+			CProfiler::CScope scope(m_profiler, "tile_hash", inputsSize);
+			hash = hashMemory(worker.inputs, inputsSize, hdrParametersHash);
+			if (hash == m_tileHashes[tile])
+			{
+				hits++;
+				return !onTileDone || onTileDone(tile);
+			}
+			m_tileHashes[tile] = 0ull;
+		}
+
+		const auto begin = steady_clock_t::now();
+		if (!worker.session->denoise(tileInputs, getTileOutput(tile), &hdrParameters))
+			return false;
+		missMilliseconds[w] += getMilliseconds(begin, steady_clock_t::now());
+		if (tileCache)
+			m_tileHashes[tile] = hash;
+		return !onTileDone || onTileDone(tile);
+	});
+
+	if (tileCache)
+	{
+		m_frameTileCacheStatistics = {};
+		m_frameTileCacheStatistics.hits = hits;
+		m_frameTileCacheStatistics.misses = static_cast<uint32_t>(tileCount) - hits;
+		for (const double milliseconds : missMilliseconds)
+			m_frameTileCacheStatistics.missMilliseconds += milliseconds;
+		m_tileCacheStatistics.hits += m_frameTileCacheStatistics.hits;
+		m_tileCacheStatistics.misses += m_frameTileCacheStatistics.misses;
+		m_tileCacheStatistics.missMilliseconds += m_frameTileCacheStatistics.missMilliseconds;
+	}
+	return success;
+}
+
+const SHDRParameters& CHostTiledDenoiser::holdHDRParameters(const SHDRParameters& hdrParameters)
+{
+	auto isClose = [this](const float held, const float value) -> bool
+	{
+		return std::abs(value - held) <= m_config.tileCacheHDRTolerance * std::abs(held);
+	};
+	bool hold = m_hasHeldHDRParameters && isClose(m_heldHDRParameters.intensity, hdrParameters.intensity);
+	for (uint32_t c = 0u; hold && c < 3u; c++)
+		hold = isClose(m_heldHDRParameters.averageColor[c], hdrParameters.averageColor[c]);
+
+	if (!hold)
+	{
+		m_heldHDRParameters = hdrParameters;
+		m_hasHeldHDRParameters = true;
+	}
+	return m_heldHDRParameters;
+}
+
+bool CHostTiledDenoiser::denoise(const void* const* inputs, void* output, const SHDRParameters* hdrParameters, const rows_done_callback_t& onRowsDone)
+{
+	if (!m_width || m_banded)
+		return false;
+
+	SHDRParameters frameParameters;
+	if (!hdrParameters)
+	{
+		CProfiler::CScope scope(m_profiler, "tile_hdr_parameters");
+		const size_t pixelCount = size_t(m_width) * m_height;
+		std::vector<SColorStatistics> chunkStatistics((pixelCount + StatisticsChunkPixels - 1ull) / StatisticsChunkPixels);
+		m_pool->parallelFor(chunkStatistics.size(), [&](size_t i)
+		{
+			accumulateColorStatistics(m_inputFormats[0], inputs[0], i * StatisticsChunkPixels, std::min<size_t>((i + 1ull) * StatisticsChunkPixels, pixelCount), chunkStatistics[i]);
+		});
+
+		SColorStatistics statistics;
+		for (const auto& chunk : chunkStatistics)
+			statistics.merge(chunk);
+		frameParameters = statistics.getHDRParameters();
+		hdrParameters = &frameParameters;
+	}
+
+	if (!m_tileHashes.empty())
+		hdrParameters = &holdHDRParameters(*hdrParameters);
+	if (!onRowsDone)
+	{
+		if (!denoiseTiles(m_activeTiles.data(), m_activeTiles.size(), inputs, 0u, *hdrParameters))
+			return false;
+		compositeRows(0u, m_height, output);
+		return true;
+	}
+
+	/*
+		Whichever worker finishes a tile composites the tile rows that completed in order since, the rows around a seam wait for the
+		tile row below. Workers that find another one at it go back to their tiles, it picks up what they finished before letting go.
+	*/
+	const uint32_t tileRowCount = getTileRowCount();
+	std::unique_ptr<std::atomic<uint32_t>[]> pendingTiles(new std::atomic<uint32_t>[tileRowCount]);
+	for (uint32_t ty = 0u; ty < tileRowCount; ty++)
+		pendingTiles[ty] = 0u;
+	for (const uint32_t tile : m_activeTiles)
+		pendingTiles[tile / m_tileCountX]++;
+
+	std::mutex compositeMutex;
+	uint32_t nextTileRow = 0u;
+	uint32_t compositedEnd = 0u;
+	auto compositeCompleted = [&]() -> bool
+	{
+		for (; nextTileRow < tileRowCount && pendingTiles[nextTileRow] == 0u; nextTileRow++)
+		{
+			const uint32_t completedEnd = getCompletedRowEnd(nextTileRow);
+			compositeRows(compositedEnd, completedEnd, output);
+			if (compositedEnd < completedEnd && !onRowsDone(compositedEnd, completedEnd))
+				return false;
+			compositedEnd = completedEnd;
+		}
+		return true;
+	};
+
+	const bool success = denoiseTiles(m_activeTiles.data(), m_activeTiles.size(), inputs, 0u, *hdrParameters, [&](uint32_t tile) -> bool
+	{
+		pendingTiles[tile / m_tileCountX]--;
+		std::unique_lock<std::mutex> lock(compositeMutex, std::try_to_lock);
+		return !lock.owns_lock() || compositeCompleted();
+	});
+	// a tile finishing just as the compositing worker let go leaves its rows for here
+	return success && compositeCompleted();
+}
+
+bool CHostTiledDenoiser::denoiseTileRow(uint32_t tileRow, const void* const* inputs, uint32_t inputFirstRow, const SHDRParameters& hdrParameters)
+{
+	if (!m_width || tileRow >= getTileRowCount())
+		return false;
+
+	// banded there's no region of interest, every tile is active
+	return denoiseTiles(m_activeTiles.data() + size_t(tileRow) * m_tileCountX, m_tileCountX, inputs, inputFirstRow, hdrParameters);
+}
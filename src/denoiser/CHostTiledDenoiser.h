@@ -0,0 +1,205 @@
+#ifndef __DBR_C_HOST_TILED_DENOISER_H_INCLUDED__
+#define __DBR_C_HOST_TILED_DENOISER_H_INCLUDED__
+
+#include "denoiser/CDenoiserSession.h"
+#include "denoiser/CTileScheduler.h"
+#include "core/CThreadPool.h"
+
+#include <vector>
+#include <functional>
+
+namespace dbr
+{
+
+/*
+	Splits frames into overlapping tiles on the host, denoises every tile as a whole image and blends them back together.
+
+	Unlike a backend's own tiling (`optixUtilDenoiserInvokeTiled`) this works the same for every backend, can spread
+	the tiles over several sessions (i.e. one per GPU or CPU stand-in) and blends the overlaps with a feathered ramp
+	instead of a hard cut, so smaller overlaps still don't leave visible seams.
+
+	Every tile is padded by `overlap` on each side, what falls outside the image is the replicated border,
+	so all tiles have the same size and the sessions only ever get prepared once per frame resolution.
+	The HDR intensity has to come from the whole frame, otherwise every tile would get exposed differently,
+	so it gets computed on the host if `denoise` isn't given it.
+*/
+class CHostTiledDenoiser
+{
+	public:
+		//! Where a tile goes in the output, its padded input starts `overlap` pixels up and left of it
+		struct STileRegion
+		{
+			uint32_t x = 0u;
+			uint32_t y = 0u;
+			uint32_t width = 0u;
+			uint32_t height = 0u;
+		};
+
+		struct SConfig
+		{
+			static constexpr uint32_t DefaultFeather = ~0u;
+
+			//! of the part of the output a tile is responsible for, clamped to the image
+			uint32_t tileWidth = 512u;
+			uint32_t tileHeight = 512u;
+			//! 0 uses the overlap the backend asks for
+			uint32_t overlap = 0u;
+			//! width of the linear blend across each seam, clamped to twice the overlap, 0 is a hard cut, by default as wide as the overlap
+			uint32_t feather = DefaultFeather;
+			//! tiles whose padded inputs hash the same as in the previous frame keep its denoised output, not when banded
+			bool tileCache = false;
+			/*
+				With the tile cache HDR parameters within this relative change of the ones used for the previous frame are kept,
+				otherwise a change anywhere in the frame would shift the exposure of every tile and none could be reused.
+			*/
+			float tileCacheHDRTolerance = 0.01f;
+			/*
+				Only the tiles blending into this rectangle get denoised and only its pixels get composited, the rest of the output
+				is left as it was. Its pixels come out exactly as when denoising the whole frame. Empty is the whole frame, so is banded.
+			*/
+			STileRegion regionOfInterest = {};
+		};
+
+		struct STileCacheStatistics
+		{
+			uint32_t hits = 0u;
+			uint32_t misses = 0u;
+			double missMilliseconds = 0.0;
+
+			inline double getAverageMissMilliseconds() const { return misses ? missMilliseconds / misses : 0.0; }
+			//! What the hits would have cost at the average time of a miss
+			inline double getSavedMilliseconds() const { return hits * getAverageMissMilliseconds(); }
+			inline double getHitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+		};
+
+		//! All `sessions` have to have the same output format, every one of them denoises tiles on its own thread of `pool`
+		CHostTiledDenoiser(const std::vector<CDenoiserSession*>& sessions, const SConfig& config, CThreadPool* pool, CProfiler* profiler = nullptr);
+		~CHostTiledDenoiser();
+
+		CHostTiledDenoiser(const CHostTiledDenoiser&) = delete;
+		CHostTiledDenoiser& operator=(const CHostTiledDenoiser&) = delete;
+
+		//! Returns true straight away if nothing changed since the last call.
+		//! With `banded` only the outputs of two tile rows are kept, so frames have to go through `denoiseTileRow` instead of `denoise`.
+		bool prepare(uint32_t width, uint32_t height, const CDenoiserSession::input_formats_t& inputFormats, bool banded = false);
+		//! Gets output rows `[beginY,endY)` that are final, calls never overlap and come top to bottom, returning false fails the frame
+		using rows_done_callback_t = std::function<bool(uint32_t, uint32_t)>;
+		/*
+			Same contract as `CDenoiserSession::denoise` for the whole frame. With `onRowsDone` rows get composited as soon as
+			every tile blending into them is done and handed over while later tiles are still being denoised, i.e. to stream them to disk.
+			The result is the same either way.
+		*/
+		bool denoise(const void* const* inputs, void* output, const SHDRParameters* hdrParameters = nullptr, const rows_done_callback_t& onRowsDone = {});
+
+		/*
+			Out of core denoising for frames that don't fit in host memory, one band of input rows at a time.
+			Tile rows have to come in order, `inputs` hold the image rows `getTileRowInputRows` returns, starting at `inputFirstRow`.
+			Afterwards the output rows up to `getCompletedRowEnd` can be composited, the rows around the next seam need the next tile row too.
+		*/
+		bool denoiseTileRow(uint32_t tileRow, const void* const* inputs, uint32_t inputFirstRow, const SHDRParameters& hdrParameters);
+		//! Image rows `[outBegin,outEnd)` the padded tiles of `tileRow` read
+		void getTileRowInputRows(uint32_t tileRow, uint32_t& outBegin, uint32_t& outEnd) const;
+		//! Output rows no tile row after `tileRow` contributes to
+		inline uint32_t getCompletedRowEnd(uint32_t tileRow) const { return tileRow + 1u < getTileRowCount() ? m_rowSpans[tileRow + 1u].begin : m_height; }
+		//! Blends the rows `[beginY,endY)` into `output`, which holds the image from row `outputFirstRow` on, from the tile rows still kept
+		void compositeRows(uint32_t beginY, uint32_t endY, void* output, uint32_t outputFirstRow = 0u);
+
+		inline const SConfig& getConfig() const { return m_config; }
+		inline uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+		//! How many times the tiling had to be worked out again, like `CDenoiserSession::getPrepareCount`
+		inline uint32_t getPrepareCount() const { return m_prepareCount; }
+		inline const std::vector<STileRegion>& getTiles() const { return m_tiles; }
+		//! Indices into `getTiles` of the ones that get denoised, all of them without a region of interest
+		inline const std::vector<uint32_t>& getActiveTiles() const { return m_activeTiles; }
+		//! Clamped to the image
+		inline const STileRegion& getRegionOfInterest() const { return m_regionOfInterest; }
+		inline uint32_t getTileRowCount() const { return static_cast<uint32_t>(m_rowSpans.size()); }
+		inline uint32_t getOverlap() const { return m_overlap; }
+		inline uint32_t getFeather() const { return m_feather; }
+		inline uint32_t getPaddedTileWidth() const { return m_tileWidth + m_overlap * 2u; }
+		inline uint32_t getPaddedTileHeight() const { return m_tileHeight + m_overlap * 2u; }
+		inline E_PIXEL_FORMAT getOutputFormat() const { return m_workers.front().session->getConfig().format; }
+		//! How many input layers every tile reads, the same for all sessions
+		inline E_INPUT_KIND getInputKind() const { return m_workers.front().session->getConfig().inputKind; }
+		//! Denoised tiles and the padded tile inputs of every worker
+		size_t getHostMemoryConsumption() const;
+		//! Per worker utilization and tile latencies, worker `i` denoises with the `i`-th session
+		inline const CTileScheduler& getScheduler() const { return m_scheduler; }
+		//! Of every frame since the cache was created and of the last frame alone
+		inline const STileCacheStatistics& getTileCacheStatistics() const { return m_tileCacheStatistics; }
+		inline const STileCacheStatistics& getFrameTileCacheStatistics() const { return m_frameTileCacheStatistics; }
+
+	private:
+		//! Non zero blend weights of one tile along one axis
+		struct SWeightSpan
+		{
+			uint32_t begin = 0u;
+			std::vector<float> weights;
+
+			inline uint32_t end() const { return begin + static_cast<uint32_t>(weights.size()); }
+		};
+
+		struct SWorker
+		{
+			CDenoiserSession* session = nullptr;
+			//! the padded input layers of the tile being denoised, from the session backend's `allocateHost`
+			uint8_t* inputs = nullptr;
+			size_t capacity = 0ull;
+		};
+
+		static std::vector<SWeightSpan> computeWeightSpans(uint32_t size, uint32_t tileSize, uint32_t feather);
+
+		//! Denoises `tiles` spread over all workers, `inputs` start at image row `inputFirstRow`, `onTileDone` gets called by the worker that finished a tile
+		bool denoiseTiles(const uint32_t* tiles, size_t tileCount, const void* const* inputs, uint32_t inputFirstRow, const SHDRParameters& hdrParameters,
+			const std::function<bool(uint32_t)>& onTileDone = {});
+		//! The previous frame's parameters if `hdrParameters` are within the tolerance of them
+		const SHDRParameters& holdHDRParameters(const SHDRParameters& hdrParameters);
+		void extractTile(const void* const* inputs, uint32_t inputFirstRow, const STileRegion& tile, uint8_t* outInputs) const;
+		void compositeRowRange(uint32_t beginY, uint32_t endY, void* output, uint32_t outputFirstRow) const;
+		//! Tile rows take turns in the kept slots when banded
+		inline uint8_t* getTileOutput(size_t tile) const
+		{
+			const size_t slot = (tile / m_tileCountX) % m_residentTileRows * m_tileCountX + tile % m_tileCountX;
+			return m_tileOutputs.get() + slot * getTileOutputSize();
+		}
+		inline size_t getPaddedLayerSize(uint32_t layer) const { return size_t(getPixelFormatStride(m_inputFormats[layer])) * getPaddedTileWidth() * getPaddedTileHeight(); }
+		inline size_t getTileOutputSize() const { return size_t(getPixelFormatStride(getOutputFormat())) * getPaddedTileWidth() * getPaddedTileHeight(); }
+
+		std::vector<SWorker> m_workers;
+		CTileScheduler m_scheduler;
+		const SConfig m_config;
+		CThreadPool* const m_pool;
+		CProfiler* const m_profiler;
+
+		uint32_t m_width = 0u;
+		uint32_t m_height = 0u;
+		uint32_t m_prepareCount = 0u;
+		CDenoiserSession::input_formats_t m_inputFormats = {};
+		uint32_t m_tileWidth = 0u;
+		uint32_t m_tileHeight = 0u;
+		uint32_t m_overlap = 0u;
+		uint32_t m_feather = 0u;
+		uint32_t m_tileCountX = 0u;
+		//! all of them unless banded
+		uint32_t m_residentTileRows = 0u;
+		bool m_banded = false;
+		std::vector<STileRegion> m_tiles;
+		STileRegion m_regionOfInterest;
+		std::vector<uint32_t> m_activeTiles;
+		std::vector<uint8_t> m_tileActive;
+		std::vector<SWeightSpan> m_columnSpans;
+		std::vector<SWeightSpan> m_rowSpans;
+		//! denoised padded tiles are kept until all the rows they contribute to can be composited in one deterministic pass, grow only
+		std::unique_ptr<uint8_t[]> m_tileOutputs;
+		size_t m_tileOutputCapacity = 0ull;
+		//! of the padded inputs and HDR parameters each tile output in `m_tileOutputs` was denoised from, 0 for none
+		std::vector<uint64_t> m_tileHashes;
+		bool m_hasHeldHDRParameters = false;
+		SHDRParameters m_heldHDRParameters;
+		STileCacheStatistics m_tileCacheStatistics;
+		STileCacheStatistics m_frameTileCacheStatistics;
+};
+
+}
+
+#endif // __DBR_C_HOST_TILED_DENOISER_H_INCLUDED__
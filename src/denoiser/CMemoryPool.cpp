@@ -0,0 +1,120 @@
+#include "denoiser/CMemoryPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace dbr;
+
+CMemoryPool::CMemoryPool(IMemoryAllocator* upstream, size_t maxCachedBytes) : m_upstream(upstream), m_maxCachedBytes(maxCachedBytes)
+{
+	assert(m_upstream);
+}
+
+size_t CMemoryPool::getSizeClass(size_t size)
+{
+	if (size <= MinClassSize)
+		return MinClassSize;
+
+	// sizes in `(2^e,2^(e+1)]` round up to a multiple of `2^e/4`
+	uint32_t exponent = 0u;
+	for (size_t rest = size - 1ull; rest > 1ull; rest >>= 1ull)
+		exponent++;
+	const size_t step = (1ull << exponent) / 4ull;
+	return (size + step - 1ull) / step * step;
+}
+
+address_t CMemoryPool::allocate(size_t size)
+{
+	if (!size)
+		return 0ull;
+
+	const size_t classSize = getSizeClass(size);
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	address_t retval = 0ull;
+	auto found = m_cachedBlocks.find(classSize);
+	if (found != m_cachedBlocks.end())
+	{
+		retval = found->second.back();
+		found->second.pop_back();
+		if (found->second.empty())
+			m_cachedBlocks.erase(found);
+		m_statistics.cachedBytes -= classSize;
+		m_statistics.reuses++;
+	}
+	else
+	{
+		retval = m_upstream->allocate(classSize);
+		// the cache might be what's in the way
+		if (!retval && m_statistics.cachedBytes)
+		{
+			trimLocked(0ull);
+			retval = m_upstream->allocate(classSize);
+		}
+		if (!retval)
+			return 0ull;
+		m_statistics.upstreamAllocations++;
+	}
+
+	m_usedBlocks.emplace(retval, SBlock{ size,classSize });
+	m_statistics.allocations++;
+	m_statistics.requestedBytes += size;
+	m_statistics.usedBytes += classSize;
+	m_statistics.peakUsedBytes = std::max(m_statistics.peakUsedBytes, m_statistics.usedBytes);
+	m_statistics.peakReservedBytes = std::max(m_statistics.peakReservedBytes, m_statistics.usedBytes + m_statistics.cachedBytes);
+	return retval;
+}
+
+void CMemoryPool::deallocate(address_t address)
+{
+	if (!address)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = m_usedBlocks.find(address);
+	assert(found != m_usedBlocks.end());
+	if (found == m_usedBlocks.end())
+		return;
+
+	const SBlock block = found->second;
+	m_usedBlocks.erase(found);
+	m_statistics.requestedBytes -= block.requested;
+	m_statistics.usedBytes -= block.classSize;
+
+	m_cachedBlocks[block.classSize].push_back(address);
+	m_statistics.cachedBytes += block.classSize;
+	if (m_statistics.cachedBytes > m_maxCachedBytes)
+		trimLocked(m_maxCachedBytes);
+}
+
+size_t CMemoryPool::getAvailableMemory() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_upstream->getAvailableMemory() + m_statistics.cachedBytes;
+}
+
+void CMemoryPool::trim(size_t maxCachedBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	trimLocked(maxCachedBytes);
+}
+
+void CMemoryPool::trimLocked(size_t maxCachedBytes)
+{
+	while (m_statistics.cachedBytes > maxCachedBytes && !m_cachedBlocks.empty())
+	{
+		auto biggest = std::prev(m_cachedBlocks.end());
+		m_upstream->deallocate(biggest->second.back());
+		biggest->second.pop_back();
+		m_statistics.cachedBytes -= biggest->first;
+		m_statistics.upstreamDeallocations++;
+		if (biggest->second.empty())
+			m_cachedBlocks.erase(biggest);
+	}
+}
+
+CMemoryPool::SStatistics CMemoryPool::getStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_statistics;
+}
@@ -0,0 +1,95 @@
+#ifndef __DBR_C_MEMORY_POOL_H_INCLUDED__
+#define __DBR_C_MEMORY_POOL_H_INCLUDED__
+
+#include "denoiser/IMemoryAllocator.h"
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+namespace dbr
+{
+
+/*
+	Keeps freed blocks of an upstream allocator in size classes for the next allocation of about the same size.
+
+	Frames, tiles and denoiser instances come and go with resolutions and tile shapes, and every upstream allocation
+	(`cuMemAlloc`, `cuMemHostAlloc`) is a synchronizing driver call, so reusing blocks saves more than the memory.
+	Sizes round up to one of four classes per power of two, that wastes less than 25% of a block and lets a request
+	reuse a block freed by a request a few percent bigger or smaller.
+	Cached blocks beyond `maxCachedBytes` go back upstream, biggest first, and all of them do before giving up
+	on an upstream allocation that failed.
+*/
+class CMemoryPool final : public IMemoryAllocator
+{
+	public:
+		static constexpr size_t MinClassSize = 256ull;
+
+		struct SStatistics
+		{
+			uint64_t allocations = 0ull;
+			//! allocations served from a cached block
+			uint64_t reuses = 0ull;
+			uint64_t upstreamAllocations = 0ull;
+			uint64_t upstreamDeallocations = 0ull;
+			//! in use, as requested and as rounded up to the size class
+			size_t requestedBytes = 0ull;
+			size_t usedBytes = 0ull;
+			//! freed and kept for reuse
+			size_t cachedBytes = 0ull;
+			size_t peakUsedBytes = 0ull;
+			//! in use plus cached, what the pool held upstream at most
+			size_t peakReservedBytes = 0ull;
+
+			inline double getReuseRate() const { return allocations ? double(reuses) / double(allocations) : 0.0; }
+			//! Share of the blocks in use lost to rounding up to size classes
+			inline double getInternalFragmentation() const { return usedBytes ? 1.0 - double(requestedBytes) / double(usedBytes) : 0.0; }
+			//! Share of the memory held upstream sitting idle in the cache
+			inline double getIdleFraction() const { return usedBytes + cachedBytes ? double(cachedBytes) / double(usedBytes + cachedBytes) : 0.0; }
+		};
+
+		//! `upstream` has to outlive the pool
+		CMemoryPool(IMemoryAllocator* upstream, size_t maxCachedBytes);
+		//! Blocks still in use at that point are the owners' to leak
+		~CMemoryPool() { trim(0ull); }
+
+		CMemoryPool(const CMemoryPool&) = delete;
+		CMemoryPool& operator=(const CMemoryPool&) = delete;
+
+		address_t allocate(size_t size) override;
+		void deallocate(address_t address) override;
+		//! Upstream's plus what's cached, cached blocks are as good as free
+		size_t getAvailableMemory() const override;
+
+		//! Gives cached blocks back upstream, biggest first, until no more than `maxCachedBytes` are left
+		void trim(size_t maxCachedBytes);
+
+		//! The size a request of `size` bytes gets rounded up to
+		static size_t getSizeClass(size_t size);
+
+		SStatistics getStatistics() const;
+
+	private:
+		struct SBlock
+		{
+			size_t requested;
+			size_t classSize;
+		};
+
+		//! `m_mutex` has to be held
+		void trimLocked(size_t maxCachedBytes);
+
+		IMemoryAllocator* const m_upstream;
+		const size_t m_maxCachedBytes;
+
+		mutable std::mutex m_mutex;
+		//! by size class, the most recently freed block of a class gets reused first since it's the likeliest to still be in cache
+		std::map<size_t, std::vector<address_t>> m_cachedBlocks;
+		std::unordered_map<address_t, SBlock> m_usedBlocks;
+		SStatistics m_statistics;
+};
+
+}
+
+#endif // __DBR_C_MEMORY_POOL_H_INCLUDED__
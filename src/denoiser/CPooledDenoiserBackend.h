@@ -0,0 +1,82 @@
+#ifndef __DBR_C_POOLED_DENOISER_BACKEND_H_INCLUDED__
+#define __DBR_C_POOLED_DENOISER_BACKEND_H_INCLUDED__
+
+#include "denoiser/CMemoryPool.h"
+
+namespace dbr
+{
+
+/*
+	Puts a `CMemoryPool` in front of the device and the host memory of a backend, everything else goes straight through.
+
+	Sessions, denoiser caches, host tiles and frame staging all allocate through the backend they're given,
+	so wrapping it is all it takes for them to draw from the pools.
+*/
+class CPooledDenoiserBackend final : public IDenoiserBackend
+{
+	public:
+		//! Each pool keeps up to `maxCachedBytes` of freed blocks
+		CPooledDenoiserBackend(std::unique_ptr<IDenoiserBackend>&& backend, size_t maxCachedBytes)
+			: m_backend(std::move(backend)), m_deviceMemory(m_backend.get()), m_hostMemory(m_backend.get()),
+			m_devicePool(&m_deviceMemory, maxCachedBytes), m_hostPool(&m_hostMemory, maxCachedBytes) {}
+		~CPooledDenoiserBackend() override = default;
+
+		//! The wrapped backend's, tuning profiles and messages shouldn't tell the difference
+		std::string_view getName() const override { return m_backend->getName(); }
+
+		address_t allocate(size_t size) override { return m_devicePool.allocate(size); }
+		void deallocate(address_t address) override { m_devicePool.deallocate(address); }
+		bool copyHostToDevice(address_t dst, const void* src, size_t size) override { return m_backend->copyHostToDevice(dst, src, size); }
+		bool copyDeviceToHost(void* dst, address_t src, size_t size) override { return m_backend->copyDeviceToHost(dst, src, size); }
+		bool synchronize() override { return m_backend->synchronize(); }
+		void* allocateHost(size_t size) override { return reinterpret_cast<void*>(m_hostPool.allocate(size)); }
+		void deallocateHost(void* ptr) override { m_hostPool.deallocate(reinterpret_cast<address_t>(ptr)); }
+		size_t getAvailableMemory() const override { return m_devicePool.getAvailableMemory(); }
+
+		denoiser_t createDenoiser(E_MODEL_KIND model, E_INPUT_KIND inputKind) override { return m_backend->createDenoiser(model, inputKind); }
+		bool computeMemoryRequirements(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements) const override
+		{
+			return m_backend->computeMemoryRequirements(denoiser, tileWidth, tileHeight, outRequirements);
+		}
+		bool setup(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, address_t state, size_t stateSize, address_t scratch, size_t scratchSize) override
+		{
+			return m_backend->setup(denoiser, tileWidth, tileHeight, state, stateSize, scratch, scratchSize);
+		}
+
+		size_t getIntensityScratchSize(uint32_t width, uint32_t height) const override { return m_backend->getIntensityScratchSize(width, height); }
+		bool computeIntensity(denoiser_t denoiser, const SImage2D& input, address_t outIntensity, address_t scratch, size_t scratchSize) override
+		{
+			return m_backend->computeIntensity(denoiser, input, outIntensity, scratch, scratchSize);
+		}
+
+		bool invokeTiled(
+			denoiser_t denoiser,
+			const SDenoiserParams& params,
+			address_t state, size_t stateSize,
+			const SImage2D* inputs, uint32_t inputCount,
+			const SImage2D& output,
+			address_t scratch, size_t scratchSize,
+			uint32_t overlap, uint32_t tileWidth, uint32_t tileHeight
+		) override
+		{
+			return m_backend->invokeTiled(denoiser, params, state, stateSize, inputs, inputCount, output, scratch, scratchSize, overlap, tileWidth, tileHeight);
+		}
+
+		void destroyDenoiser(denoiser_t denoiser) override { m_backend->destroyDenoiser(denoiser); }
+
+		inline IDenoiserBackend* getBackend() const { return m_backend.get(); }
+		inline const CMemoryPool& getDevicePool() const { return m_devicePool; }
+		inline const CMemoryPool& getHostPool() const { return m_hostPool; }
+
+	private:
+		// declared so the pools go before the backend they give their blocks back to
+		std::unique_ptr<IDenoiserBackend> m_backend;
+		CBackendMemoryAllocator m_deviceMemory;
+		CBackendHostMemoryAllocator m_hostMemory;
+		CMemoryPool m_devicePool;
+		CMemoryPool m_hostPool;
+};
+
+}
+
+#endif // __DBR_C_POOLED_DENOISER_BACKEND_H_INCLUDED__
@@ -0,0 +1,152 @@
+#include "denoiser/CTilePlanner.h"
+
+#include <algorithm>
+#include <tuple>
+
+using namespace dbr;
+
+namespace
+{
+
+inline uint32_t divideRoundUp(const uint32_t numerator, const uint32_t denominator)
+{
+	return (numerator + denominator - 1u) / denominator;
+}
+
+// tiles smaller than the image get rounded up to the granularity, which never makes them bigger than the image
+inline uint32_t getTileExtent(const uint32_t imageExtent, const uint32_t tileCount, const uint32_t granularity)
+{
+	const uint32_t extent = divideRoundUp(imageExtent, tileCount);
+	if (tileCount == 1u)
+		return extent;
+	return std::min(divideRoundUp(extent, granularity) * granularity, imageExtent);
+}
+
+void fillPlan(const CTilePlanner::SRequest& request, const uint32_t tileWidth, const uint32_t tileHeight, const SDenoiserMemoryRequirements& requirements, STilePlan& outPlan)
+{
+	outPlan = {};
+	outPlan.imageWidth = request.width;
+	outPlan.imageHeight = request.height;
+	outPlan.tileWidth = tileWidth;
+	outPlan.tileHeight = tileHeight;
+	outPlan.overlap = request.overlap ? request.overlap : requirements.overlapWindowSizeInPixels;
+	outPlan.stateSizeInBytes = requirements.stateSizeInBytes;
+	outPlan.scratchSizeInBytes = requirements.scratchSizeInBytes;
+	outPlan.pixelBufferSizeInBytes = CTilePlanner::getPixelBufferSize(request);
+	outPlan.tiles = CTilePlanner::makeTiles(request.width, request.height, tileWidth, tileHeight, outPlan.overlap);
+}
+
+}
+
+size_t CTilePlanner::getPixelBufferSize(const SRequest& request)
+{
+	const size_t pixelCount = size_t(request.width) * request.height;
+	size_t retval = pixelCount * getPixelFormatStride(request.format) + sizeof(float);
+	for (uint32_t k = 0u; k < request.inputCount; k++)
+		retval += pixelCount * getPixelFormatStride(request.inputFormats[k]);
+	return retval;
+}
+
+std::vector<STile> CTilePlanner::makeTiles(uint32_t width, uint32_t height, uint32_t tileWidth, uint32_t tileHeight, uint32_t overlap)
+{
+	std::vector<STile> tiles;
+	if (!width || !height || !tileWidth || !tileHeight)
+		return tiles;
+
+	tiles.reserve(size_t(divideRoundUp(width, tileWidth)) * divideRoundUp(height, tileHeight));
+	for (uint32_t y = 0u; y < height; y += tileHeight)
+	for (uint32_t x = 0u; x < width; x += tileWidth)
+	{
+		STile& tile = tiles.emplace_back();
+		tile.x = x;
+		tile.y = y;
+		tile.width = std::min(tileWidth, width - x);
+		tile.height = std::min(tileHeight, height - y);
+		tile.inputX = x > overlap ? x - overlap : 0u;
+		tile.inputY = y > overlap ? y - overlap : 0u;
+		tile.inputWidth = std::min(x + tile.width + overlap, width) - tile.inputX;
+		tile.inputHeight = std::min(y + tile.height + overlap, height) - tile.inputY;
+	}
+	return tiles;
+}
+
+bool CTilePlanner::planFixed(const SRequest& request, uint32_t tileWidth, uint32_t tileHeight, const memory_requirements_func_t& getRequirements, STilePlan& outPlan)
+{
+	if (!request.width || !request.height || !tileWidth || !tileHeight)
+		return false;
+
+	// the session never sets up for tiles larger than the frame
+	tileWidth = std::min(tileWidth, request.width);
+	tileHeight = std::min(tileHeight, request.height);
+
+	SDenoiserMemoryRequirements requirements;
+	if (!getRequirements(tileWidth, tileHeight, requirements))
+		return false;
+
+	fillPlan(request, tileWidth, tileHeight, requirements, outPlan);
+	return true;
+}
+
+bool CTilePlanner::plan(const SRequest& request, const memory_requirements_func_t& getRequirements, STilePlan& outPlan)
+{
+	if (!request.width || !request.height || !request.granularity)
+		return false;
+
+	// the full frame buffers don't depend on the tiling at all
+	const size_t pixelBufferSize = getPixelBufferSize(request);
+	if (pixelBufferSize > request.memoryBudget)
+		return false;
+
+	// every distinct tile shape a grid of `countX` by `countY` tiles produces, the tile extent decreases monotonically with the count
+	struct SCandidate
+	{
+		uint32_t width, height, tileCount;
+	};
+	std::vector<SCandidate> candidates;
+	{
+		std::vector<uint32_t> widths, heights;
+		auto collect = [&request](const uint32_t imageExtent, std::vector<uint32_t>& outExtents)
+		{
+			for (uint32_t count = 1u; count <= imageExtent; count++)
+			{
+				const uint32_t extent = getTileExtent(imageExtent, count, request.granularity);
+				if (count > 1u && extent < request.minTileSize)
+					break;
+				if (outExtents.empty() || extent < outExtents.back())
+					outExtents.push_back(extent);
+				if (extent <= request.granularity)
+					break;
+			}
+		};
+		collect(request.width, widths);
+		collect(request.height, heights);
+
+		for (const uint32_t width : widths)
+		for (const uint32_t height : heights)
+			candidates.push_back({ width,height,divideRoundUp(request.width,width) * divideRoundUp(request.height,height) });
+	}
+
+	// largest tiles first, on a tie the fewest tiles, then the squarest
+	std::sort(candidates.begin(), candidates.end(), [](const SCandidate& lhs, const SCandidate& rhs)
+	{
+		const uint64_t lhsArea = uint64_t(lhs.width) * lhs.height;
+		const uint64_t rhsArea = uint64_t(rhs.width) * rhs.height;
+		const uint32_t lhsSkew = std::max(lhs.width, lhs.height) - std::min(lhs.width, lhs.height);
+		const uint32_t rhsSkew = std::max(rhs.width, rhs.height) - std::min(rhs.width, rhs.height);
+		return std::tie(rhsArea, lhs.tileCount, lhsSkew) < std::tie(lhsArea, rhs.tileCount, rhsSkew);
+	});
+
+	for (const auto& candidate : candidates)
+	{
+		SDenoiserMemoryRequirements requirements;
+		if (!getRequirements(candidate.width, candidate.height, requirements))
+			continue;
+
+		if (requirements.stateSizeInBytes + requirements.scratchSizeInBytes + pixelBufferSize > request.memoryBudget)
+			continue;
+
+		fillPlan(request, candidate.width, candidate.height, requirements, outPlan);
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,86 @@
+#ifndef __DBR_C_TILE_PLANNER_H_INCLUDED__
+#define __DBR_C_TILE_PLANNER_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <array>
+#include <vector>
+#include <functional>
+
+namespace dbr
+{
+
+struct STile
+{
+	//! the part of the output this tile is responsible for
+	uint32_t x = 0u;
+	uint32_t y = 0u;
+	uint32_t width = 0u;
+	uint32_t height = 0u;
+	//! the part of the input the denoiser sees, the above grown by the overlap and clamped to the image
+	uint32_t inputX = 0u;
+	uint32_t inputY = 0u;
+	uint32_t inputWidth = 0u;
+	uint32_t inputHeight = 0u;
+};
+
+struct STilePlan
+{
+	uint32_t imageWidth = 0u;
+	uint32_t imageHeight = 0u;
+	uint32_t tileWidth = 0u;
+	uint32_t tileHeight = 0u;
+	uint32_t overlap = 0u;
+	std::vector<STile> tiles;
+
+	size_t stateSizeInBytes = 0ull;
+	size_t scratchSizeInBytes = 0ull;
+	//! full frame input and output buffers plus the intensity value
+	size_t pixelBufferSizeInBytes = 0ull;
+
+	inline size_t getTotalSizeInBytes() const { return stateSizeInBytes + scratchSizeInBytes + pixelBufferSizeInBytes; }
+};
+
+/*
+	Picks the tile size for a frame from a memory budget instead of hand tuned constants.
+
+	The backend is only asked about memory requirements, so plans for any resolution can be produced
+	and checked on a machine without the GPU they are meant for.
+*/
+class CTilePlanner
+{
+	public:
+		using memory_requirements_func_t = std::function<bool(uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements)>;
+
+		struct SRequest
+		{
+			uint32_t width = 0u;
+			uint32_t height = 0u;
+			//! of the output
+			E_PIXEL_FORMAT format = EPF_HALF4;
+			uint32_t inputCount = EIK_RGB_ALBEDO_NORMAL;
+			std::array<E_PIXEL_FORMAT, EIK_RGB_ALBEDO_NORMAL> inputFormats = { EPF_HALF4,EPF_HALF4,EPF_HALF4 };
+			//! everything the frame needs has to fit: state, scratch, inputs, output
+			size_t memoryBudget = 0ull;
+			//! 0 takes the backend's `overlapWindowSizeInPixels`
+			uint32_t overlap = 0u;
+			//! tile dimensions are multiples of this, unless they cover the whole image
+			uint32_t granularity = 32u;
+			uint32_t minTileSize = 64u;
+		};
+
+		//! Largest tile (by area, then by fewest tiles) whose setup fits the budget, returns false if not even the smallest one does
+		static bool plan(const SRequest& request, const memory_requirements_func_t& getRequirements, STilePlan& outPlan);
+
+		//! Plan for a fixed tile size, ignoring the budget
+		static bool planFixed(const SRequest& request, uint32_t tileWidth, uint32_t tileHeight, const memory_requirements_func_t& getRequirements, STilePlan& outPlan);
+
+		//! Row-major tile list covering the image
+		static std::vector<STile> makeTiles(uint32_t width, uint32_t height, uint32_t tileWidth, uint32_t tileHeight, uint32_t overlap);
+
+		static size_t getPixelBufferSize(const SRequest& request);
+};
+
+}
+
+#endif // __DBR_C_TILE_PLANNER_H_INCLUDED__
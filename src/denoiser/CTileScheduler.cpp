@@ -0,0 +1,151 @@
+#include "denoiser/CTileScheduler.h"
+#include "core/Clock.h"
+#include "core/CProfiler.h"
+
+#include <atomic>
+#include <cassert>
+#include <algorithm>
+
+using namespace dbr;
+
+void CTileScheduler::SLatencyHistogram::add(double milliseconds)
+{
+	uint32_t bucket = 0u;
+	while (bucket + 1u < BucketCount && milliseconds > getBucketBound(bucket))
+		bucket++;
+	counts[bucket]++;
+	count++;
+	maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+}
+
+void CTileScheduler::SLatencyHistogram::merge(const SLatencyHistogram& other)
+{
+	for (uint32_t i = 0u; i < BucketCount; i++)
+		counts[i] += other.counts[i];
+	count += other.count;
+	maxMilliseconds = std::max(maxMilliseconds, other.maxMilliseconds);
+}
+
+double CTileScheduler::SLatencyHistogram::getQuantileBound(double fraction) const
+{
+	if (!count)
+		return 0.0;
+
+	const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(fraction * double(count) + 0.5), 1ull);
+	uint64_t seen = 0ull;
+	for (uint32_t i = 0u; i < BucketCount; i++)
+	{
+		seen += counts[i];
+		if (seen >= rank)
+			return i + 1u < BucketCount ? std::min(getBucketBound(i), maxMilliseconds) : maxMilliseconds;
+	}
+	return maxMilliseconds;
+}
+
+CTileScheduler::CTileScheduler(uint32_t workerCount) : m_deques(workerCount)
+{
+	assert(workerCount);
+	m_statistics.workers.resize(workerCount);
+}
+
+void CTileScheduler::resetStatistics()
+{
+	m_statistics = {};
+	m_statistics.workers.resize(m_deques.size());
+}
+
+bool CTileScheduler::steal(uint32_t thief, size_t& outTile)
+{
+	while (true)
+	{
+		// the fullest deque is the one most likely to still be worked on when everyone else is done
+		uint32_t victim = thief;
+		size_t mostLeft = 0ull;
+		for (uint32_t w = 0u; w < getWorkerCount(); w++)
+		{
+			if (w == thief)
+				continue;
+			std::lock_guard<std::mutex> lock(m_deques[w].mutex);
+			const size_t left = m_deques[w].back - m_deques[w].front;
+			if (left > mostLeft)
+			{
+				mostLeft = left;
+				victim = w;
+			}
+		}
+		if (victim == thief)
+			return false;
+
+		// someone else might have got there first, then look again
+		SDeque& deque = m_deques[victim];
+		std::lock_guard<std::mutex> lock(deque.mutex);
+		if (deque.front != deque.back)
+		{
+			outTile = --deque.back;
+			return true;
+		}
+	}
+}
+
+bool CTileScheduler::run(CThreadPool& pool, size_t beginTile, size_t endTile, const std::function<bool(uint32_t, size_t)>& func)
+{
+	if (beginTile >= endTile)
+		return true;
+
+	const uint32_t workerCount = getWorkerCount();
+	const size_t tileCount = endTile - beginTile;
+	for (uint32_t w = 0u; w < workerCount; w++)
+	{
+		std::lock_guard<std::mutex> lock(m_deques[w].mutex);
+		m_deques[w].front = beginTile + tileCount * w / workerCount;
+		m_deques[w].back = beginTile + tileCount * (w + 1u) / workerCount;
+	}
+
+	const auto begin = steady_clock_t::now();
+	const uint32_t frameIndex = CProfiler::getCurrentFrame();
+	std::atomic<bool> failed = false;
+	std::vector<SWorkerStatistics> runStatistics(workerCount);
+	pool.parallelFor(workerCount, [&](size_t w)
+	{
+		CProfiler::setCurrentFrame(frameIndex);
+		const uint32_t worker = static_cast<uint32_t>(w);
+		SDeque& own = m_deques[worker];
+		SWorkerStatistics& statistics = runStatistics[worker];
+		while (!failed)
+		{
+			size_t tile;
+			bool stolen = false;
+			{
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (own.front != own.back)
+					tile = own.front++;
+				else
+					stolen = true;
+			}
+			if (stolen && !steal(worker, tile))
+				break;
+
+			const auto tileBegin = steady_clock_t::now();
+			if (!func(worker, tile))
+				failed = true;
+			const double milliseconds = getMilliseconds(tileBegin, steady_clock_t::now());
+
+			statistics.tileCount++;
+			statistics.stolenCount += stolen ? 1u : 0u;
+			statistics.busyMilliseconds += milliseconds;
+			statistics.latencies.add(milliseconds);
+		}
+	});
+
+	m_statistics.runCount++;
+	m_statistics.wallMilliseconds += getMilliseconds(begin, steady_clock_t::now());
+	for (uint32_t w = 0u; w < workerCount; w++)
+	{
+		SWorkerStatistics& statistics = m_statistics.workers[w];
+		statistics.tileCount += runStatistics[w].tileCount;
+		statistics.stolenCount += runStatistics[w].stolenCount;
+		statistics.busyMilliseconds += runStatistics[w].busyMilliseconds;
+		statistics.latencies.merge(runStatistics[w].latencies);
+	}
+	return !failed;
+}
@@ -0,0 +1,95 @@
+#ifndef __DBR_C_TILE_SCHEDULER_H_INCLUDED__
+#define __DBR_C_TILE_SCHEDULER_H_INCLUDED__
+
+#include "core/CThreadPool.h"
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+namespace dbr
+{
+
+/*
+	Spreads tiles over a fixed set of workers (one per backend instance, i.e. GPU, stream or CPU stand-in) with work stealing.
+
+	Every worker starts out owning an equal contiguous run of the tiles and works through it front to back, so consecutive
+	tiles of one worker share their overlap rows while they're still in cache. A worker that runs out steals the last tile
+	of whoever has the most left, so a straggler only ever holds up the frame by the one tile it's working on.
+	Each worker's deque is a range guarded by its own mutex, tiles take milliseconds at least so that's never contended.
+*/
+class CTileScheduler
+{
+	public:
+		//! Counts of tile latencies in power of two buckets
+		struct SLatencyHistogram
+		{
+			static constexpr uint32_t BucketCount = 20u;
+
+			//! bucket `i` counts latencies up to this, the last one everything above the one before it
+			static inline double getBucketBound(uint32_t bucket) { return 0.25 * double(1ull << bucket); }
+
+			void add(double milliseconds);
+			void merge(const SLatencyHistogram& other);
+			//! Upper bound of the bucket the `fraction` quantile falls into
+			double getQuantileBound(double fraction) const;
+
+			std::array<uint32_t, BucketCount> counts = {};
+			uint32_t count = 0u;
+			double maxMilliseconds = 0.0;
+		};
+
+		struct SWorkerStatistics
+		{
+			uint32_t tileCount = 0u;
+			//! tiles taken from another worker's deque
+			uint32_t stolenCount = 0u;
+			double busyMilliseconds = 0.0;
+			SLatencyHistogram latencies;
+		};
+
+		struct SStatistics
+		{
+			uint32_t runCount = 0u;
+			//! from handing out the first tile of every run to the last worker finishing it
+			double wallMilliseconds = 0.0;
+			std::vector<SWorkerStatistics> workers;
+
+			inline double getUtilization(uint32_t worker) const { return wallMilliseconds > 0.0 ? workers[worker].busyMilliseconds / wallMilliseconds : 0.0; }
+		};
+
+		explicit CTileScheduler(uint32_t workerCount);
+
+		CTileScheduler(const CTileScheduler&) = delete;
+		CTileScheduler& operator=(const CTileScheduler&) = delete;
+
+		/*
+			Calls `func(worker, tile)` for every tile in `[beginTile,endTile)`, every worker on its own task of `pool`.
+			Calls of the same worker never overlap. Once any call returns false no more tiles get handed out and neither does `run`.
+		*/
+		bool run(CThreadPool& pool, size_t beginTile, size_t endTile, const std::function<bool(uint32_t, size_t)>& func);
+
+		inline uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_deques.size()); }
+		//! Accumulated over every `run` since the last `resetStatistics`
+		inline const SStatistics& getStatistics() const { return m_statistics; }
+		void resetStatistics();
+
+	private:
+		struct SDeque
+		{
+			std::mutex mutex;
+			size_t front = 0ull;
+			size_t back = 0ull;
+		};
+
+		//! Returns false once every deque is empty
+		bool steal(uint32_t thief, size_t& outTile);
+
+		std::vector<SDeque> m_deques;
+		SStatistics m_statistics;
+};
+
+}
+
+#endif // __DBR_C_TILE_SCHEDULER_H_INCLUDED__
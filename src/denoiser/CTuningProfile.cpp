@@ -0,0 +1,74 @@
+#include "denoiser/CTuningProfile.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+
+using namespace dbr;
+
+bool CTuningProfile::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	std::vector<SEntry> entries;
+	std::string line;
+	for (uint32_t lineNumber = 1u; std::getline(file, line); lineNumber++)
+	{
+		const auto first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::istringstream tokens(line);
+		SEntry entry;
+		char separators[2] = {};
+		tokens >> entry.backend >> entry.width >> separators[0] >> entry.height >> entry.tileWidth >> separators[1] >> entry.tileHeight
+			>> entry.overlap >> entry.megapixelsPerSecond >> entry.memoryConsumption;
+		if (!tokens || separators[0] != 'x' || separators[1] != 'x' || !entry.width || !entry.height || !entry.tileWidth || !entry.tileHeight)
+		{
+			std::cerr << "ERROR: " << path << ":" << lineNumber << " expected `<backend> <width>x<height> <tile width>x<tile height> <overlap> <MPix/s> <bytes>`\n";
+			return false;
+		}
+		entries.push_back(std::move(entry));
+	}
+
+	m_entries = std::move(entries);
+	return true;
+}
+
+bool CTuningProfile::save(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	file << "# <backend> <width>x<height> <tile width>x<tile height> <overlap, 0 is the backend's> <MPix/s> <backend bytes>\n";
+	for (const auto& entry : m_entries)
+	{
+		file << entry.backend << " " << entry.width << "x" << entry.height << " " << entry.tileWidth << "x" << entry.tileHeight << " " << entry.overlap
+			<< " " << std::fixed << std::setprecision(3) << entry.megapixelsPerSecond << " " << entry.memoryConsumption << "\n";
+	}
+	file.flush();
+	return bool(file);
+}
+
+const CTuningProfile::SEntry* CTuningProfile::find(std::string_view backend, uint32_t width, uint32_t height) const
+{
+	for (const auto& entry : m_entries)
+	if (entry.backend == backend && entry.width == width && entry.height == height)
+		return &entry;
+	return nullptr;
+}
+
+void CTuningProfile::set(const SEntry& entry)
+{
+	for (auto& existing : m_entries)
+	if (existing.backend == entry.backend && existing.width == entry.width && existing.height == entry.height)
+	{
+		existing = entry;
+		return;
+	}
+	m_entries.push_back(entry);
+}
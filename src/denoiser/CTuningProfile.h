@@ -0,0 +1,52 @@
+#ifndef __DBR_C_TUNING_PROFILE_H_INCLUDED__
+#define __DBR_C_TUNING_PROFILE_H_INCLUDED__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	The fastest backend tiling measured on this machine per backend and resolution, what `CAutotuner` finds.
+
+	Stored as text, one entry per line as `<backend> <width>x<height> <tile width>x<tile height> <overlap> <MPix/s> <backend bytes>`,
+	blank lines and lines starting with `#` are skipped, so a profile can be read, diffed and edited by hand.
+*/
+class CTuningProfile
+{
+	public:
+		struct SEntry
+		{
+			std::string backend;
+			uint32_t width = 0u;
+			uint32_t height = 0u;
+			uint32_t tileWidth = 0u;
+			uint32_t tileHeight = 0u;
+			//! 0 is the overlap the backend asks for
+			uint32_t overlap = 0u;
+			//! what got measured, only informative
+			double megapixelsPerSecond = 0.0;
+			uint64_t memoryConsumption = 0ull;
+		};
+
+		//! Returns false if the file can't be read or has a malformed line, a missing profile isn't an error for callers to report
+		bool load(const std::string& path);
+		bool save(const std::string& path) const;
+
+		//! Returns nullptr if that resolution wasn't tuned for
+		const SEntry* find(std::string_view backend, uint32_t width, uint32_t height) const;
+		//! Replaces the entry of the same backend and resolution
+		void set(const SEntry& entry);
+
+		inline const std::vector<SEntry>& getEntries() const { return m_entries; }
+
+	private:
+		std::vector<SEntry> m_entries;
+};
+
+}
+
+#endif // __DBR_C_TUNING_PROFILE_H_INCLUDED__
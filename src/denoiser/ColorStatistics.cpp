@@ -0,0 +1,161 @@
+#include "denoiser/ColorStatistics.h"
+#include "core/half.h"
+
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+namespace dbr
+{
+
+namespace
+{
+
+// anything darker doesn't tell the exposure anything, also keeps the logarithm finite
+constexpr float MinValue = 1e-8f;
+// partial sums of a block are kept in float, short enough for that not to lose precision
+constexpr size_t BlockPixels = 256ull;
+
+// for positive normal floats, branch free so it vectorizes unlike `std::log`, relative error around 1e-7
+inline float fastLog(const float x)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(float));
+	// offsetting by the bits of sqrt(1/2) puts the mantissa in [sqrt(1/2),sqrt(2)) straight away, keeping the series argument small
+	const uint32_t offset = bits - 0x3f3504f3u;
+	const int32_t exponent = int32_t(offset) >> 23;
+	bits = (offset & 0x007fffffu) + 0x3f3504f3u;
+	float mantissa;
+	std::memcpy(&mantissa, &bits, sizeof(float));
+
+	// log(m) = 2 atanh((m-1)/(m+1))
+	const float f = (mantissa - 1.f) / (mantissa + 1.f);
+	const float f2 = f * f;
+	const float series = 1.f + f2 * (1.f / 3.f + f2 * (1.f / 5.f + f2 * (1.f / 7.f + f2 * (1.f / 9.f))));
+	return float(exponent) * 0.69314718f + 2.f * f * series;
+}
+
+// masked logarithms of a plane, a plain map so it vectorizes, returns how many values were valid
+inline uint32_t computeLogs(const float* values, const size_t count, float* outLogs)
+{
+	// validity tested on the bits, one unsigned compare with no floating point control flow:
+	// negatives wrap around to huge values, and so do NaN and infinity which sit above every finite float
+	constexpr uint32_t MinBits = 0x322bcc77u; // MinValue
+	constexpr uint32_t OneBits = 0x3f800000u;
+	constexpr uint32_t InfinityBits = 0x7f800000u;
+
+	uint32_t validCount = 0u;
+	for (size_t i = 0ull; i < count; i++)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, values + i, sizeof(float));
+		const uint32_t valid = bits - (MinBits + 1u) < InfinityBits - (MinBits + 1u) ? 1u : 0u;
+		// the logarithm of the 1 invalid values get replaced with is exactly 0, selecting with a mask keeps GCC from branching
+		const uint32_t mask = 0u - valid;
+		bits = (bits & mask) | (OneBits & ~mask);
+		float value;
+		std::memcpy(&value, &bits, sizeof(float));
+		outLogs[i] = fastLog(value);
+		validCount += valid;
+	}
+	return validCount;
+}
+
+// the compiler may not reorder a float reduction by itself, so it gets spelled out as independent lanes
+constexpr size_t SumLanes = 8ull;
+
+inline float sum(const float* values, const size_t count)
+{
+	float lanes[SumLanes] = {};
+	size_t i = 0ull;
+	for (; i + SumLanes <= count; i += SumLanes)
+	for (size_t l = 0ull; l < SumLanes; l++)
+		lanes[l] += values[i + l];
+	for (; i < count; i++)
+		lanes[0] += values[i];
+
+	float retval = 0.f;
+	for (size_t l = 0ull; l < SumLanes; l++)
+		retval += lanes[l];
+	return retval;
+}
+
+template<uint32_t ChannelCount>
+void accumulateBlock(const float* values, const size_t count, SColorStatistics& statistics)
+{
+	// planar, so every step below is a straight loop over contiguous floats
+	float planes[4][BlockPixels];
+	for (size_t i = 0ull; i < count; i++)
+	{
+		const float* pixel = values + i * ChannelCount;
+		planes[0][i] = pixel[0];
+		planes[1][i] = pixel[1];
+		planes[2][i] = pixel[2];
+		planes[3][i] = 0.212671f * pixel[0] + 0.715160f * pixel[1] + 0.072169f * pixel[2];
+	}
+
+	float logs[BlockPixels];
+	for (uint32_t c = 0u; c < 3u; c++)
+	{
+		statistics.colorCounts[c] += computeLogs(planes[c], count, logs);
+		statistics.logColorSums[c] += sum(logs, count);
+	}
+	statistics.luminanceCount += computeLogs(planes[3], count, logs);
+	statistics.logLuminanceSum += sum(logs, count);
+}
+
+}
+
+void SColorStatistics::merge(const SColorStatistics& other)
+{
+	logLuminanceSum += other.logLuminanceSum;
+	luminanceCount += other.luminanceCount;
+	for (uint32_t c = 0u; c < 3u; c++)
+	{
+		logColorSums[c] += other.logColorSums[c];
+		colorCounts[c] += other.colorCounts[c];
+	}
+}
+
+float SColorStatistics::getIntensity() const
+{
+	if (!luminanceCount)
+		return 1.f;
+	return static_cast<float>(0.18 / std::exp(logLuminanceSum / double(luminanceCount)));
+}
+
+std::array<float, 3> SColorStatistics::getAverageColor() const
+{
+	std::array<float, 3> retval;
+	for (uint32_t c = 0u; c < 3u; c++)
+		retval[c] = colorCounts[c] ? static_cast<float>(std::exp(logColorSums[c] / double(colorCounts[c]))) : 1.f;
+	return retval;
+}
+
+void accumulateColorStatistics(E_PIXEL_FORMAT format, const void* pixels, size_t begin, size_t end, SColorStatistics& statistics)
+{
+	const uint32_t channelCount = getPixelFormatChannelCount(format);
+	const bool half = format == EPF_HALF3 || format == EPF_HALF4;
+	const uint8_t* data = static_cast<const uint8_t*>(pixels) + begin * getPixelFormatStride(format);
+
+	float decoded[BlockPixels * 4u];
+	for (size_t offset = begin; offset < end; offset += BlockPixels)
+	{
+		const size_t count = std::min(BlockPixels, end - offset);
+		const float* values = reinterpret_cast<const float*>(data);
+		if (half)
+		{
+			convertHalfToFloat(reinterpret_cast<const uint16_t*>(data), decoded, count * channelCount);
+			values = decoded;
+		}
+
+		if (channelCount == 4u)
+			accumulateBlock<4u>(values, count, statistics);
+		else
+			accumulateBlock<3u>(values, count, statistics);
+		data += count * getPixelFormatStride(format);
+	}
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef __DBR_COLOR_STATISTICS_H_INCLUDED__
+#define __DBR_COLOR_STATISTICS_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <array>
+
+namespace dbr
+{
+
+//! What `SDenoiserParams::hdrIntensity` and `hdrAverageColor` point to
+struct SHDRParameters
+{
+	float intensity = 1.f;
+	std::array<float, 3> averageColor = { 1.f,1.f,1.f };
+};
+
+/*
+	Partial sums towards the log-average luminance and per channel log-average color of an HDR image.
+
+	Only positive finite values contribute since their logarithm is taken, exactly like the CPU backend's intensity pass.
+	Partial sums of disjoint pixel ranges can be gathered on separate threads and merged, merging in a fixed order
+	keeps the result deterministic.
+*/
+struct SColorStatistics
+{
+	double logLuminanceSum = 0.0;
+	uint64_t luminanceCount = 0ull;
+	std::array<double, 3> logColorSums = { 0.0,0.0,0.0 };
+	std::array<uint64_t, 3> colorCounts = { 0ull,0ull,0ull };
+
+	void merge(const SColorStatistics& other);
+
+	//! `0.18/exp(mean log luminance)`, the exposure bringing the image to middle grey that `optixDenoiserComputeIntensity` estimates
+	float getIntensity() const;
+	//! `exp(mean log channel)` per channel, the quantity `optixDenoiserComputeAverageColor` estimates
+	std::array<float, 3> getAverageColor() const;
+	inline SHDRParameters getHDRParameters() const { return { getIntensity(),getAverageColor() }; }
+};
+
+//! Adds pixels `[begin,end)` of a tightly packed image
+void accumulateColorStatistics(E_PIXEL_FORMAT format, const void* pixels, size_t begin, size_t end, SColorStatistics& statistics);
+
+}
+
+#endif // __DBR_COLOR_STATISTICS_H_INCLUDED__
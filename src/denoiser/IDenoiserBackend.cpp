@@ -0,0 +1,45 @@
+#include "config/BuildConfigOptions.h"
+#include "denoiser/IDenoiserBackend.h"
+#include "denoiser/CDenoiserBackendCPU.h"
+
+#ifdef DBR_BUILD_OPTIX_BACKEND
+#include "denoiser/CDenoiserBackendOptiX.h"
+#endif
+
+namespace dbr
+{
+
+E_BACKEND_TYPE getBackendTypeFromName(std::string_view name)
+{
+	if (name == "optix")
+		return EBT_OPTIX;
+	if (name == "cpu")
+		return EBT_CPU;
+	return EBT_COUNT;
+}
+
+E_BACKEND_TYPE getDefaultBackendType()
+{
+#ifdef DBR_BUILD_OPTIX_BACKEND
+	return EBT_OPTIX;
+#else
+	return EBT_CPU;
+#endif
+}
+
+std::unique_ptr<IDenoiserBackend> createDenoiserBackend(E_BACKEND_TYPE type)
+{
+	switch (type)
+	{
+#ifdef DBR_BUILD_OPTIX_BACKEND
+		case EBT_OPTIX:
+			return CDenoiserBackendOptiX::create();
+#endif
+		case EBT_CPU:
+			return CDenoiserBackendCPU::create();
+		default:
+			return nullptr;
+	}
+}
+
+}
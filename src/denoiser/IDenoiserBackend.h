@@ -0,0 +1,152 @@
+#ifndef __DBR_I_DENOISER_BACKEND_H_INCLUDED__
+#define __DBR_I_DENOISER_BACKEND_H_INCLUDED__
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace dbr
+{
+
+//! Opaque address of a backend allocation, a `CUdeviceptr` for the OptiX backend and a plain host pointer for the CPU one.
+using address_t = uint64_t;
+//! Opaque handle of a denoiser made by `IDenoiserBackend::createDenoiser`, an `OptixDenoiser` for the OptiX backend, 0 is never valid.
+using denoiser_t = uint64_t;
+
+enum E_PIXEL_FORMAT : uint8_t
+{
+	EPF_HALF3,
+	EPF_HALF4,
+	EPF_FLOAT3,
+	EPF_FLOAT4,
+	EPF_COUNT
+};
+
+inline uint32_t getPixelFormatChannelCount(const E_PIXEL_FORMAT format)
+{
+	return format == EPF_HALF3 || format == EPF_FLOAT3 ? 3u : 4u;
+}
+
+inline uint32_t getPixelFormatStride(const E_PIXEL_FORMAT format)
+{
+	const uint32_t channelSize = format == EPF_HALF3 || format == EPF_HALF4 ? 2u : 4u;
+	return channelSize * getPixelFormatChannelCount(format);
+}
+
+inline const char* getPixelFormatName(const E_PIXEL_FORMAT format)
+{
+	constexpr const char* names[EPF_COUNT] = { "HALF3","HALF4","FLOAT3","FLOAT4" };
+	return format < EPF_COUNT ? names[format] : "UNKNOWN";
+}
+
+//! Mirrors `OptixDenoiserInputKind`, the value is also the number of input layers.
+enum E_INPUT_KIND : uint8_t
+{
+	EIK_RGB = 1u,
+	EIK_RGB_ALBEDO = 2u,
+	EIK_RGB_ALBEDO_NORMAL = 3u
+};
+
+enum E_MODEL_KIND : uint8_t
+{
+	EMK_LDR,
+	EMK_HDR
+};
+
+//! Same fields as `OptixImage2D`, but the format is an `E_PIXEL_FORMAT`, so backends translate it field by field
+struct SImage2D
+{
+	address_t data = 0ull;
+	uint32_t width = 0u;
+	uint32_t height = 0u;
+	uint32_t rowStrideInBytes = 0u;
+	uint32_t pixelStrideInBytes = 0u;
+	E_PIXEL_FORMAT format = EPF_HALF4;
+};
+
+//! Same meaning as `OptixDenoiserParams`, the intensity and average color are backend addresses to a `float` and `float[3]`
+struct SDenoiserParams
+{
+	bool denoiseAlpha = false;
+	float blendFactor = 0.f;
+	address_t hdrIntensity = 0ull;
+	address_t hdrAverageColor = 0ull;
+};
+
+struct SDenoiserMemoryRequirements
+{
+	size_t stateSizeInBytes = 0ull;
+	size_t scratchSizeInBytes = 0ull; //!< scratch needed for a tiled invocation with overlap
+	uint32_t overlapWindowSizeInPixels = 0u; //!< smallest overlap the backend needs to hide tile seams
+};
+
+/*
+	A denoiser implementation together with the memory it operates on.
+
+	The call sequence matches the OptiX one:
+		createDenoiser -> computeMemoryRequirements -> allocate state & scratch -> setup -> computeIntensity -> invokeTiled -> destroyDenoiser
+	Any number of denoisers can exist at once, each set up for its own tile size with its own state and scratch,
+	but calls on the same backend must not overlap.
+*/
+class IDenoiserBackend
+{
+	public:
+		virtual ~IDenoiserBackend() = default;
+
+		virtual std::string_view getName() const = 0;
+
+		//! Memory the denoiser operates on, none of the copies are guaranteed to complete before `synchronize`
+		virtual address_t allocate(size_t size) = 0;
+		virtual void deallocate(address_t address) = 0;
+		virtual bool copyHostToDevice(address_t dst, const void* src, size_t size) = 0;
+		virtual bool copyDeviceToHost(void* dst, address_t src, size_t size) = 0;
+		virtual bool synchronize() = 0;
+		//! Host memory the copies above are fastest from and to (page locked for OptiX), meant for staging buffers
+		virtual void* allocateHost(size_t size) = 0;
+		virtual void deallocateHost(void* ptr) = 0;
+		//! What `allocate` can still hand out, the default budget for tile planning
+		virtual size_t getAvailableMemory() const = 0;
+
+		//! Returns 0 on failure
+		virtual denoiser_t createDenoiser(E_MODEL_KIND model, E_INPUT_KIND inputKind) = 0;
+		virtual bool computeMemoryRequirements(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements) const = 0;
+		//! Can be called again to set the denoiser up for another tile size, which invalidates the previous state
+		virtual bool setup(denoiser_t denoiser, uint32_t tileWidth, uint32_t tileHeight, address_t state, size_t stateSize, address_t scratch, size_t scratchSize) = 0;
+
+		//! Scratch `computeIntensity` needs for an input of the given size
+		virtual size_t getIntensityScratchSize(uint32_t width, uint32_t height) const = 0;
+		//! Writes a single `float` to `outIntensity`
+		virtual bool computeIntensity(denoiser_t denoiser, const SImage2D& input, address_t outIntensity, address_t scratch, size_t scratchSize) = 0;
+
+		virtual bool invokeTiled(
+			denoiser_t denoiser,
+			const SDenoiserParams& params,
+			address_t state, size_t stateSize,
+			const SImage2D* inputs, uint32_t inputCount,
+			const SImage2D& output,
+			address_t scratch, size_t scratchSize,
+			uint32_t overlap, uint32_t tileWidth, uint32_t tileHeight
+		) = 0;
+
+		//! Memory handed out by `allocate` stays valid, destroying 0 does nothing
+		virtual void destroyDenoiser(denoiser_t denoiser) = 0;
+};
+
+enum E_BACKEND_TYPE : uint8_t
+{
+	EBT_OPTIX,
+	EBT_CPU,
+	EBT_COUNT
+};
+
+//! Returns `EBT_COUNT` for an unknown name
+E_BACKEND_TYPE getBackendTypeFromName(std::string_view name);
+//! OptiX if it was built, otherwise CPU
+E_BACKEND_TYPE getDefaultBackendType();
+//! Returns nullptr if the backend wasn't built or could not be initialized (i.e. no CUDA device)
+std::unique_ptr<IDenoiserBackend> createDenoiserBackend(E_BACKEND_TYPE type);
+
+}
+
+#endif // __DBR_I_DENOISER_BACKEND_H_INCLUDED__
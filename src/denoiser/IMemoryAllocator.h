@@ -0,0 +1,77 @@
+#ifndef __DBR_I_MEMORY_ALLOCATOR_H_INCLUDED__
+#define __DBR_I_MEMORY_ALLOCATOR_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+#include "core/SystemInfo.h"
+
+#include <new>
+
+namespace dbr
+{
+
+/*
+	Hands out memory of one kind, device memory of a backend, pinned host memory or plain host memory,
+	so `CMemoryPool` can sit in front of any of them. Has to be callable from several threads at once.
+*/
+class IMemoryAllocator
+{
+	public:
+		virtual ~IMemoryAllocator() = default;
+
+		//! Returns 0 on failure and for a `size` of 0
+		virtual address_t allocate(size_t size) = 0;
+		//! Deallocating 0 does nothing
+		virtual void deallocate(address_t address) = 0;
+		//! What `allocate` can still hand out
+		virtual size_t getAvailableMemory() const = 0;
+};
+
+//! Aligned plain host memory, what the pooling can be exercised with where there's no GPU
+class CHostMemoryAllocator final : public IMemoryAllocator
+{
+	public:
+		static constexpr size_t Alignment = 64ull;
+
+		address_t allocate(size_t size) override
+		{
+			return size ? reinterpret_cast<address_t>(::operator new(size, std::align_val_t(Alignment), std::nothrow)) : 0ull;
+		}
+		void deallocate(address_t address) override
+		{
+			if (address)
+				::operator delete(reinterpret_cast<void*>(address), std::align_val_t(Alignment));
+		}
+		size_t getAvailableMemory() const override { return getAvailableHostMemory(); }
+};
+
+//! Device memory of a backend
+class CBackendMemoryAllocator final : public IMemoryAllocator
+{
+	public:
+		explicit CBackendMemoryAllocator(IDenoiserBackend* backend) : m_backend(backend) {}
+
+		address_t allocate(size_t size) override { return m_backend->allocate(size); }
+		void deallocate(address_t address) override { m_backend->deallocate(address); }
+		size_t getAvailableMemory() const override { return m_backend->getAvailableMemory(); }
+
+	private:
+		IDenoiserBackend* const m_backend;
+};
+
+//! Host memory from a backend's `allocateHost`, page locked for OptiX
+class CBackendHostMemoryAllocator final : public IMemoryAllocator
+{
+	public:
+		explicit CBackendHostMemoryAllocator(IDenoiserBackend* backend) : m_backend(backend) {}
+
+		address_t allocate(size_t size) override { return reinterpret_cast<address_t>(m_backend->allocateHost(size)); }
+		void deallocate(address_t address) override { m_backend->deallocateHost(reinterpret_cast<void*>(address)); }
+		size_t getAvailableMemory() const override { return getAvailableHostMemory(); }
+
+	private:
+		IDenoiserBackend* const m_backend;
+};
+
+}
+
+#endif // __DBR_I_MEMORY_ALLOCATOR_H_INCLUDED__
@@ -0,0 +1,35 @@
+#ifndef __DBR_OPTIX_CHECK_H_INCLUDED__
+#define __DBR_OPTIX_CHECK_H_INCLUDED__
+
+#include "nvidia/CheckMacros.h"
+
+#include <iostream>
+
+#include <cuda.h>
+#include <optix.h>
+
+inline bool CU_CHECK(const CUresult result)
+{
+	if (result != CUDA_SUCCESS)
+	{
+		const char* name;
+		cuGetErrorName(result, &name);
+		std::cerr << "ERROR: Failed with " << name << " (" << result << ")\n";
+		MY_ASSERT(!"CU_CHECK fatal");
+		return false;
+	}
+	return true;
+}
+
+inline bool OPTIX_CHECK(const OptixResult result)
+{
+	if (result != OPTIX_SUCCESS)
+	{
+		std::cerr << "ERROR: Failed with (" << result << ")\n";
+		MY_ASSERT(!"OPTIX_CHECK fatal");
+		return false;
+	}
+	return true;
+}
+
+#endif // __DBR_OPTIX_CHECK_H_INCLUDED__
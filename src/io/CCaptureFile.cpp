@@ -0,0 +1,118 @@
+#include "io/CCaptureFile.h"
+#include "io/FileOffset.h"
+
+#include <cstring>
+#include <type_traits>
+
+using namespace dbr;
+
+// written and mapped as is, so their layout is the file format
+static_assert(std::is_trivially_copyable_v<SCaptureHeader> && sizeof(SCaptureHeader) == 64ull, "capture header layout changed");
+static_assert(std::is_trivially_copyable_v<SCaptureFrame> && sizeof(SCaptureFrame) == 48ull, "capture frame record layout changed");
+
+bool CCaptureWriter::open(const std::string& path, const SCaptureSettings& settings)
+{
+	close();
+
+	m_file = std::fopen(path.c_str(), "wb");
+	if (!m_file)
+		return false;
+
+	// a placeholder until `close` knows the frame count and where the table goes
+	m_header = {};
+	m_header.settings = settings;
+	m_frames.clear();
+	m_failed = std::fwrite(&m_header, sizeof(m_header), 1u, m_file) != 1u;
+	m_fileSize = sizeof(m_header);
+	return !m_failed;
+}
+
+bool CCaptureWriter::addFrame(SCaptureFrame frame, const void* payload)
+{
+	if (!m_file || m_failed)
+		return false;
+
+	static const uint8_t zeros[CapturePayloadAlignment] = {};
+	const size_t padding = (CapturePayloadAlignment - m_fileSize % CapturePayloadAlignment) % CapturePayloadAlignment;
+	frame.payloadOffset = m_fileSize + padding;
+	if (std::fwrite(zeros, 1u, padding, m_file) != padding || std::fwrite(payload, 1u, frame.payloadSize, m_file) != frame.payloadSize)
+	{
+		m_failed = true;
+		return false;
+	}
+
+	m_fileSize = frame.payloadOffset + frame.payloadSize;
+	m_frames.push_back(frame);
+	return true;
+}
+
+bool CCaptureWriter::close()
+{
+	if (!m_file)
+		return false;
+
+	std::memcpy(m_header.magic, SCaptureHeader::Magic, sizeof(m_header.magic));
+	m_header.frameCount = static_cast<uint32_t>(m_frames.size());
+	m_header.frameTableOffset = m_fileSize;
+	bool written = !m_failed && std::fwrite(m_frames.data(), sizeof(SCaptureFrame), m_frames.size(), m_file) == m_frames.size();
+	written = written && seekFile(m_file, 0ull) && std::fwrite(&m_header, sizeof(m_header), 1u, m_file) == 1u;
+	const bool flushed = std::fclose(m_file) == 0;
+
+	m_file = nullptr;
+	m_frames.clear();
+	m_fileSize = 0ull;
+	m_failed = false;
+	return written && flushed;
+}
+
+bool CCaptureReader::open(const std::string& path)
+{
+	close();
+	if (!m_file.open(path) || m_file.getSize() < sizeof(m_header))
+		return false;
+
+	std::memcpy(&m_header, m_file.getData(), sizeof(m_header));
+	if (std::memcmp(m_header.magic, SCaptureHeader::Magic, sizeof(m_header.magic)) != 0 || m_header.version != SCaptureHeader::CurrentVersion)
+	{
+		close();
+		return false;
+	}
+
+	const SCaptureSettings& settings = m_header.settings;
+	if (settings.model > EMK_HDR || settings.inputKind < EIK_RGB || settings.inputKind > EIK_RGB_ALBEDO_NORMAL || settings.outputFormat >= EPF_COUNT)
+	{
+		close();
+		return false;
+	}
+
+	const size_t tableSize = size_t(m_header.frameCount) * sizeof(SCaptureFrame);
+	if (m_header.frameTableOffset > m_file.getSize() || m_file.getSize() - m_header.frameTableOffset < tableSize)
+	{
+		close();
+		return false;
+	}
+	m_frames.resize(m_header.frameCount);
+	std::memcpy(m_frames.data(), m_file.getData() + m_header.frameTableOffset, tableSize);
+
+	for (const auto& frame : m_frames)
+	{
+		// the denoiser reads as many layers as the settings' input kind asks for
+		bool valid = frame.width && frame.height && frame.layerCount >= settings.inputKind && frame.layerCount <= EIK_RGB_ALBEDO_NORMAL;
+		uint64_t payloadSize = 0ull;
+		for (uint32_t k = 0u; valid && k < frame.layerCount; k++)
+		{
+			valid = frame.formats[k] < EPF_COUNT;
+			if (valid)
+				payloadSize += uint64_t(getPixelFormatStride(static_cast<E_PIXEL_FORMAT>(frame.formats[k]))) * frame.width * frame.height;
+		}
+		// payloads have to lie before the table, which also rules out offsets that would overflow
+		valid = valid && payloadSize == frame.payloadSize && frame.payloadOffset % CapturePayloadAlignment == 0ull
+			&& frame.payloadOffset <= m_header.frameTableOffset && m_header.frameTableOffset - frame.payloadOffset >= frame.payloadSize;
+		if (!valid)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
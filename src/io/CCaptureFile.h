@@ -0,0 +1,117 @@
+#ifndef __DBR_C_CAPTURE_FILE_H_INCLUDED__
+#define __DBR_C_CAPTURE_FILE_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+#include "denoiser/ColorStatistics.h"
+#include "io/CMappedFile.h"
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	A denoiser repro in one file: every frame's input layers exactly as they went to the denoiser,
+	with the settings they were denoised with.
+
+	Layout, all little endian:
+	- `SCaptureHeader`
+	- every frame's layers back to back in the transfer formats, the same layout as `SFrameStaging`,
+	  each frame starting on a `PayloadAlignment` boundary so it can be used straight from a mapping
+	- the table of `SCaptureFrame` records, found through the header since it only gets written once all frames are in
+*/
+struct SCaptureSettings
+{
+	uint32_t model = EMK_HDR;
+	uint32_t inputKind = EIK_RGB_ALBEDO_NORMAL;
+	uint32_t outputFormat = EPF_HALF4;
+	//! backend tiling, 0 lets the tile planner pick
+	uint32_t tileWidth = 0u;
+	uint32_t tileHeight = 0u;
+	uint32_t overlap = 0u;
+	uint32_t memoryBudgetMiB = 0u;
+	//! 0 is no host tiling
+	uint32_t hostTileWidth = 0u;
+	uint32_t hostTileHeight = 0u;
+	uint32_t feather = ~0u;
+};
+
+struct SCaptureFrame
+{
+	uint32_t width = 0u;
+	uint32_t height = 0u;
+	uint32_t layerCount = 0u;
+	std::array<uint8_t, EIK_RGB_ALBEDO_NORMAL> formats = { EPF_HALF4,EPF_HALF4,EPF_HALF4 };
+	uint8_t hasHDRParameters = 0u;
+	SHDRParameters hdrParameters;
+	//! from the start of the file
+	uint64_t payloadOffset = 0ull;
+	uint64_t payloadSize = 0ull;
+};
+
+struct SCaptureHeader
+{
+	static constexpr char Magic[8] = { 'D','B','R','C','A','P','T','\0' };
+	static constexpr uint32_t CurrentVersion = 1u;
+
+	char magic[8] = {};
+	uint32_t version = CurrentVersion;
+	uint32_t frameCount = 0u;
+	uint64_t frameTableOffset = 0ull;
+	SCaptureSettings settings;
+};
+
+//! Page size of every common OS and big enough for any upload alignment
+constexpr size_t CapturePayloadAlignment = 4096ull;
+
+//! Appends frames to a new capture, the header and frame table only get valid with `close`
+class CCaptureWriter
+{
+	public:
+		CCaptureWriter() = default;
+		~CCaptureWriter() { close(); }
+
+		CCaptureWriter(const CCaptureWriter&) = delete;
+		CCaptureWriter& operator=(const CCaptureWriter&) = delete;
+
+		bool open(const std::string& path, const SCaptureSettings& settings);
+		//! `frame.payloadOffset` gets filled in, `frame.payloadSize` bytes of `payload` get written
+		bool addFrame(SCaptureFrame frame, const void* payload);
+		//! Returns false if anything failed since `open`, a capture missing frames shouldn't pass for a repro
+		bool close();
+
+		inline size_t getFrameCount() const { return m_frames.size(); }
+
+	private:
+		std::FILE* m_file = nullptr;
+		SCaptureHeader m_header;
+		std::vector<SCaptureFrame> m_frames;
+		uint64_t m_fileSize = 0ull;
+		bool m_failed = false;
+};
+
+//! Maps a capture and validates its header and frame table, the payloads are used in place
+class CCaptureReader
+{
+	public:
+		bool open(const std::string& path);
+		inline void close() { m_file.close(); m_frames.clear(); }
+
+		inline const SCaptureSettings& getSettings() const { return m_header.settings; }
+		inline const std::vector<SCaptureFrame>& getFrames() const { return m_frames; }
+		inline const uint8_t* getPayload(size_t frame) const { return m_file.getData() + m_frames[frame].payloadOffset; }
+		//! Starts reading a frame's payload ahead of its first use
+		inline void prefetch(size_t frame) const { m_file.willNeed(m_frames[frame].payloadOffset, m_frames[frame].payloadSize); }
+
+	private:
+		CMappedFile m_file;
+		SCaptureHeader m_header;
+		std::vector<SCaptureFrame> m_frames;
+};
+
+}
+
+#endif // __DBR_C_CAPTURE_FILE_H_INCLUDED__
@@ -0,0 +1,78 @@
+#include "io/CDDSReader.h"
+#include "io/FileOffset.h"
+
+#include <cstring>
+
+#include "gli/gli.hpp"
+
+using namespace dbr;
+
+bool CDDSReader::open(const std::string& path)
+{
+	close();
+
+	m_file = std::fopen(path.c_str(), "rb");
+	if (!m_file)
+		return false;
+	// the payload is read in one go straight into its destination, stdio buffering would only add a copy
+	std::setvbuf(m_file, nullptr, _IONBF, 0);
+
+	char magic[sizeof(gli::detail::FOURCC_DDS)];
+	gli::detail::dds_header header;
+	if (std::fread(magic, sizeof(magic), 1u, m_file) != 1u || std::strncmp(magic, gli::detail::FOURCC_DDS, sizeof(magic)) != 0)
+		return false;
+	if (std::fread(&header, sizeof(header), 1u, m_file) != 1u)
+		return false;
+
+	const bool extendedHeader = (header.Format.flags & gli::dx::DDPF_FOURCC) && (header.Format.fourCC == gli::dx::D3DFMT_DX10 || header.Format.fourCC == gli::dx::D3DFMT_GLI1);
+	gli::detail::dds_header10 header10;
+	if (extendedHeader && std::fread(&header10, sizeof(header10), 1u, m_file) != 1u)
+		return false;
+
+	// same precedence as `gli::load_dds`, but without the channel mask matching
+	const gli::dx dx;
+	if ((header.Format.flags & (gli::dx::DDPF_RGB | gli::dx::DDPF_ALPHAPIXELS | gli::dx::DDPF_ALPHA | gli::dx::DDPF_YUV | gli::dx::DDPF_LUMINANCE)) && header.Format.bpp != 0u)
+		m_info.format = gli::FORMAT_UNDEFINED;
+	else if (extendedHeader)
+		m_info.format = dx.find(header.Format.fourCC, header10.Format);
+	else if (header.Format.flags & gli::dx::DDPF_FOURCC)
+		m_info.format = dx.find(gli::detail::remap_four_cc(header.Format.fourCC));
+
+	m_payloadOffset = sizeof(magic) + sizeof(header) + (extendedHeader ? sizeof(header10) : 0ull);
+	m_info.width = header.Width;
+	m_info.height = (header.Flags & gli::detail::DDSD_HEIGHT) ? header.Height : 1u;
+	if (m_info.format != gli::FORMAT_UNDEFINED)
+	{
+		// level 0 of layer 0 and face 0 comes first in the payload, for volumes that's the first slice onwards
+		const auto blockExtent = gli::block_extent(m_info.format);
+		const size_t blocksX = (size_t(m_info.width) + blockExtent.x - 1u) / blockExtent.x;
+		const size_t blocksY = (size_t(m_info.height) + blockExtent.y - 1u) / blockExtent.y;
+		m_info.imageSize = blocksX * blocksY * gli::block_size(m_info.format);
+	}
+	return true;
+}
+
+bool CDDSReader::read(void* dst, size_t dstSize)
+{
+	if (!m_file || m_info.format == gli::FORMAT_UNDEFINED || dstSize < m_info.imageSize)
+		return false;
+
+	return seekFile(m_file, m_payloadOffset) && std::fread(dst, 1u, m_info.imageSize, m_file) == m_info.imageSize;
+}
+
+bool CDDSReader::readRange(size_t offset, void* dst, size_t size)
+{
+	if (!m_file || m_info.format == gli::FORMAT_UNDEFINED || offset + size > m_info.imageSize)
+		return false;
+
+	return seekFile(m_file, m_payloadOffset + offset) && std::fread(dst, 1u, size, m_file) == size;
+}
+
+void CDDSReader::close()
+{
+	if (m_file)
+		std::fclose(m_file);
+	m_file = nullptr;
+	m_info = {};
+	m_payloadOffset = 0ull;
+}
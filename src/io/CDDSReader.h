@@ -0,0 +1,57 @@
+#ifndef __DBR_C_DDS_READER_H_INCLUDED__
+#define __DBR_C_DDS_READER_H_INCLUDED__
+
+#include "gli/format.hpp"
+
+#include <cstdio>
+#include <string>
+
+namespace dbr
+{
+
+/*
+	Reads the base level of a DDS file straight into caller supplied memory, i.e. a pinned staging buffer.
+
+	`gli::load_dds` reads the whole file into a `std::vector<char>` and then copies it into zero initialized texture
+	storage, so by the time the pixels reach a staging buffer host memory has been written three times.
+	Here the header is parsed on its own and the payload lands in its final destination with a single read.
+*/
+class CDDSReader
+{
+	public:
+		struct SInfo
+		{
+			gli::format format = gli::FORMAT_UNDEFINED;
+			uint32_t width = 0u;
+			uint32_t height = 0u;
+			//! size of the first mip level of the first layer and face, the only part `read` fetches
+			size_t imageSize = 0ull;
+		};
+
+		CDDSReader() = default;
+		~CDDSReader() { close(); }
+
+		CDDSReader(const CDDSReader&) = delete;
+		CDDSReader& operator=(const CDDSReader&) = delete;
+
+		//! Only parses the header, formats described by channel masks instead of a FourCC/DXGI format come out `FORMAT_UNDEFINED`
+		bool open(const std::string& path);
+		//! `dstSize` has to be at least `getInfo().imageSize`
+		bool read(void* dst, size_t dstSize);
+		//! Reads `size` bytes starting `offset` bytes into the image, so frames too big for memory can be read a band at a time
+		bool readRange(size_t offset, void* dst, size_t size);
+		void close();
+
+		inline const SInfo& getInfo() const { return m_info; }
+		//! Where the image starts in the file
+		inline size_t getPayloadOffset() const { return m_payloadOffset; }
+
+	private:
+		std::FILE* m_file = nullptr;
+		SInfo m_info;
+		size_t m_payloadOffset = 0ull;
+};
+
+}
+
+#endif // __DBR_C_DDS_READER_H_INCLUDED__
@@ -0,0 +1,216 @@
+#include "io/CDDSWriter.h"
+#include "io/CDDSReader.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "gli/gli.hpp"
+
+using namespace dbr;
+
+bool CDDSWriter::save(const std::string& path, gli::format format, uint32_t width, uint32_t height, const void* src)
+{
+	CDDSWriter writer;
+	if (!writer.open(path, format, width, height))
+		return false;
+	return writer.write(src, writer.getImageSize()) && writer.close();
+}
+
+bool CDDSWriter::open(const std::string& path, gli::format format, uint32_t width, uint32_t height)
+{
+	close();
+
+	const auto blockExtent = gli::block_extent(format);
+	if (blockExtent.x != 1 || blockExtent.y != 1 || !width || !height)
+		return false;
+
+	// same as `gli::save_dds` fills in for a single level `texture2d`
+	const gli::dx dx;
+	const gli::dx::format& dxFormat = dx.translate(format);
+	const bool extendedHeader = dxFormat.D3DFormat == gli::dx::D3DFMT_GLI1 || dxFormat.D3DFormat == gli::dx::D3DFMT_DX10;
+
+	gli::detail::dds_header header;
+	std::memset(&header, 0, sizeof(header));
+	header.Size = sizeof(header);
+	header.Flags = gli::detail::DDSD_CAPS | gli::detail::DDSD_WIDTH | gli::detail::DDSD_PIXELFORMAT | gli::detail::DDSD_MIPMAPCOUNT | gli::detail::DDSD_HEIGHT | gli::detail::DDSD_PITCH;
+	header.Width = width;
+	header.Height = height;
+	header.Pitch = 32u;
+	header.Depth = 0u;
+	header.MipMapLevels = 1u;
+	header.Format.size = sizeof(gli::detail::dds_pixel_format);
+	header.Format.flags = extendedHeader ? gli::dx::DDPF_FOURCC : dxFormat.DDPixelFormat;
+	header.Format.fourCC = gli::detail::get_fourcc(extendedHeader, format, dxFormat);
+	header.Format.bpp = static_cast<uint32_t>(gli::detail::bits_per_pixel(format));
+	header.Format.Mask = dxFormat.Mask;
+	header.SurfaceFlags = gli::detail::DDSCAPS_TEXTURE | gli::detail::DDSCAPS_MIPMAP;
+	header.CubemapFlags = 0u;
+
+	gli::detail::dds_header10 header10;
+	header10.ArraySize = 1u;
+	header10.ResourceDimension = gli::detail::D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+	header10.MiscFlag = 0u;
+	header10.Format = dxFormat.DXGIFormat;
+	header10.AlphaFlags = gli::detail::DDS_ALPHA_MODE_UNKNOWN;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	m_file = file;
+#else
+	m_file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (m_file < 0)
+		return false;
+#endif
+
+	uint8_t headerData[sizeof(gli::detail::FOURCC_DDS) + sizeof(header) + sizeof(header10)];
+	std::memcpy(headerData, gli::detail::FOURCC_DDS, sizeof(gli::detail::FOURCC_DDS));
+	std::memcpy(headerData + sizeof(gli::detail::FOURCC_DDS), &header, sizeof(header));
+	std::memcpy(headerData + sizeof(gli::detail::FOURCC_DDS) + sizeof(header), &header10, sizeof(header10));
+	m_payloadOffset = sizeof(gli::detail::FOURCC_DDS) + sizeof(header) + (extendedHeader ? sizeof(header10) : 0ull);
+	if (!writeAt(0ull, headerData, m_payloadOffset))
+	{
+		close();
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_rowPitch = size_t(gli::block_size(format)) * width;
+	m_imageSize = m_rowPitch * height;
+	return true;
+}
+
+bool CDDSWriter::openForUpdate(const std::string& path, gli::format format, uint32_t width, uint32_t height)
+{
+	close();
+
+	size_t payloadOffset, imageSize;
+	{
+		CDDSReader reader;
+		if (!reader.open(path))
+			return false;
+		const auto& info = reader.getInfo();
+		if (info.format != format || info.width != width || info.height != height || gli::block_extent(format).x != 1)
+			return false;
+		payloadOffset = reader.getPayloadOffset();
+		imageSize = info.imageSize;
+	}
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	m_file = file;
+#else
+	m_file = ::open(path.c_str(), O_WRONLY);
+	if (m_file < 0)
+		return false;
+#endif
+
+	m_payloadOffset = payloadOffset;
+	m_width = width;
+	m_height = height;
+	m_rowPitch = size_t(gli::block_size(format)) * width;
+	m_imageSize = imageSize;
+	m_updating = true;
+	return true;
+}
+
+bool CDDSWriter::writeAt(size_t fileOffset, const void* src, size_t size)
+{
+	const uint8_t* data = static_cast<const uint8_t*>(src);
+	while (size)
+	{
+#ifdef _WIN32
+		// synchronous handles still take the offset from the `OVERLAPPED`, so there's no shared file pointer to race on
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = DWORD(fileOffset);
+		overlapped.OffsetHigh = DWORD(uint64_t(fileOffset) >> 32ull);
+		DWORD written = 0u;
+		if (!WriteFile(static_cast<HANDLE>(m_file), data, DWORD((std::min)(size, size_t(1u) << 30u)), &written, &overlapped) || !written)
+			return false;
+#else
+		const ssize_t written = pwrite(m_file, data, size, off_t(fileOffset));
+		if (written <= 0)
+			return false;
+#endif
+		data += written;
+		fileOffset += size_t(written);
+		size -= size_t(written);
+	}
+	return true;
+}
+
+bool CDDSWriter::write(const void* src, size_t size)
+{
+	if (m_updating || m_appendOffset + size > m_imageSize)
+		return false;
+
+	if (!writeRange(m_appendOffset, src, size))
+		return false;
+	m_appendOffset += size;
+	return true;
+}
+
+bool CDDSWriter::writeRange(size_t offset, const void* src, size_t size)
+{
+	if (!m_imageSize || offset + size > m_imageSize)
+		return false;
+
+	if (!writeAt(m_payloadOffset + offset, src, size))
+	{
+		m_failed = true;
+		return false;
+	}
+	m_writtenSize += size;
+	return true;
+}
+
+bool CDDSWriter::writeTile(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* src, size_t srcPitch)
+{
+	if (x + width > m_width || y + height > m_height)
+		return false;
+
+	const size_t stride = m_rowPitch / m_width;
+	const uint8_t* srcRow = static_cast<const uint8_t*>(src);
+	// tiles spanning whole rows are one contiguous range of the image
+	if (x == 0u && width == m_width && srcPitch == m_rowPitch)
+		return writeRange(size_t(y) * m_rowPitch, srcRow, m_rowPitch * height);
+
+	for (uint32_t row = 0u; row < height; row++, srcRow += srcPitch)
+	if (!writeRange(size_t(y + row) * m_rowPitch + size_t(x) * stride, srcRow, size_t(width) * stride))
+		return false;
+	return true;
+}
+
+bool CDDSWriter::close()
+{
+#ifdef _WIN32
+	if (!m_file)
+		return false;
+	const bool flushed = CloseHandle(static_cast<HANDLE>(m_file)) != 0;
+	m_file = nullptr;
+#else
+	if (m_file < 0)
+		return false;
+	const bool flushed = ::close(m_file) == 0;
+	m_file = -1;
+#endif
+
+	const bool complete = !m_failed && (m_updating || m_writtenSize == m_imageSize);
+	m_payloadOffset = m_imageSize = m_rowPitch = m_appendOffset = 0ull;
+	m_width = m_height = 0u;
+	m_writtenSize = 0ull;
+	m_failed = false;
+	m_updating = false;
+	return complete && flushed;
+}
@@ -0,0 +1,78 @@
+#ifndef __DBR_C_DDS_WRITER_H_INCLUDED__
+#define __DBR_C_DDS_WRITER_H_INCLUDED__
+
+#include "gli/format.hpp"
+
+#include <atomic>
+#include <string>
+
+namespace dbr
+{
+
+/*
+	Writes a single level 2D DDS file a band of rows or a tile at a time, for outputs that never exist in memory whole
+	or that should be on their way to disk while the rest of them is still being denoised.
+
+	The header goes out on `open`, the image then in appended bands with `write` or in any order with `writeRange` and
+	`writeTile`. Those are positioned writes (`pwrite`), so several threads can write different parts of the image at once.
+	The header is the one `gli::save_dds` writes for a `gli::texture2d` of the same format and extent,
+	so the files can't be told apart from the ones saved in one go.
+	Images that are whole in memory can be written with `save`, straight from wherever they are.
+*/
+class CDDSWriter
+{
+	public:
+		CDDSWriter() = default;
+		~CDDSWriter() { close(); }
+
+		CDDSWriter(const CDDSWriter&) = delete;
+		CDDSWriter& operator=(const CDDSWriter&) = delete;
+
+		/*
+			Header and image in two writes, where `gli::save_dds` would need the image copied into a zero filled `gli::texture2d`
+			first and then copies that whole again into a buffer of the entire file.
+		*/
+		static bool save(const std::string& path, gli::format format, uint32_t width, uint32_t height, const void* src);
+
+		//! Writes the header, only formats with a block extent of 1 can be written by rows
+		bool open(const std::string& path, gli::format format, uint32_t width, uint32_t height);
+		//! Opens an existing file of exactly that format and extent to overwrite parts of its image, whatever wrote its header
+		bool openForUpdate(const std::string& path, gli::format format, uint32_t width, uint32_t height);
+		//! Appends the next `size` bytes of the image, whole rows or not, not to be mixed with the other writes
+		bool write(const void* src, size_t size);
+		//! Overwrites `size` bytes `offset` bytes into the image, i.e. a span of a row, thread safe
+		bool writeRange(size_t offset, const void* src, size_t size);
+		//! Writes the `width`x`height` pixels at `x`,`y` from `src`, whose rows start `srcPitch` bytes apart, thread safe
+		bool writeTile(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* src, size_t srcPitch);
+		/*
+			Returns false if it couldn't be flushed or, unless opened for update, less than the whole image got written.
+			That's counted in bytes, so every part of the image has to be written exactly once.
+		*/
+		bool close();
+
+		inline size_t getImageSize() const { return m_imageSize; }
+		inline size_t getWrittenSize() const { return m_writtenSize; }
+
+	private:
+		//! All of `size` or nothing
+		bool writeAt(size_t fileOffset, const void* src, size_t size);
+
+#ifdef _WIN32
+		void* m_file = nullptr;
+#else
+		int m_file = -1;
+#endif
+		size_t m_payloadOffset = 0ull;
+		size_t m_imageSize = 0ull;
+		size_t m_rowPitch = 0ull;
+		uint32_t m_width = 0u;
+		uint32_t m_height = 0u;
+		size_t m_appendOffset = 0ull;
+		std::atomic<size_t> m_writtenSize = 0ull;
+		std::atomic<bool> m_failed = false;
+		bool m_updating = false;
+};
+
+}
+
+#endif // __DBR_C_DDS_WRITER_H_INCLUDED__
@@ -0,0 +1,106 @@
+#include "io/CFilePrefetcher.h"
+#include "core/Clock.h"
+
+#include <memory>
+#include <climits>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace dbr;
+
+namespace
+{
+
+// big enough for few syscalls, small enough to notice quickly that the loader caught up
+constexpr size_t ReadChunkSize = 1ull << 20ull;
+
+}
+
+CFilePrefetcher::CFilePrefetcher(uint32_t threadCount) : m_pool(threadCount)
+{
+}
+
+CFilePrefetcher::~CFilePrefetcher()
+{
+	m_stopping = true;
+}
+
+void CFilePrefetcher::prefetch(uint64_t frame, const std::vector<std::string>& paths)
+{
+	for (const auto& path : paths)
+	{
+		m_pool.enqueue([this, frame, path]()
+		{
+			const auto begin = steady_clock_t::now();
+			uint64_t bytes = 0ull;
+			if (prefetchFile(frame, path, bytes))
+				m_files++;
+			else
+				m_skipped++;
+			m_bytes += bytes;
+			m_nanoseconds += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock_t::now() - begin).count());
+		});
+	}
+}
+
+bool CFilePrefetcher::prefetchFile(uint64_t frame, const std::string& path, uint64_t& outBytes)
+{
+	if (isStale(frame))
+		return false;
+
+	// reads straight into a scratch chunk that's thrown away, only the page cache is meant to keep the data
+	auto chunk = std::make_unique<uint8_t[]>(ReadChunkSize);
+#ifdef _WIN32
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+	std::setvbuf(file, nullptr, _IONBF, 0);
+
+	size_t readSize = 0ull;
+	while (!isStale(frame) && (readSize = std::fread(chunk.get(), 1u, ReadChunkSize, file)) > 0ull)
+		outBytes += readSize;
+	const bool complete = std::feof(file);
+	std::fclose(file);
+	return complete;
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	// starts asynchronous readahead of the whole file before the first blocking read
+#ifdef __APPLE__
+	radvisory advice = { 0,0 };
+	const off_t size = lseek(fd, 0, SEEK_END);
+	if (size > 0)
+	{
+		advice.ra_count = size > INT_MAX ? INT_MAX : int(size);
+		fcntl(fd, F_RDADVISE, &advice);
+	}
+	lseek(fd, 0, SEEK_SET);
+#else
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	ssize_t readSize = -1;
+	while (!isStale(frame) && (readSize = ::read(fd, chunk.get(), ReadChunkSize)) > 0)
+		outBytes += uint64_t(readSize);
+	::close(fd);
+	return readSize == 0;
+#endif
+}
+
+CFilePrefetcher::SStatistics CFilePrefetcher::getStatistics() const
+{
+	SStatistics statistics;
+	statistics.files = m_files;
+	statistics.bytes = m_bytes;
+	statistics.skipped = m_skipped;
+	statistics.milliseconds = double(m_nanoseconds) / 1000000.0;
+	return statistics;
+}
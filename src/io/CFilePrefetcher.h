@@ -0,0 +1,67 @@
+#ifndef __DBR_C_FILE_PREFETCHER_H_INCLUDED__
+#define __DBR_C_FILE_PREFETCHER_H_INCLUDED__
+
+#include "core/CThreadPool.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace dbr
+{
+
+/*
+	Pulls the files of upcoming frames into the page cache in the background, so the loader finds them there
+	instead of waiting on cold reads from network storage.
+
+	Every file gets a `posix_fadvise(POSIX_FADV_WILLNEED)` hint (`F_RDADVISE` on macOS) and then gets read through on one
+	of the prefetching threads, since NFS clients honour the hint only as far as their readahead window reaches.
+	Files are tagged with the number of the frame they belong to, once the loader got to that frame they're skipped,
+	reading them again would only compete with the loader for bandwidth.
+*/
+class CFilePrefetcher
+{
+	public:
+		struct SStatistics
+		{
+			uint64_t files = 0ull;
+			uint64_t bytes = 0ull;
+			//! the loader caught up with them first, or they couldn't be opened
+			uint64_t skipped = 0ull;
+			//! summed over the prefetching threads
+			double milliseconds = 0.0;
+		};
+
+		//! `threadCount` files get read at the same time, one per input of a frame by default
+		explicit CFilePrefetcher(uint32_t threadCount = 3u);
+		//! Skips what's still queued, only waits for the reads in flight
+		~CFilePrefetcher();
+
+		CFilePrefetcher(const CFilePrefetcher&) = delete;
+		CFilePrefetcher& operator=(const CFilePrefetcher&) = delete;
+
+		//! `frame` has to be bigger than the one last passed to `setCurrentFrame` for the files to get read at all
+		void prefetch(uint64_t frame, const std::vector<std::string>& paths);
+		//! Frames up to and including `frame` are being loaded or done, their files aren't worth reading anymore
+		inline void setCurrentFrame(uint64_t frame) { m_currentFrame = frame; }
+
+		SStatistics getStatistics() const;
+
+	private:
+		//! Returns false if the file got skipped
+		bool prefetchFile(uint64_t frame, const std::string& path, uint64_t& outBytes);
+		inline bool isStale(uint64_t frame) const { return m_stopping || frame <= m_currentFrame; }
+
+		std::atomic<uint64_t> m_currentFrame = 0ull;
+		std::atomic<bool> m_stopping = false;
+		std::atomic<uint64_t> m_files = 0ull;
+		std::atomic<uint64_t> m_bytes = 0ull;
+		std::atomic<uint64_t> m_skipped = 0ull;
+		std::atomic<uint64_t> m_nanoseconds = 0ull;
+		// last, so it drains its queue while everything above is still there
+		CThreadPool m_pool;
+};
+
+}
+
+#endif // __DBR_C_FILE_PREFETCHER_H_INCLUDED__
@@ -0,0 +1,100 @@
+#include "io/CMappedFile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace dbr;
+
+bool CMappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	m_file = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+	{
+		close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		close();
+		return false;
+	}
+
+	m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	// the mapping keeps the file alive, the descriptor isn't needed past this
+	struct stat status;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &status) == 0 && status.st_size > 0)
+		data = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<const uint8_t*>(data);
+	m_size = size_t(status.st_size);
+#endif
+	return true;
+}
+
+void CMappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file)
+		CloseHandle(m_file);
+	m_mapping = m_file = nullptr;
+#else
+	if (m_data)
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0ull;
+}
+
+void CMappedFile::willNeed(size_t offset, size_t size) const
+{
+	if (!m_data || offset >= m_size)
+		return;
+	size = (std::min)(size, m_size - offset);
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range = { const_cast<uint8_t*>(m_data) + offset,size };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// `madvise` wants a page aligned start
+	const size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+	const size_t alignedOffset = offset / pageSize * pageSize;
+	madvise(const_cast<uint8_t*>(m_data) + alignedOffset, size + offset - alignedOffset, MADV_WILLNEED);
+#endif
+}
@@ -0,0 +1,47 @@
+#ifndef __DBR_C_MAPPED_FILE_H_INCLUDED__
+#define __DBR_C_MAPPED_FILE_H_INCLUDED__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace dbr
+{
+
+/*
+	A whole file mapped read only into the address space.
+
+	Pages get faulted in from the page cache on first touch instead of being copied by a read, so a payload
+	stored in the exact layout it's used in can be handed around as a pointer without ever getting copied on the host.
+*/
+class CMappedFile
+{
+	public:
+		CMappedFile() = default;
+		~CMappedFile() { close(); }
+
+		CMappedFile(const CMappedFile&) = delete;
+		CMappedFile& operator=(const CMappedFile&) = delete;
+
+		//! Fails for empty files, there's nothing to map
+		bool open(const std::string& path);
+		void close();
+
+		//! Hints that `[offset,offset+size)` is about to be read front to back, so the OS can start reading it ahead
+		void willNeed(size_t offset, size_t size) const;
+
+		inline const uint8_t* getData() const { return m_data; }
+		inline size_t getSize() const { return m_size; }
+
+	private:
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0ull;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+};
+
+}
+
+#endif // __DBR_C_MAPPED_FILE_H_INCLUDED__
@@ -0,0 +1,22 @@
+#ifndef __DBR_FILE_OFFSET_H_INCLUDED__
+#define __DBR_FILE_OFFSET_H_INCLUDED__
+
+#include <cstdio>
+#include <cstddef>
+
+namespace dbr
+{
+
+//! `fseek` from the start with 64 bit offsets, the payloads of big stills are well past what a `long` reaches on Windows
+inline bool seekFile(std::FILE* file, size_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+	return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+}
+
+#endif // __DBR_FILE_OFFSET_H_INCLUDED__
@@ -0,0 +1,51 @@
+#include "io/FrameList.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+namespace dbr
+{
+
+bool loadFrameList(const std::string& path, std::vector<SFrameDesc>& outFrames)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	const std::filesystem::path baseDirectory = std::filesystem::path(path).parent_path();
+	auto resolve = [&baseDirectory](const std::string& entry) -> std::string
+	{
+		const std::filesystem::path entryPath(entry);
+		return entryPath.is_absolute() ? entry : (baseDirectory / entryPath).string();
+	};
+
+	std::string line;
+	for (uint32_t lineNumber = 1u; std::getline(file, line); lineNumber++)
+	{
+		const auto first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::istringstream tokens(line);
+		SFrameDesc frame;
+		for (auto& input : frame.inputs)
+			tokens >> input;
+		tokens >> frame.output;
+
+		if (frame.output.empty())
+		{
+			std::cerr << "ERROR: " << path << ":" << lineNumber << " expected `<color> <albedo> <normal> <output>`\n";
+			return false;
+		}
+
+		for (auto& input : frame.inputs)
+			input = resolve(input);
+		frame.output = resolve(frame.output);
+		outFrames.push_back(std::move(frame));
+	}
+	return true;
+}
+
+}
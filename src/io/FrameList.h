@@ -0,0 +1,26 @@
+#ifndef __DBR_FRAME_LIST_H_INCLUDED__
+#define __DBR_FRAME_LIST_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace dbr
+{
+
+struct SFrameDesc
+{
+	//! color, albedo, normal
+	std::array<std::string, EIK_RGB_ALBEDO_NORMAL> inputs;
+	std::string output;
+};
+
+//! One frame per line as `<color> <albedo> <normal> <output>`, blank lines and lines starting with `#` are skipped.
+//! Relative paths are resolved against the directory of the list file.
+bool loadFrameList(const std::string& path, std::vector<SFrameDesc>& outFrames);
+
+}
+
+#endif // __DBR_FRAME_LIST_H_INCLUDED__
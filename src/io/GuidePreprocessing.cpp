@@ -0,0 +1,111 @@
+#include "io/GuidePreprocessing.h"
+#include "core/half.h"
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+namespace dbr
+{
+
+namespace
+{
+
+// small enough for the intermediates to stay in L1
+constexpr size_t BlockPixels = 256ull;
+
+// branchless over the block with the channel count known at compile time, so the loops vectorize
+template<uint32_t ChannelCount>
+void clampAlbedoBlock(float* values, const size_t count)
+{
+	for (size_t p = 0ull; p < count; p++)
+	for (uint32_t c = 0u; c < 3u; c++)
+	{
+		const float value = values[p * ChannelCount + c];
+		values[p * ChannelCount + c] = value > 0.f ? (value < 1.f ? value : 1.f) : 0.f;
+	}
+}
+
+template<uint32_t ChannelCount>
+void processNormalBlock(float* values, const size_t count, const SGuidePreprocessing& preprocessing)
+{
+	// decoding is a fused multiply add and the transform an identity when they're off, so the loop stays free of branches
+	const float scale = preprocessing.unsignedNormals ? 2.f : 1.f;
+	const float bias = preprocessing.unsignedNormals ? -1.f : 0.f;
+	const std::array<float, 9> m = preprocessing.transformNormals ? preprocessing.normalMatrix : SGuidePreprocessing().normalMatrix;
+	const bool renormalize = preprocessing.renormalizeNormals;
+	for (size_t p = 0ull; p < count; p++)
+	{
+		float* n = values + p * ChannelCount;
+		const float x = n[0] * scale + bias;
+		const float y = n[1] * scale + bias;
+		const float z = n[2] * scale + bias;
+		const float tx = m[0] * x + m[1] * y + m[2] * z;
+		const float ty = m[3] * x + m[4] * y + m[5] * z;
+		const float tz = m[6] * x + m[7] * y + m[8] * z;
+		const float lengthSquared = tx * tx + ty * ty + tz * tz;
+		const float invLength = renormalize ? (lengthSquared > 0.f ? 1.f / std::sqrt(lengthSquared) : 0.f) : 1.f;
+		n[0] = tx * invLength;
+		n[1] = ty * invLength;
+		n[2] = tz * invLength;
+	}
+}
+
+// half layers go through floats a block at a time, float layers get processed where they are
+template<typename F>
+void processBlocks(const E_PIXEL_FORMAT format, void* pixels, const size_t begin, const size_t end, F&& processBlock)
+{
+	const uint32_t channelCount = getPixelFormatChannelCount(format);
+	if (format == EPF_FLOAT3 || format == EPF_FLOAT4)
+	{
+		float* values = static_cast<float*>(pixels) + begin * channelCount;
+		for (size_t offset = 0ull; offset < end - begin; offset += BlockPixels)
+			processBlock(values + offset * channelCount, std::min(BlockPixels, end - begin - offset));
+		return;
+	}
+
+	uint16_t* values = static_cast<uint16_t*>(pixels) + begin * channelCount;
+	float decoded[BlockPixels * 4u];
+	for (size_t offset = 0ull; offset < end - begin; offset += BlockPixels)
+	{
+		const size_t count = std::min(BlockPixels, end - begin - offset);
+		uint16_t* block = values + offset * channelCount;
+		convertHalfToFloat(block, decoded, count * channelCount);
+		processBlock(decoded, count);
+		convertFloatToHalf(decoded, block, count * channelCount);
+	}
+}
+
+}
+
+void preprocessAlbedo(E_PIXEL_FORMAT format, void* pixels, const SGuidePreprocessing& preprocessing, size_t begin, size_t end)
+{
+	if (!preprocessing.processesAlbedo() || begin >= end)
+		return;
+
+	const bool fourChannels = getPixelFormatChannelCount(format) == 4u;
+	processBlocks(format, pixels, begin, end, [fourChannels](float* values, size_t count)
+	{
+		if (fourChannels)
+			clampAlbedoBlock<4u>(values, count);
+		else
+			clampAlbedoBlock<3u>(values, count);
+	});
+}
+
+void preprocessNormals(E_PIXEL_FORMAT format, void* pixels, const SGuidePreprocessing& preprocessing, size_t begin, size_t end)
+{
+	if (!preprocessing.processesNormals() || begin >= end)
+		return;
+
+	const bool fourChannels = getPixelFormatChannelCount(format) == 4u;
+	processBlocks(format, pixels, begin, end, [fourChannels, &preprocessing](float* values, size_t count)
+	{
+		if (fourChannels)
+			processNormalBlock<4u>(values, count, preprocessing);
+		else
+			processNormalBlock<3u>(values, count, preprocessing);
+	});
+}
+
+}
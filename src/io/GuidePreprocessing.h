@@ -0,0 +1,39 @@
+#ifndef __DBR_GUIDE_PREPROCESSING_H_INCLUDED__
+#define __DBR_GUIDE_PREPROCESSING_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <array>
+
+namespace dbr
+{
+
+/*
+	Brings albedo and normal inputs to what the denoiser expects: albedo in [0,1] and camera space unit normals in [-1,1].
+	Renderers often store normals in world space, as `n*0.5+0.5` for unsigned formats, or interpolated without renormalizing.
+*/
+struct SGuidePreprocessing
+{
+	//! clamps albedo to [0,1]
+	bool clampAlbedo = false;
+	//! normals are stored as `n*0.5+0.5` and get decoded with `n*2-1`
+	bool unsignedNormals = false;
+	//! normals get multiplied by `normalMatrix` after decoding, i.e. the rotation part of the world to camera matrix
+	bool transformNormals = false;
+	//! row major, `n' = M*n`
+	std::array<float, 9> normalMatrix = { 1.f,0.f,0.f, 0.f,1.f,0.f, 0.f,0.f,1.f };
+	//! normals get scaled to unit length last, zero length ones stay zero
+	bool renormalizeNormals = false;
+
+	inline bool processesAlbedo() const { return clampAlbedo; }
+	inline bool processesNormals() const { return unsignedNormals || transformNormals || renormalizeNormals; }
+};
+
+//! Processes the pixels `[begin,end)` of a tightly packed albedo image in place, independent ranges can be processed in parallel
+void preprocessAlbedo(E_PIXEL_FORMAT format, void* pixels, const SGuidePreprocessing& preprocessing, size_t begin, size_t end);
+//! Same for normals, decoding, transforming and renormalizing in one pass
+void preprocessNormals(E_PIXEL_FORMAT format, void* pixels, const SGuidePreprocessing& preprocessing, size_t begin, size_t end);
+
+}
+
+#endif // __DBR_GUIDE_PREPROCESSING_H_INCLUDED__
@@ -0,0 +1,143 @@
+#include "io/PixelSanitizer.h"
+
+#include <array>
+#include <algorithm>
+
+namespace dbr
+{
+
+namespace
+{
+
+constexpr size_t BlockPixels = 256ull;
+
+//! Bit patterns of IEEE half and float, everything here works on the raw bits so no value has to be converted
+template<typename T>
+struct SBits;
+
+template<>
+struct SBits<uint16_t>
+{
+	static constexpr uint16_t Exponent = 0x7c00u;
+	static constexpr uint16_t Magnitude = 0x7fffu;
+	static constexpr uint16_t Sign = 0x8000u;
+	static constexpr uint16_t MaxFinite = 0x7bffu;
+};
+
+template<>
+struct SBits<uint32_t>
+{
+	static constexpr uint32_t Exponent = 0x7f800000u;
+	static constexpr uint32_t Magnitude = 0x7fffffffu;
+	static constexpr uint32_t Sign = 0x80000000u;
+	static constexpr uint32_t MaxFinite = 0x7f7fffffu;
+};
+
+template<typename T>
+void sanitizeValues(T* values, const uint32_t channelCount, const uint32_t width, const size_t begin, const size_t end, const bool allowNegative, const E_SANITIZE_MODE mode, SSanitizeStatistics& statistics)
+{
+	using bits_t = SBits<T>;
+
+	// which values of a block get checked for their sign, the color channels unless negative ones are fine
+	std::array<T, BlockPixels * 4u> signMasks;
+	for (size_t i = 0ull; i < signMasks.size(); i++)
+		signMasks[i] = !allowNegative && i % channelCount < 3u ? bits_t::Sign : T(0u);
+
+	for (size_t offset = begin; offset < end; offset += BlockPixels)
+	{
+		const size_t count = std::min(BlockPixels, end - offset);
+		T* block = values + offset * channelCount;
+
+		// -0 has the sign bit but no magnitude, so it doesn't count as negative
+		uint32_t found = 0u;
+		for (size_t i = 0ull; i < count * channelCount; i++)
+		{
+			const T value = block[i];
+			found |= uint32_t((value & bits_t::Exponent) == bits_t::Exponent) | (uint32_t((value & signMasks[i]) != 0u) & uint32_t((value & bits_t::Magnitude) != 0u));
+		}
+		if (!found)
+			continue;
+
+		for (size_t p = 0ull; p < count; p++)
+		{
+			bool bad = false;
+			for (uint32_t c = 0u; c < channelCount; c++)
+			{
+				T& value = block[p * channelCount + c];
+				const T magnitude = value & bits_t::Magnitude;
+				if (magnitude > bits_t::Exponent)
+				{
+					statistics.nans++;
+					if (mode == ESM_CLAMP)
+						value = T(0u);
+				}
+				else if (magnitude == bits_t::Exponent)
+				{
+					statistics.infinities++;
+					if (mode == ESM_CLAMP)
+						value = (value & bits_t::Sign) ? T(0u) : bits_t::MaxFinite;
+				}
+				else if ((value & signMasks[c]) && magnitude)
+				{
+					statistics.negatives++;
+					if (mode == ESM_CLAMP)
+						value = T(0u);
+				}
+				else
+					continue;
+				bad = true;
+			}
+			if (!bad)
+				continue;
+
+			const size_t pixel = offset + p;
+			const uint32_t x = static_cast<uint32_t>(pixel % width);
+			const uint32_t y = static_cast<uint32_t>(pixel / width);
+			statistics.minX = std::min(statistics.minX, x);
+			statistics.minY = std::min(statistics.minY, y);
+			statistics.maxX = std::max(statistics.maxX, x);
+			statistics.maxY = std::max(statistics.maxY, y);
+		}
+	}
+}
+
+}
+
+const char* getSanitizeModeName(E_SANITIZE_MODE mode)
+{
+	constexpr const char* names[ESM_COUNT] = { "off","detect","clamp" };
+	return mode < ESM_COUNT ? names[mode] : "unknown";
+}
+
+E_SANITIZE_MODE getSanitizeModeFromName(std::string_view name)
+{
+	for (uint32_t mode = 0u; mode < ESM_COUNT; mode++)
+	if (name == getSanitizeModeName(E_SANITIZE_MODE(mode)))
+		return E_SANITIZE_MODE(mode);
+	return ESM_COUNT;
+}
+
+void SSanitizeStatistics::merge(const SSanitizeStatistics& other)
+{
+	nans += other.nans;
+	infinities += other.infinities;
+	negatives += other.negatives;
+	minX = std::min(minX, other.minX);
+	minY = std::min(minY, other.minY);
+	maxX = std::max(maxX, other.maxX);
+	maxY = std::max(maxY, other.maxY);
+}
+
+void sanitizePixels(E_PIXEL_FORMAT format, void* pixels, uint32_t width, size_t begin, size_t end, bool allowNegative, E_SANITIZE_MODE mode, SSanitizeStatistics& statistics)
+{
+	if (mode == ESM_OFF || begin >= end || !width)
+		return;
+
+	const uint32_t channelCount = getPixelFormatChannelCount(format);
+	if (format == EPF_HALF3 || format == EPF_HALF4)
+		sanitizeValues(static_cast<uint16_t*>(pixels), channelCount, width, begin, end, allowNegative, mode, statistics);
+	else
+		sanitizeValues(static_cast<uint32_t*>(pixels), channelCount, width, begin, end, allowNegative, mode, statistics);
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef __DBR_PIXEL_SANITIZER_H_INCLUDED__
+#define __DBR_PIXEL_SANITIZER_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <string_view>
+
+namespace dbr
+{
+
+enum E_SANITIZE_MODE : uint8_t
+{
+	ESM_OFF,
+	//! only counts
+	ESM_DETECT,
+	//! NaN, -Inf and negative values become 0, +Inf the largest finite value
+	ESM_CLAMP,
+	ESM_COUNT
+};
+
+const char* getSanitizeModeName(E_SANITIZE_MODE mode);
+//! Returns `ESM_COUNT` for names it doesn't know
+E_SANITIZE_MODE getSanitizeModeFromName(std::string_view name);
+
+//! What got found in a range of pixels, partial results of disjoint ranges can be merged in any order
+struct SSanitizeStatistics
+{
+	uint64_t nans = 0ull;
+	uint64_t infinities = 0ull;
+	uint64_t negatives = 0ull;
+	//! bounding box of the pixels with any of them, inclusive, only valid if `getCount()` isn't 0
+	uint32_t minX = ~0u;
+	uint32_t minY = ~0u;
+	uint32_t maxX = 0u;
+	uint32_t maxY = 0u;
+
+	inline uint64_t getCount() const { return nans + infinities + negatives; }
+	void merge(const SSanitizeStatistics& other);
+};
+
+/*
+	Finds the non finite values of the pixels `[begin,end)` of a tightly packed `width` pixels wide image and, unless `allowNegative`
+	(i.e. for normals), the negative ones too, alpha can always be negative. With `ESM_CLAMP` they get replaced in place.
+
+	Blocks get checked with a bitwise reduction over the raw half or float bits that vectorizes, only blocks where it finds
+	something go through the values one at a time, so clean images cost about as much as reading them once from cache.
+*/
+void sanitizePixels(E_PIXEL_FORMAT format, void* pixels, uint32_t width, size_t begin, size_t end, bool allowNegative, E_SANITIZE_MODE mode, SSanitizeStatistics& statistics);
+
+}
+
+#endif // __DBR_PIXEL_SANITIZER_H_INCLUDED__
@@ -0,0 +1,134 @@
+#include "io/Tonemap.h"
+#include "core/half.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace dbr
+{
+
+namespace
+{
+
+// small enough for the intermediates to stay in L1
+constexpr size_t BlockPixels = 256ull;
+// fine enough to be within a code of the exact sRGB curve even where it's steepest, small enough to stay in L1
+constexpr uint32_t EncodeTableSize = 1u << 14u;
+// every curve is within half a code of white from here on
+constexpr float MaxExposed = 65504.f;
+
+const std::array<uint8_t, EncodeTableSize>& getSRGBEncodeTable()
+{
+	static const std::array<uint8_t, EncodeTableSize> table = []()
+	{
+		std::array<uint8_t, EncodeTableSize> retval;
+		for (uint32_t i = 0u; i < EncodeTableSize; i++)
+		{
+			const float c = float(i) / float(EncodeTableSize - 1u);
+			const float encoded = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+			retval[i] = static_cast<uint8_t>(std::lround(encoded * 255.f));
+		}
+		return retval;
+	}();
+	return table;
+}
+
+// branchless and without calls, so the compiler vectorizes them over a whole block
+template<E_TONEMAP_OPERATOR Op>
+void tonemapBlock(float* rgba, const size_t count, const float scale)
+{
+	for (size_t i = 0ull; i < count * 4ull; i++)
+	{
+		// NaN fails every comparison, so it ends up black like negative values, Inf saturates instead of making the curves NaN
+		const float exposed = rgba[i] * scale;
+		const float x = exposed > 0.f ? (exposed < MaxExposed ? exposed : MaxExposed) : 0.f;
+		float mapped;
+		if constexpr (Op == ETO_REINHARD)
+			mapped = x / (1.f + x);
+		else if constexpr (Op == ETO_ACES)
+			mapped = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+		else
+			mapped = x;
+		rgba[i] = (i & 3ull) == 3ull ? rgba[i] : mapped;
+	}
+}
+
+}
+
+const char* getTonemapOperatorName(E_TONEMAP_OPERATOR op)
+{
+	constexpr const char* names[ETO_COUNT] = { "clamp","reinhard","aces" };
+	return op < ETO_COUNT ? names[op] : "unknown";
+}
+
+E_TONEMAP_OPERATOR getTonemapOperatorFromName(std::string_view name)
+{
+	for (uint32_t op = 0u; op < ETO_COUNT; op++)
+	if (name == getTonemapOperatorName(E_TONEMAP_OPERATOR(op)))
+		return E_TONEMAP_OPERATOR(op);
+	return ETO_COUNT;
+}
+
+void tonemapPixels(E_PIXEL_FORMAT srcFormat, const void* src, const STonemapParameters& parameters, uint8_t* dst, size_t begin, size_t end)
+{
+	if (begin >= end)
+		return;
+
+	const uint32_t channelCount = getPixelFormatChannelCount(srcFormat);
+	const bool half = srcFormat == EPF_HALF3 || srcFormat == EPF_HALF4;
+	const size_t srcStride = getPixelFormatStride(srcFormat);
+	const uint8_t* in = static_cast<const uint8_t*>(src) + begin * srcStride;
+	uint8_t* out = dst + begin * 4ull;
+	const size_t count = end - begin;
+
+	const float scale = std::exp2(parameters.exposure);
+	const auto& encodeTable = getSRGBEncodeTable();
+	float interleaved[BlockPixels * 4u];
+	float rgba[BlockPixels * 4u];
+	for (size_t offset = 0ull; offset < count; offset += BlockPixels)
+	{
+		const size_t blockCount = std::min(BlockPixels, count - offset);
+		const size_t valueCount = blockCount * channelCount;
+		const uint8_t* blockIn = in + offset * srcStride;
+		if (half)
+			convertHalfToFloat(reinterpret_cast<const uint16_t*>(blockIn), interleaved, valueCount);
+		else
+			std::memcpy(interleaved, blockIn, valueCount * sizeof(float));
+
+		if (channelCount == 4u)
+			std::memcpy(rgba, interleaved, valueCount * sizeof(float));
+		else
+		for (size_t p = 0ull; p < blockCount; p++)
+		{
+			rgba[p * 4u + 0u] = interleaved[p * 3u + 0u];
+			rgba[p * 4u + 1u] = interleaved[p * 3u + 1u];
+			rgba[p * 4u + 2u] = interleaved[p * 3u + 2u];
+			rgba[p * 4u + 3u] = 1.f;
+		}
+
+		switch (parameters.op)
+		{
+			case ETO_REINHARD:
+				tonemapBlock<ETO_REINHARD>(rgba, blockCount, scale);
+				break;
+			case ETO_ACES:
+				tonemapBlock<ETO_ACES>(rgba, blockCount, scale);
+				break;
+			default:
+				tonemapBlock<ETO_CLAMP>(rgba, blockCount, scale);
+				break;
+		}
+
+		// color through the table, alpha is linear
+		uint8_t* blockOut = out + offset * 4ull;
+		for (size_t i = 0ull; i < blockCount * 4ull; i++)
+		{
+			const float c = rgba[i] > 0.f ? (rgba[i] < 1.f ? rgba[i] : 1.f) : 0.f;
+			blockOut[i] = (i & 3ull) == 3ull ? static_cast<uint8_t>(c * 255.f + 0.5f) : encodeTable[static_cast<uint32_t>(c * float(EncodeTableSize - 1u) + 0.5f)];
+		}
+	}
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef __DBR_TONEMAP_H_INCLUDED__
+#define __DBR_TONEMAP_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include <string_view>
+
+namespace dbr
+{
+
+enum E_TONEMAP_OPERATOR : uint8_t
+{
+	//! clamps to 1
+	ETO_CLAMP,
+	//! `x/(1+x)` per channel
+	ETO_REINHARD,
+	//! Narkowicz's fit of the ACES filmic curve
+	ETO_ACES,
+	ETO_COUNT
+};
+
+struct STonemapParameters
+{
+	E_TONEMAP_OPERATOR op = ETO_ACES;
+	//! in stops, applied before the curve
+	float exposure = 0.f;
+};
+
+const char* getTonemapOperatorName(E_TONEMAP_OPERATOR op);
+//! Returns `ETO_COUNT` for names it doesn't know
+E_TONEMAP_OPERATOR getTonemapOperatorFromName(std::string_view name);
+
+/*
+	Exposes, tonemaps, sRGB encodes and quantises the pixels `[begin,end)` of a tightly packed HDR image to `FORMAT_RGBA8_SRGB_PACK8`
+	in one pass, independent ranges can be converted in parallel. Alpha gets clamped and stays linear, missing alpha becomes opaque.
+*/
+void tonemapPixels(E_PIXEL_FORMAT srcFormat, const void* src, const STonemapParameters& parameters, uint8_t* dst, size_t begin, size_t end);
+
+}
+
+#endif // __DBR_TONEMAP_H_INCLUDED__
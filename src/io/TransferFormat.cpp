@@ -0,0 +1,222 @@
+#include "io/TransferFormat.h"
+#include "core/half.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace dbr
+{
+
+namespace
+{
+
+enum E_SOURCE_TYPE : uint8_t
+{
+	EST_HALF,
+	EST_FLOAT,
+	EST_UNORM8,
+	EST_SRGB8
+};
+
+struct SSourceDesc
+{
+	gli::format format;
+	const char* name;
+	E_SOURCE_TYPE type;
+	uint32_t channelCount;
+	bool bgr;
+};
+
+constexpr SSourceDesc sourceDescs[] =
+{
+	{ gli::FORMAT_RGBA16_SFLOAT_PACK16, "RGBA16_SFLOAT", EST_HALF, 4u, false },
+	{ gli::FORMAT_RGB16_SFLOAT_PACK16, "RGB16_SFLOAT", EST_HALF, 3u, false },
+	{ gli::FORMAT_RGBA32_SFLOAT_PACK32, "RGBA32_SFLOAT", EST_FLOAT, 4u, false },
+	{ gli::FORMAT_RGB32_SFLOAT_PACK32, "RGB32_SFLOAT", EST_FLOAT, 3u, false },
+	{ gli::FORMAT_RGBA8_UNORM_PACK8, "RGBA8_UNORM", EST_UNORM8, 4u, false },
+	{ gli::FORMAT_RGBA8_SRGB_PACK8, "RGBA8_SRGB", EST_SRGB8, 4u, false },
+	{ gli::FORMAT_BGRA8_UNORM_PACK8, "BGRA8_UNORM", EST_UNORM8, 4u, true },
+	{ gli::FORMAT_BGRA8_SRGB_PACK8, "BGRA8_SRGB", EST_SRGB8, 4u, true }
+};
+
+const SSourceDesc* findSourceDesc(const gli::format format)
+{
+	for (const auto& desc : sourceDescs)
+	if (desc.format == format)
+		return &desc;
+	return nullptr;
+}
+
+inline bool isHalf(const E_PIXEL_FORMAT format)
+{
+	return format == EPF_HALF3 || format == EPF_HALF4;
+}
+
+// small enough for the intermediates to stay in L1
+constexpr size_t BlockPixels = 256ull;
+
+const std::array<float, 256u>& getSRGBTable()
+{
+	static const std::array<float, 256u> table = []()
+	{
+		std::array<float, 256u> retval;
+		for (uint32_t i = 0u; i < 256u; i++)
+		{
+			const float c = float(i) / 255.f;
+			retval[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return retval;
+	}();
+	return table;
+}
+
+// to RGBA floats, missing alpha becomes 1
+void decodeBlock(const SSourceDesc& desc, const uint8_t* src, const size_t count, float* rgba)
+{
+	float interleaved[BlockPixels * 4u];
+	const size_t valueCount = count * desc.channelCount;
+	switch (desc.type)
+	{
+		case EST_HALF:
+			convertHalfToFloat(reinterpret_cast<const uint16_t*>(src), interleaved, valueCount);
+			break;
+		case EST_FLOAT:
+			std::memcpy(interleaved, src, valueCount * sizeof(float));
+			break;
+		case EST_UNORM8:
+			for (size_t i = 0ull; i < valueCount; i++)
+				interleaved[i] = float(src[i]) * (1.f / 255.f);
+			break;
+		default:
+		{
+			const auto& table = getSRGBTable();
+			for (size_t i = 0ull; i < valueCount; i++)
+				interleaved[i] = (i & 3ull) == 3ull ? float(src[i]) * (1.f / 255.f) : table[src[i]]; // alpha is always linear
+			break;
+		}
+	}
+
+	const uint32_t red = desc.bgr ? 2u : 0u;
+	for (size_t p = 0ull; p < count; p++)
+	{
+		const float* in = interleaved + p * desc.channelCount;
+		float* out = rgba + p * 4u;
+		out[0] = in[red];
+		out[1] = in[1];
+		out[2] = in[2u - red];
+		out[3] = desc.channelCount == 4u ? in[3] : 1.f;
+	}
+}
+
+void encodeBlock(const float* rgba, const size_t count, const E_PIXEL_FORMAT dstFormat, uint8_t* dst)
+{
+	const uint32_t channelCount = getPixelFormatChannelCount(dstFormat);
+	float packed[BlockPixels * 4u];
+	float* out = isHalf(dstFormat) ? packed : reinterpret_cast<float*>(dst);
+	for (size_t p = 0ull; p < count; p++)
+	for (uint32_t c = 0u; c < channelCount; c++)
+		out[p * channelCount + c] = rgba[p * 4u + c];
+
+	if (isHalf(dstFormat))
+		convertFloatToHalf(packed, reinterpret_cast<uint16_t*>(dst), count * channelCount);
+}
+
+// same scalar type on both ends only adds or drops the alpha channel
+template<typename T>
+void repackPixels(const T* src, const uint32_t srcChannelCount, T* dst, const uint32_t dstChannelCount, const T one, const size_t count)
+{
+	for (size_t p = 0ull; p < count; p++)
+	{
+		const T* in = src + p * srcChannelCount;
+		T* out = dst + p * dstChannelCount;
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		if (dstChannelCount == 4u)
+			out[3] = srcChannelCount == 4u ? in[3] : one;
+	}
+}
+
+}
+
+bool negotiateTransferFormat(gli::format sourceFormat, uint32_t layer, STransferFormat& outTransfer)
+{
+	const SSourceDesc* desc = findSourceDesc(sourceFormat);
+	if (!desc)
+		return false;
+
+	if (layer == 0u)
+	{
+		switch (desc->type)
+		{
+			case EST_HALF:
+				outTransfer.format = desc->channelCount == 4u ? EPF_HALF4 : EPF_HALF3;
+				break;
+			case EST_FLOAT:
+				outTransfer.format = desc->channelCount == 4u ? EPF_FLOAT4 : EPF_FLOAT3;
+				break;
+			default:
+				outTransfer.format = EPF_HALF4; // 8 bits per channel fit in half losslessly
+				break;
+		}
+	}
+	else
+		outTransfer.format = EPF_HALF3;
+
+	outTransfer.direct = !desc->bgr && desc->type == (isHalf(outTransfer.format) ? EST_HALF : EST_FLOAT) && desc->channelCount == getPixelFormatChannelCount(outTransfer.format);
+	return true;
+}
+
+void convertPixels(gli::format sourceFormat, const void* src, E_PIXEL_FORMAT dstFormat, void* dst, size_t begin, size_t end)
+{
+	const SSourceDesc* desc = findSourceDesc(sourceFormat);
+	if (!desc || begin >= end)
+		return;
+
+	const size_t srcStride = gli::block_size(sourceFormat);
+	const size_t dstStride = getPixelFormatStride(dstFormat);
+	const uint8_t* in = static_cast<const uint8_t*>(src) + begin * srcStride;
+	uint8_t* out = static_cast<uint8_t*>(dst) + begin * dstStride;
+	const size_t count = end - begin;
+
+	const uint32_t dstChannelCount = getPixelFormatChannelCount(dstFormat);
+	if (desc->type == EST_HALF && isHalf(dstFormat))
+		repackPixels(reinterpret_cast<const uint16_t*>(in), desc->channelCount, reinterpret_cast<uint16_t*>(out), dstChannelCount, uint16_t(0x3c00u), count);
+	else if (desc->type == EST_FLOAT && !isHalf(dstFormat) && !desc->bgr)
+		repackPixels(reinterpret_cast<const float*>(in), desc->channelCount, reinterpret_cast<float*>(out), dstChannelCount, 1.f, count);
+	else
+	{
+		float rgba[BlockPixels * 4u];
+		for (size_t offset = 0ull; offset < count; offset += BlockPixels)
+		{
+			const size_t blockCount = std::min(BlockPixels, count - offset);
+			decodeBlock(*desc, in + offset * srcStride, blockCount, rgba);
+			encodeBlock(rgba, blockCount, dstFormat, out + offset * dstStride);
+		}
+	}
+}
+
+const char* getSourceFormatName(gli::format format)
+{
+	const SSourceDesc* desc = findSourceDesc(format);
+	return desc ? desc->name : "UNSUPPORTED";
+}
+
+gli::format getDDSFormat(E_PIXEL_FORMAT format)
+{
+	switch (format)
+	{
+		case EPF_HALF3:
+			return gli::FORMAT_RGB16_SFLOAT_PACK16;
+		case EPF_HALF4:
+			return gli::FORMAT_RGBA16_SFLOAT_PACK16;
+		case EPF_FLOAT3:
+			return gli::FORMAT_RGB32_SFLOAT_PACK32;
+		default:
+			return gli::FORMAT_RGBA32_SFLOAT_PACK32;
+	}
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef __DBR_TRANSFER_FORMAT_H_INCLUDED__
+#define __DBR_TRANSFER_FORMAT_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+
+#include "gli/format.hpp"
+
+namespace dbr
+{
+
+//! How an input layer stored as some `gli::format` gets to the denoiser
+struct STransferFormat
+{
+	E_PIXEL_FORMAT format = EPF_HALF4;
+	//! the file payload already is `format` and can be read straight into staging, otherwise it goes through `convertPixels`
+	bool direct = false;
+};
+
+/*
+	Picks the cheapest format the denoiser accepts for a layer (0 color, 1 albedo, 2 normal) without losing anything it uses.
+
+	Color keeps its precision, a float HDR value could overflow half, and its alpha since that gets passed through to the output.
+	Albedo and normal are bounded and their alpha is never looked at, so they always go as HALF3.
+	Returns false for source formats with no conversion.
+*/
+bool negotiateTransferFormat(gli::format sourceFormat, uint32_t layer, STransferFormat& outTransfer);
+
+//! Converts the pixels `[begin,end)` of a tightly packed image, independent ranges can be converted in parallel
+void convertPixels(gli::format sourceFormat, const void* src, E_PIXEL_FORMAT dstFormat, void* dst, size_t begin, size_t end);
+
+//! For the formats `negotiateTransferFormat` accepts
+const char* getSourceFormatName(gli::format format);
+
+//! What denoised pixels of `format` get saved as
+gli::format getDDSFormat(E_PIXEL_FORMAT format);
+
+}
+
+#endif // __DBR_TRANSFER_FORMAT_H_INCLUDED__
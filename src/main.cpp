@@ -2,275 +2,816 @@
 #include "nvidia/CheckMacros.h"
 
 #include <iostream>
+#include <iomanip>
 #include <vector>
 #include <string>
 #include <string_view>
 #include <filesystem>
 #include <array>
 #include <map>
-#include <cassert>
-
-#include <cuda.h>
-#include <optix.h>
-#include <optix_stubs.h>
-#include <optix_function_table_definition.h>
-#include <optix_denoiser_tiling.h>
-
-#include "gli/gli.hpp"
-
-void CU_CHECK(const CUresult result)
+#include <charconv>
+#include <csignal>
+#include <cstdlib>
+#include <cmath>
+
+#include "core/CProfiler.h"
+#include "denoiser/IDenoiserBackend.h"
+#include "denoiser/CDenoiserSession.h"
+#include "denoiser/CDenoiserBackendCPU.h"
+#include "denoiser/CAutotuner.h"
+#include "denoiser/CPooledDenoiserBackend.h"
+#include "io/FrameList.h"
+#include "pipeline/CFramePipeline.h"
+#include "pipeline/CDDSFrameStages.h"
+#include "pipeline/CDDSStreamingDenoiser.h"
+#include "pipeline/CCaptureFrameStages.h"
+#include "daemon/CDenoiserDaemon.h"
+#include "daemon/DaemonClient.h"
+
+using namespace dbr;
+
+void printTileSchedulerStatistics(const CHostTiledDenoiser& denoiser)
 {
-	if (result != CUDA_SUCCESS)
+	const auto& statistics = denoiser.getScheduler().getStatistics();
+	for (uint32_t w = 0u; w < statistics.workers.size(); w++)
 	{
-		const char* name;
-		cuGetErrorName(result, &name);
-		std::cerr << "ERROR: Failed with " << name << " (" << result << ")\n";
-		MY_ASSERT(!"CU_CHECK fatal");
+		const auto& worker = statistics.workers[w];
+		const auto& latencies = worker.latencies;
+		std::cout << std::fixed << std::setprecision(2)
+			<< "Host tile worker " << w << ": " << worker.tileCount << " tile(s), " << worker.stolenCount << " stolen, busy " << worker.busyMilliseconds
+			<< " ms of " << statistics.wallMilliseconds << " ms (" << 100.0 * statistics.getUtilization(w) << "% utilization), tile latency p50 <= "
+			<< latencies.getQuantileBound(0.5) << " ms, p90 <= " << latencies.getQuantileBound(0.9) << " ms, max " << latencies.maxMilliseconds << " ms\n";
+
+		std::cout << "\tlatency histogram:" << std::defaultfloat << std::setprecision(6);
+		for (uint32_t i = 0u; i < latencies.BucketCount; i++)
+		if (latencies.counts[i])
+		{
+			const bool last = i + 1u == latencies.BucketCount;
+			std::cout << (last ? " >" : " <=") << CTileScheduler::SLatencyHistogram::getBucketBound(last ? i - 1u : i) << " ms: " << latencies.counts[i];
+		}
+		std::cout << "\n";
 	}
 }
 
-void OPTIX_CHECK(const OptixResult result)
+void printMemoryPoolStatistics(const std::string& name, const CMemoryPool& pool)
 {
-	if (result != OPTIX_SUCCESS)
-	{
-		std::cerr << "ERROR: Failed with (" << result << ")\n";
-		MY_ASSERT(!"OPTIX_CHECK fatal");
-	}
+	const auto statistics = pool.getStatistics();
+	std::cout << std::fixed << std::setprecision(1) << name << " pool: " << statistics.allocations << " allocation(s), "
+		<< 100.0 * statistics.getReuseRate() << "% reused, " << statistics.upstreamAllocations << " upstream allocation(s) and "
+		<< statistics.upstreamDeallocations << " deallocation(s), peak " << double(statistics.peakUsedBytes) / double(1ull << 20ull) << " MiB in use and "
+		<< double(statistics.peakReservedBytes) / double(1ull << 20ull) << " MiB held, " << 100.0 * statistics.getInternalFragmentation()
+		<< "% lost to size classes, " << double(statistics.cachedBytes) / double(1ull << 20ull) << " MiB cached ("
+		<< 100.0 * statistics.getIdleFraction() << "% of what's held)\n";
 }
 
-constexpr uint32_t overlap = 64;
-//constexpr uint32_t tileWidth = 1920/2, tileHeight = 1080/2;
-constexpr uint32_t tileWidth = 1024, tileHeight = 1024;
-constexpr uint32_t tileWidthWithOverlap = tileWidth + overlap * 2;
-constexpr uint32_t tileHeightWithOverlap = tileHeight + overlap * 2;
-constexpr uint32_t outputDimensions[] = { tileWidth , tileHeight };
-
-void DBROptixDefaultCallback(unsigned int level, const char* tag, const char* message, void* cbdata)
+void printUsage()
 {
-	uint32_t contextID = reinterpret_cast<const uint32_t&>(cbdata);
-	printf("OptiX Context:%d [%s]: %s\n", contextID, tag, message);
+	std::cout << "Usage: denoiserBugReproductionApp [--backend=optix|cpu] [--sequence=<frame list>] [--pipelined[=<staging depth>]]\n";
+	std::cout << "\t[--memory-budget=<MiB>] [--tile-size=<width>x<height>] [--overlap=<pixels>] [--stats-json=<path>|-] [--trace=<path>]\n";
+	std::cout << "\t[--backend-intensity|--validate-intensity] [--denoiser-cache=<MiB>] [--host-tiles=<width>x<height> [--feather=<pixels>] [--host-tile-workers=<count>]]\n";
+	std::cout << "\t[--out-of-core] [--cpu-worker-threads=<count>[,<count>...]] [--tile-cache]\n";
+	std::cout << "\t[--roi=<x>,<y>,<width>x<height>] [--capture=<path>] [--replay=<path>]\n";
+	std::cout << "\t[--autotune=<width>x<height> [--autotune-runs=<count>]] [--tuning-profile=<path>]\n";
+	std::cout << "\t[--memory-pool[=<MiB>]] [--prefetch=<frames>] [--stream-output] [--ldr-preview[=clamp|reinhard|aces] [--ldr-exposure=<stops>]]\n";
+	std::cout << "\t[--sanitize-inputs=off|detect|clamp] [--albedo-clamp] [--normals-unsigned] [--normal-matrix=<9 or 16 comma separated floats>] [--renormalize-normals]\n";
+	std::cout << "\t[--daemon=<socket> [--daemon-workers=<count>] [--daemon-queue=<count>]] [--submit=<socket>] [--shutdown-daemon=<socket>]\n";
+	std::cout << "\tA frame list has one `<color> <albedo> <normal> <output>` DDS path quadruple per line.\n";
+	std::cout << "\t--pipelined overlaps loading, denoising and saving of consecutive frames, with double buffered staging by default.\n";
+	std::cout << "\t--prefetch reads the inputs of that many frames ahead (2 by default, 0 turns it off) into the page cache in the background.\n";
+	std::cout << "\tTiles are the largest that fit the memory budget (all free backend memory by default) unless --tile-size forces one.\n";
+	std::cout << "\t--stats-json writes per stage timings, byte counts and peak RSS as JSON lines, --trace writes them as a Chrome trace.\n";
+	std::cout << "\tThe HDR intensity gets computed on the host while loading, --backend-intensity uses the backend pass instead\n";
+	std::cout << "\tand --validate-intensity runs both and prints the two values.\n";
+	std::cout << "\t--host-tiles splits frames into tiles on the host and blends them back with a feathered ramp over the --overlap,\n";
+	std::cout << "\tspreading them over --host-tile-workers backends of the requested type with work stealing.\n";
+	std::cout << "\t--cpu-worker-threads gives the CPU backend of every host tile worker that many threads, the last count repeats,\n";
+	std::cout << "\tso CPU workers can stand in for several GPUs and a worker with fewer threads for a straggler.\n";
+	std::cout << "\t--out-of-core streams every frame from its inputs to its output one band of host tile rows at a time, for stills that\n";
+	std::cout << "\tdon't fit in host memory, with 512x512 host tiles unless --host-tiles says otherwise.\n";
+	std::cout << "\t--tile-cache reuses the denoised host tiles whose inputs, overlap included, didn't change since the previous frame,\n";
+	std::cout << "\tholding the HDR parameters while they change by less than 1%, also with 512x512 host tiles unless --host-tiles says otherwise.\n";
+	std::cout << "\t--stream-output writes the output rows of host tiles to disk as soon as they're blended, while later tiles are still\n";
+	std::cout << "\tbeing denoised, with 512x512 host tiles unless --host-tiles says otherwise. Not with --roi, --out-of-core streams anyway.\n";
+	std::cout << "\t--sanitize-inputs counts the NaN, Inf and negative (but for normals) input values while converting the inputs and\n";
+	std::cout << "\tprints where they are (detect, the default), clamp also replaces them with 0 or the largest finite value. By default it only\n";
+	std::cout << "\tchecks the inputs that get converted or gone through for other reasons anyway, an explicit mode also the ones loaded as they are.\n";
+	std::cout << "\tNeither detect nor clamp with --out-of-core or --replay, whose inputs don't go through that pass.\n";
+	std::cout << "\tThe guides get preprocessed in the same pass: --albedo-clamp clamps the albedo to [0,1], --normals-unsigned decodes normals\n";
+	std::cout << "\tstored as `n*0.5+0.5`, --normal-matrix transforms them to camera space with a row major 3x3 matrix or the upper left of a\n";
+	std::cout << "\t4x4 view matrix and --renormalize-normals scales them to unit length last. Neither with --out-of-core nor --replay.\n";
+	std::cout << "\t--ldr-preview also saves every output tonemapped (ACES by default) to 8 bit sRGB as `<name>_ldr.dds`, exposed by\n";
+	std::cout << "\t--ldr-exposure stops first. Neither with --roi nor --out-of-core.\n";
+	std::cout << "\t--roi only denoises the host tiles blending into the rectangle and only writes it into outputs that already exist,\n";
+	std::cout << "\tnew outputs get the noisy color around it. Not with --out-of-core.\n";
+	std::cout << "\t--capture bundles the inputs of every frame as they go to the denoiser with the settings into one file,\n";
+	std::cout << "\t--replay denoises the frames of such a file with its settings, the options given override them.\n";
+	std::cout << "\tReplayed outputs go next to the capture as `<name>_denoised.dds`, numbered for several frames. Neither with --out-of-core.\n";
+	std::cout << "\t--autotune times backend tilings of that resolution on the requested backend and stores the fastest in the tuning profile\n";
+	std::cout << "\t(" << DBR_ROOT << "/tuning_profile.txt by default) instead of denoising, the fastest of --autotune-runs (2 by default) counts.\n";
+	std::cout << "\tEvery run loads the profile and uses its tiling for the resolutions in it, unless --tile-size forces one.\n";
+	std::cout << "\t--daemon keeps --daemon-workers backends and their denoisers warm and serves jobs over a Unix domain socket until\n";
+	std::cout << "\t--shutdown-daemon, SIGINT or SIGTERM. Jobs beyond the --daemon-queue (4 by default) waiting ones get turned away as busy.\n";
+	std::cout << "\t--submit hands the frames to the daemon as one job instead of denoising them, retrying while it's busy.\n";
+	std::cout << "\tThe daemon denoises without host tiling, captures or a region of interest.\n";
+	std::cout << "\t--memory-pool serves backend device and pinned host memory from size class pools keeping up to that much\n";
+	std::cout << "\t(512 MiB by default) of freed blocks each for reuse, and prints how well they got reused.\n";
+	std::cout << "\t--denoiser-cache caps the memory of set up denoisers kept for tile shapes not in use (1024 MiB by default, 0 keeps none).\n";
 }
 
-
-int main()
+bool parseUnsigned(std::string_view str, uint32_t& outValue)
 {
-	CU_CHECK(cuInit(0));
-	OPTIX_CHECK(optixInit());
+	const auto result = std::from_chars(str.data(), str.data() + str.size(), outValue);
+	return result.ec == std::errc() && result.ptr == str.data() + str.size();
+}
 
-	bool status = true;
+bool parseFloat(std::string_view str, float& outValue)
+{
+	const std::string terminated(str);
+	char* end = nullptr;
+	outValue = std::strtof(terminated.c_str(), &end);
+	return !terminated.empty() && end == terminated.c_str() + terminated.size() && std::isfinite(outValue);
+}
 
-	constexpr std::array<std::string_view, 3> hardcodedInputs =
+//! Takes a row major 3x3 matrix or the upper left 3x3 of a row major 4x4 one
+bool parseNormalMatrix(std::string_view str, std::array<float, 9>& outMatrix)
+{
+	std::vector<float> values;
+	for (size_t begin = 0ull; begin <= str.size();)
 	{
-		"spp_benchmark_4k_512_reference_optix_input_color.dds",
-		"spp_benchmark_4k_512_reference_optix_input_albedo.dds",
-		"spp_benchmark_4k_512_reference_optix_input_normal.dds"
-	};
+		const size_t end = std::min(str.find(',', begin), str.size());
+		if (!parseFloat(str.substr(begin, end - begin), values.emplace_back()))
+			return false;
+		begin = end + 1ull;
+	}
+	if (values.size() != 9ull && values.size() != 16ull)
+		return false;
+
+	const uint32_t rowPitch = values.size() == 9ull ? 3u : 4u;
+	for (uint32_t r = 0u; r < 3u; r++)
+	for (uint32_t c = 0u; c < 3u; c++)
+		outMatrix[r * 3u + c] = values[r * rowPitch + c];
+	return true;
+}
 
-	uint32_t resolution[2] = { 0,0 };
-	std::array<gli::texture, hardcodedInputs.size()> inputKindTextures;
-	gli::texture outputTexture;
+int main(int argc, char** argv)
+{
+	E_BACKEND_TYPE backendType = getDefaultBackendType();
+	std::string sequencePath;
+	bool pipelined = false;
+	uint32_t stagingDepth = 2u;
+	uint32_t memoryBudgetMiB = 0u;
+	uint32_t tileWidth = 0u, tileHeight = 0u;
+	uint32_t overlap = 0u;
+	std::string statsPath, tracePath;
+	bool hostIntensity = true, validateIntensity = false;
+	uint32_t denoiserCacheMiB = 1024u;
+	uint32_t hostTileWidth = 0u, hostTileHeight = 0u;
+	uint32_t feather = CHostTiledDenoiser::SConfig::DefaultFeather;
+	uint32_t hostTileWorkers = 1u;
+	bool outOfCore = false;
+	bool tileCache = false;
+	CHostTiledDenoiser::STileRegion regionOfInterest;
+	std::vector<uint32_t> cpuWorkerThreads;
+	std::string capturePath, replayPath;
+	uint32_t autotuneWidth = 0u, autotuneHeight = 0u, autotuneRuns = 2u;
+	std::string tuningProfilePath = std::string(DBR_ROOT) + "/tuning_profile.txt";
+	std::string daemonPath, submitPath, shutdownPath;
+	uint32_t daemonWorkers = 1u, daemonQueue = 4u;
+	uint32_t memoryPoolMiB = 0u;
+	uint32_t prefetchDistance = 2u;
+	bool streamOutput = false;
+	bool ldrPreview = false;
+	E_SANITIZE_MODE sanitizeMode = ESM_DETECT;
+	bool sanitizeRequested = false;
+	SGuidePreprocessing guidePreprocessing;
+	STonemapParameters tonemapParameters;
+
+	// a replay starts out with the settings it got captured with, so it has to be opened before the options that override them
+	CCaptureReader capture;
+	for (int i = 1; i < argc; i++)
+	if (std::string_view(argv[i]).rfind("--replay=", 0) == 0)
+		replayPath = std::string_view(argv[i]).substr(std::string_view("--replay=").size());
+	if (!replayPath.empty())
 	{
-		uint8_t offset = {};
-		for (auto& hardcodedInput : hardcodedInputs)
+		if (!capture.open(replayPath))
 		{
-			const std::string inputFile = DBR_ROOT + std::string("/data/") + hardcodedInput.data();
-
-			inputKindTextures[offset] = gli::load_dds(inputFile);
-			status = !inputKindTextures[offset].empty();
-			assert(status); // Input hasn't been loaded!
+			std::cerr << "ERROR: " << replayPath << " is not a valid capture\n";
+			return 1;
+		}
 
-			auto extent = inputKindTextures[offset].extent(0);
+		const SCaptureSettings& settings = capture.getSettings();
+		tileWidth = settings.tileWidth;
+		tileHeight = settings.tileHeight;
+		overlap = settings.overlap;
+		memoryBudgetMiB = settings.memoryBudgetMiB;
+		hostTileWidth = settings.hostTileWidth;
+		hostTileHeight = settings.hostTileHeight;
+		feather = settings.feather;
+	}
 
-			for (auto i=0; i<2; i++)
-			if (resolution[i])
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		if (arg.rfind("--backend=", 0) == 0)
+			backendType = getBackendTypeFromName(arg.substr(std::string_view("--backend=").size()));
+		else if (arg.rfind("--sequence=", 0) == 0)
+			sequencePath = arg.substr(std::string_view("--sequence=").size());
+		else if (arg == "--pipelined")
+			pipelined = true;
+		else if (arg.rfind("--pipelined=", 0) == 0)
+		{
+			pipelined = true;
+			if (!parseUnsigned(arg.substr(std::string_view("--pipelined=").size()), stagingDepth) || !stagingDepth)
 			{
-				assert(resolution[i]==extent[i]);
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--memory-budget=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--memory-budget=").size()), memoryBudgetMiB) || !memoryBudgetMiB)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--tile-size=", 0) == 0)
+		{
+			const std::string_view size = arg.substr(std::string_view("--tile-size=").size());
+			const size_t separator = size.find('x');
+			if (separator == std::string_view::npos || !parseUnsigned(size.substr(0, separator), tileWidth) || !parseUnsigned(size.substr(separator + 1u), tileHeight) || !tileWidth || !tileHeight)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--overlap=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--overlap=").size()), overlap))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--stats-json=", 0) == 0)
+			statsPath = arg.substr(std::string_view("--stats-json=").size());
+		else if (arg.rfind("--trace=", 0) == 0)
+			tracePath = arg.substr(std::string_view("--trace=").size());
+		else if (arg == "--backend-intensity")
+			hostIntensity = false;
+		else if (arg == "--validate-intensity")
+			validateIntensity = true;
+		else if (arg.rfind("--host-tiles=", 0) == 0)
+		{
+			const std::string_view size = arg.substr(std::string_view("--host-tiles=").size());
+			const size_t separator = size.find('x');
+			if (separator == std::string_view::npos || !parseUnsigned(size.substr(0, separator), hostTileWidth) || !parseUnsigned(size.substr(separator + 1u), hostTileHeight) || !hostTileWidth || !hostTileHeight)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--feather=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--feather=").size()), feather))
+			{
+				printUsage();
+				return 1;
 			}
-			else
-				resolution[i] = extent[i];
-
-			if (offset == 0u)
-				outputTexture = inputKindTextures[offset]; // For copying header data
-
-			++offset;
+		}
+		else if (arg.rfind("--host-tile-workers=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--host-tile-workers=").size()), hostTileWorkers) || !hostTileWorkers)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg == "--out-of-core")
+			outOfCore = true;
+		else if (arg == "--tile-cache")
+			tileCache = true;
+		else if (arg.rfind("--roi=", 0) == 0)
+		{
+			const std::string_view region = arg.substr(std::string_view("--roi=").size());
+			const size_t first = region.find(','), second = region.find(',', first + 1u), separator = region.find('x', second + 1u);
+			if (second == std::string_view::npos || separator == std::string_view::npos ||
+				!parseUnsigned(region.substr(0, first), regionOfInterest.x) || !parseUnsigned(region.substr(first + 1u, second - first - 1u), regionOfInterest.y) ||
+				!parseUnsigned(region.substr(second + 1u, separator - second - 1u), regionOfInterest.width) || !parseUnsigned(region.substr(separator + 1u), regionOfInterest.height) ||
+				!regionOfInterest.width || !regionOfInterest.height)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--capture=", 0) == 0)
+			capturePath = arg.substr(std::string_view("--capture=").size());
+		else if (arg.rfind("--replay=", 0) == 0)
+			continue; // opened above
+		else if (arg.rfind("--autotune=", 0) == 0)
+		{
+			const std::string_view size = arg.substr(std::string_view("--autotune=").size());
+			const size_t separator = size.find('x');
+			if (separator == std::string_view::npos || !parseUnsigned(size.substr(0, separator), autotuneWidth) || !parseUnsigned(size.substr(separator + 1u), autotuneHeight) || !autotuneWidth || !autotuneHeight)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--autotune-runs=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--autotune-runs=").size()), autotuneRuns) || !autotuneRuns)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--tuning-profile=", 0) == 0)
+			tuningProfilePath = arg.substr(std::string_view("--tuning-profile=").size());
+		else if (arg == "--memory-pool")
+			memoryPoolMiB = 512u;
+		else if (arg.rfind("--memory-pool=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--memory-pool=").size()), memoryPoolMiB) || !memoryPoolMiB)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--sanitize-inputs=", 0) == 0)
+		{
+			sanitizeRequested = true;
+			sanitizeMode = getSanitizeModeFromName(arg.substr(std::string_view("--sanitize-inputs=").size()));
+			if (sanitizeMode == ESM_COUNT)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg == "--albedo-clamp")
+			guidePreprocessing.clampAlbedo = true;
+		else if (arg == "--normals-unsigned")
+			guidePreprocessing.unsignedNormals = true;
+		else if (arg == "--renormalize-normals")
+			guidePreprocessing.renormalizeNormals = true;
+		else if (arg.rfind("--normal-matrix=", 0) == 0)
+		{
+			guidePreprocessing.transformNormals = true;
+			if (!parseNormalMatrix(arg.substr(std::string_view("--normal-matrix=").size()), guidePreprocessing.normalMatrix))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg == "--ldr-preview")
+			ldrPreview = true;
+		else if (arg.rfind("--ldr-preview=", 0) == 0)
+		{
+			ldrPreview = true;
+			tonemapParameters.op = getTonemapOperatorFromName(arg.substr(std::string_view("--ldr-preview=").size()));
+			if (tonemapParameters.op == ETO_COUNT)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--ldr-exposure=", 0) == 0)
+		{
+			if (!parseFloat(arg.substr(std::string_view("--ldr-exposure=").size()), tonemapParameters.exposure))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg == "--stream-output")
+			streamOutput = true;
+		else if (arg.rfind("--prefetch=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--prefetch=").size()), prefetchDistance))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--daemon=", 0) == 0)
+			daemonPath = arg.substr(std::string_view("--daemon=").size());
+		else if (arg.rfind("--daemon-workers=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--daemon-workers=").size()), daemonWorkers) || !daemonWorkers)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--daemon-queue=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--daemon-queue=").size()), daemonQueue) || !daemonQueue)
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg.rfind("--submit=", 0) == 0)
+			submitPath = arg.substr(std::string_view("--submit=").size());
+		else if (arg.rfind("--shutdown-daemon=", 0) == 0)
+			shutdownPath = arg.substr(std::string_view("--shutdown-daemon=").size());
+		else if (arg.rfind("--cpu-worker-threads=", 0) == 0)
+		{
+			std::string_view counts = arg.substr(std::string_view("--cpu-worker-threads=").size());
+			while (true)
+			{
+				const size_t separator = counts.find(',');
+				if (!parseUnsigned(counts.substr(0, separator), cpuWorkerThreads.emplace_back()) || !cpuWorkerThreads.back())
+				{
+					printUsage();
+					return 1;
+				}
+				if (separator == std::string_view::npos)
+					break;
+				counts = counts.substr(separator + 1u);
+			}
+		}
+		else if (arg.rfind("--denoiser-cache=", 0) == 0)
+		{
+			if (!parseUnsigned(arg.substr(std::string_view("--denoiser-cache=").size()), denoiserCacheMiB))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else
+		{
+			printUsage();
+			return 1;
 		}
 	}
 
-	CUdevice device;
-	CU_CHECK(cuDeviceGet(&device,0u));
-
-	// create context
-	CUcontext context;
-	CU_CHECK(cuCtxCreate_v2(&context,CU_CTX_SCHED_YIELD | CU_CTX_MAP_HOST | CU_CTX_LMEM_RESIZE_TO_MAX,device));
+	const bool replaying = !replayPath.empty();
+	const bool daemon = !daemonPath.empty();
+	const bool sanitizing = sanitizeRequested && sanitizeMode != ESM_OFF;
+	if ((outOfCore && (regionOfInterest.width || replaying || !capturePath.empty())) || (replaying && !sequencePath.empty()) ||
+		(streamOutput && regionOfInterest.width) || (ldrPreview && (regionOfInterest.width || outOfCore)) ||
+		((sanitizing || guidePreprocessing.processesAlbedo() || guidePreprocessing.processesNormals()) && (outOfCore || replaying)) ||
+		(daemon && (sanitizing || guidePreprocessing.processesAlbedo() || guidePreprocessing.processesNormals() || hostTileWidth || outOfCore || tileCache || regionOfInterest.width || streamOutput || ldrPreview || replaying || !capturePath.empty() || autotuneWidth || !submitPath.empty())))
 	{
-		uint32_t version = 0u;
+		printUsage();
+		return 1;
+	}
+
+	if (!shutdownPath.empty())
+		return requestDaemonShutdown(shutdownPath) ? 0 : 1;
 
-		CU_CHECK(cuCtxGetApiVersion(context, &version));
+	bool status = true;
 
-		if (version < 3020)
+	std::vector<SFrameDesc> frames;
+	if (replaying)
+	{
+		const size_t frameCount = capture.getFrames().size();
+		const std::filesystem::path stem = std::filesystem::path(replayPath).replace_extension();
+		for (size_t i = 0ull; i < frameCount; i++)
+			frames.emplace_back().output = stem.string() + "_denoised" + (frameCount > 1ull ? "_" + std::to_string(i + 1u) : "") + ".dds";
+		if (frames.empty())
 		{
-			status = false;
-			assert(status);
+			std::cerr << "ERROR: " << replayPath << " has no frames\n";
 			return 1;
 		}
-
-		CU_CHECK(cuCtxSetCacheConfig(CU_FUNC_CACHE_PREFER_L1));
+	}
+	else if (sequencePath.empty())
+	{
+		constexpr std::array<std::string_view, 3> hardcodedInputs =
+		{
+			"spp_benchmark_4k_512_reference_optix_input_color.dds",
+			"spp_benchmark_4k_512_reference_optix_input_albedo.dds",
+			"spp_benchmark_4k_512_reference_optix_input_normal.dds"
+		};
+
+		SFrameDesc& frame = frames.emplace_back();
+		for (size_t k = 0; k < hardcodedInputs.size(); k++)
+			frame.inputs[k] = DBR_ROOT + std::string("/data/") + hardcodedInputs[k].data();
+		frame.output = std::string(DBR_ROOT) + "/outputResult.dds";
+	}
+	else if (!loadFrameList(sequencePath, frames) || frames.empty())
+	{
+		std::cerr << "ERROR: Could not read any frames from " << sequencePath << "\n";
+		return 1;
 	}
 
-	CUstream stream;
-	CU_CHECK(cuStreamCreate(&stream,CU_STREAM_NON_BLOCKING));
-
-	/*
-		Init Optix Context
-	*/
-
-	OptixDeviceContext optixContext;
-	OPTIX_CHECK(optixDeviceContextCreate(context, {}, &optixContext));
-	OPTIX_CHECK(optixDeviceContextSetLogCallback(optixContext, DBROptixDefaultCallback, reinterpret_cast<void*>(context), 3));
+	// the client doesn't need a backend of its own, that's the point
+	if (!submitPath.empty())
+		return submitDaemonJob(submitPath, frames, pipelined) ? 0 : 1;
 
 	/*
-		Creating Denoisers
+		Init the denoiser backend
 	*/
 
-	constexpr auto forcedOptiXFormat = OPTIX_PIXEL_FORMAT_HALF4;
-	constexpr auto forcedOptiXFormatPixelStride = 8u;
-
-	auto createDenoiser = [&](const OptixDenoiserOptions* options, OptixDenoiserModelKind model = OPTIX_DENOISER_MODEL_KIND_HDR, void* modelData = nullptr, size_t modelDataSizeInBytes = 0ull) -> OptixDenoiser
+	std::vector<const CPooledDenoiserBackend*> pooledBackends;
+	auto createBackend = [backendType, &cpuWorkerThreads, memoryPoolMiB, &pooledBackends](const uint32_t worker) -> std::unique_ptr<IDenoiserBackend>
 	{
-		if (!options)
-			return nullptr;
-
-		OptixDenoiser denoiser = nullptr;
-		OPTIX_CHECK(optixDenoiserCreate(optixContext, options, &denoiser));
-
-		if (!denoiser)
-			return nullptr;
-
-		if(optixDenoiserSetModel(denoiser, model, modelData, modelDataSizeInBytes) != OPTIX_SUCCESS)
-			return nullptr;
-
-		return denoiser;
+		std::unique_ptr<IDenoiserBackend> retval;
+		if (backendType == EBT_CPU && !cpuWorkerThreads.empty())
+			retval = CDenoiserBackendCPU::create(cpuWorkerThreads[std::min<size_t>(worker, cpuWorkerThreads.size() - 1ull)]);
+		else
+			retval = createDenoiserBackend(backendType);
+		if (!retval || !memoryPoolMiB)
+			return retval;
+
+		auto pooled = std::make_unique<CPooledDenoiserBackend>(std::move(retval), size_t(memoryPoolMiB) << 20ull);
+		pooledBackends.push_back(pooled.get());
+		return pooled;
 	};
-
-	constexpr uint32_t kInputBufferCount = 3u;
-	OptixDenoiserOptions opts = { OPTIX_DENOISER_INPUT_RGB_ALBEDO_NORMAL };
-
-	OptixDenoiser denoiser = createDenoiser(&opts);
-	if (!denoiser)
-		status = false;
-	assert(status); // Could not create Optix Color-Albedo-Normal Denoiser!
-
-	/*
-		Compute memory resources for denoiser
-	*/
-
-	size_t denoiserStateBufferSize = 0ull;
-	size_t scratchBufferSize = 0ull;
-	size_t singleInputBufferSize = 0ull;
+	// once the sessions gave their buffers back, so what's left in use is the host tiles' and denoiser caches'
+	auto printMemoryPools = [&pooledBackends]() -> void
 	{
-		OptixDenoiserSizes denoiserMemReqs;
-
-		OPTIX_CHECK(optixDenoiserComputeMemoryResources(denoiser, outputDimensions[0], outputDimensions[1], &denoiserMemReqs));
-
-		denoiserStateBufferSize = denoiserMemReqs.stateSizeInBytes;
-		scratchBufferSize = denoiserMemReqs.withOverlapScratchSizeInBytes;
-		singleInputBufferSize = forcedOptiXFormatPixelStride * resolution[0] * resolution[1];
+		for (size_t i = 0ull; i < pooledBackends.size(); i++)
+		{
+			const std::string name = "Backend " + std::to_string(i) + " " + std::string(pooledBackends[i]->getName());
+			printMemoryPoolStatistics(name + " device memory", pooledBackends[i]->getDevicePool());
+			printMemoryPoolStatistics(name + " host memory", pooledBackends[i]->getHostPool());
+		}
+	};
+	auto backend = createBackend(0u);
+	if (!backend)
+	{
+		std::cerr << "ERROR: Could not create the requested denoiser backend!\n";
+		return 1;
 	}
-	const size_t pixelBufferSize = singleInputBufferSize*kInputBufferCount;
 
-	std::string message = "Total VRAM consumption for Denoiser algorithm: ";
-	std::cout << message + std::to_string(denoiserStateBufferSize + scratchBufferSize + pixelBufferSize);
+	CDenoiserSession::SConfig sessionConfig;
+	sessionConfig.model = replaying ? static_cast<E_MODEL_KIND>(capture.getSettings().model) : EMK_HDR;
+	sessionConfig.inputKind = replaying ? static_cast<E_INPUT_KIND>(capture.getSettings().inputKind) : EIK_RGB_ALBEDO_NORMAL;
+	sessionConfig.format = replaying ? static_cast<E_PIXEL_FORMAT>(capture.getSettings().outputFormat) : EPF_HALF4;
+	sessionConfig.tileWidth = tileWidth;
+	sessionConfig.tileHeight = tileHeight;
+	if ((outOfCore || tileCache || regionOfInterest.width || streamOutput) && !hostTileWidth)
+		hostTileWidth = hostTileHeight = CHostTiledDenoiser::SConfig().tileWidth;
+	const bool hostTiling = hostTileWidth && hostTileHeight;
+	// with host tiling the overlap is between the host tiles, the backend sees every tile as a whole image
+	sessionConfig.overlap = hostTiling ? 0u : overlap;
+	sessionConfig.memoryBudget = size_t(memoryBudgetMiB) << 20ull;
+	sessionConfig.validateHostStatistics = validateIntensity && !hostTiling;
+	// a profile that doesn't exist yet just means nothing got tuned
+	CTuningProfile tuningProfile;
+	if (std::filesystem::exists(tuningProfilePath) && !tuningProfile.load(tuningProfilePath))
+		std::cerr << "ERROR: Ignoring the tuning profile " << tuningProfilePath << "\n";
+	sessionConfig.tuningProfile = &tuningProfile;
+	std::unique_ptr<CProfiler> profiler;
+	if (!statsPath.empty() || !tracePath.empty())
+		profiler = std::make_unique<CProfiler>();
+
+	// a job mixing resolutions, i.e. previews and finals, keeps a denoiser set up for each
+	CDenoiserCache denoiserCache(backend.get(), size_t(denoiserCacheMiB) << 20ull);
+
+	if (autotuneWidth)
+	{
+		CAutotuner autotuner(backend.get(), &denoiserCache, sessionConfig);
+		std::cout << "Autotuning " << backend->getName() << " tilings for " << autotuneWidth << "x" << autotuneHeight << ", fastest of " << autotuneRuns << " run(s) each\n";
 
-	if (pixelBufferSize == 0u)
-		status = false;
+		std::vector<CAutotuner::SResult> results;
+		autotuner.tune(autotuneWidth, autotuneHeight, autotuner.getDefaultCandidates(autotuneWidth, autotuneHeight), autotuneRuns, results, [](const CAutotuner::SResult& result)
+		{
+			const auto& candidate = result.candidate;
+			std::cout << "\t" << (candidate.tileWidth ? std::to_string(candidate.tileWidth) + "x" + std::to_string(candidate.tileHeight) : std::string("planned"))
+				<< " tiles, " << (candidate.overlap ? std::to_string(candidate.overlap) : std::string("backend")) << " overlap: ";
+			if (!result.tileCount)
+				std::cout << "could not be set up\n";
+			else if (!result.valid)
+				std::cout << result.tileCount << " tile(s) of " << result.tileWidth << "x" << result.tileHeight << " don't fit the budget or failed\n";
+			else
+			{
+				std::cout << std::fixed << std::setprecision(2) << result.tileCount << " tile(s) of " << result.tileWidth << "x" << result.tileHeight
+					<< " with " << result.overlap << " px overlap, " << result.milliseconds << " ms, " << result.megapixelsPerSecond << " MPix/s, "
+					<< double(result.memoryConsumption) / double(1ull << 20ull) << " MiB of backend memory\n";
+			}
+		});
 
-	assert(status); // No input files at all!
+		const CAutotuner::SResult* best = CAutotuner::getBest(results);
+		if (!best)
+		{
+			std::cerr << "ERROR: No tiling of " << autotuneWidth << "x" << autotuneHeight << " could be denoised\n";
+			return 1;
+		}
+		tuningProfile.set(autotuner.makeProfileEntry(*best, autotuneWidth, autotuneHeight));
+		if (!tuningProfile.save(tuningProfilePath))
+		{
+			std::cerr << "ERROR: Could not write the tuning profile " << tuningProfilePath << "\n";
+			return 1;
+		}
+		std::cout << std::fixed << std::setprecision(2) << "Fastest: " << best->tileWidth << "x" << best->tileHeight << " tiles with " << best->overlap
+			<< " px overlap at " << best->megapixelsPerSecond << " MPix/s, saved to " << tuningProfilePath << "\n";
+		return 0;
+	}
 
-	CUdeviceptr denoiserState;
-	CU_CHECK(cuMemAlloc(&denoiserState, denoiserStateBufferSize));
+	CDenoiserSession session(backend.get(), sessionConfig, profiler.get(), &denoiserCache);
 
-	CUdeviceptr scratch;
-	CU_CHECK(cuMemAlloc(&scratch, scratchBufferSize));
+	// every additional host tile or daemon worker gets a backend of its own, backends can't be called concurrently
+	std::vector<std::unique_ptr<IDenoiserBackend>> workerBackends;
+	std::vector<std::unique_ptr<CDenoiserCache>> workerCaches;
+	std::vector<std::unique_ptr<CDenoiserSession>> workerSessions;
+	std::vector<CDenoiserSession*> hostTileSessions = { &session };
+	const uint32_t workerCount = hostTiling ? hostTileWorkers : daemon ? daemonWorkers : 1u;
+	for (uint32_t i = 1u; i < workerCount; i++)
+	{
+		auto& workerBackend = workerBackends.emplace_back(createBackend(i));
+		if (!workerBackend)
+		{
+			std::cerr << "ERROR: Could not create the backend for " << (daemon ? "daemon" : "host tile") << " worker " << i << "\n";
+			return 1;
+		}
+		workerCaches.push_back(std::make_unique<CDenoiserCache>(workerBackend.get(), size_t(denoiserCacheMiB) << 20ull));
+		workerSessions.push_back(std::make_unique<CDenoiserSession>(workerBackend.get(), sessionConfig, profiler.get(), workerCaches.back().get()));
+		hostTileSessions.push_back(workerSessions.back().get());
+	}
 
-	CUdeviceptr	imageIntensity;
-	CU_CHECK(cuMemAlloc(&imageIntensity, sizeof(float)));
+	if (daemon)
+	{
+		CDenoiserDaemon::SConfig daemonConfig;
+		daemonConfig.socketPath = daemonPath;
+		daemonConfig.queueCapacity = daemonQueue;
+		daemonConfig.stagingDepth = stagingDepth;
+		daemonConfig.prefetchDistance = prefetchDistance;
+		CDenoiserDaemon denoiserDaemon(hostTileSessions, daemonConfig);
+
+		std::signal(SIGINT, [](int) { CDenoiserDaemon::requestStop(); });
+		std::signal(SIGTERM, [](int) { CDenoiserDaemon::requestStop(); });
+		status = denoiserDaemon.run();
+
+		const auto& daemonStatistics = denoiserDaemon.getStatistics();
+		std::cout << "Daemon served " << daemonStatistics.completed << " job(s) of " << daemonStatistics.frames << " frame(s), "
+			<< daemonStatistics.failed << " failed, " << daemonStatistics.busy << " turned away while busy\n";
+		session.release();
+		for (auto& workerSession : workerSessions)
+			workerSession->release();
+		printMemoryPools();
+		return status ? 0 : 1;
+	}
 
-	CUdeviceptr inputPixelBuffer;
-	CU_CHECK(cuMemAlloc(&inputPixelBuffer, pixelBufferSize));
-	CUdeviceptr inputPixelBuffers[3] =
+	CHostTiledDenoiser::SConfig hostTilingConfig;
+	hostTilingConfig.tileWidth = hostTileWidth;
+	hostTilingConfig.tileHeight = hostTileHeight;
+	hostTilingConfig.overlap = overlap;
+	hostTilingConfig.feather = feather;
+	hostTilingConfig.tileCache = tileCache;
+	hostTilingConfig.regionOfInterest = regionOfInterest;
+	// every worker needs a thread of its own to wait on its backend, whatever the core count
+	CThreadPool hostTilingPool(std::max(std::thread::hardware_concurrency(), hostTileWorkers));
+	CHostTiledDenoiser hostTiledDenoiser(hostTileSessions, hostTilingConfig, &hostTilingPool, profiler.get());
+
+	if (outOfCore)
 	{
-		inputPixelBuffer,
-		inputPixelBuffer+singleInputBufferSize,
-		inputPixelBuffer+singleInputBufferSize*2u
-	};
+		// no whole frame ever gets staged, so the bands go through one frame after another instead of the pipeline
+		CDDSStreamingDenoiser streamingDenoiser(hostTiledDenoiser, profiler.get());
+		for (size_t i = 0ull; i < frames.size(); i++)
+		{
+			CProfiler::setCurrentFrame(uint32_t(i));
+			CDDSStreamingDenoiser::SStatistics streamStatistics;
+			if (!streamingDenoiser.denoise(frames[i], streamStatistics))
+			{
+				status = false;
+				break;
+			}
 
-	CUdeviceptr outputPixelBuffer;
-	CU_CHECK(cuMemAlloc(&outputPixelBuffer, singleInputBufferSize));
+			const double seconds = streamStatistics.milliseconds / 1000.0;
+			std::cout << std::fixed << std::setprecision(2)
+				<< "Frame " << i + 1u << "/" << frames.size() << " [" << streamStatistics.width << "x" << streamStatistics.height << "] streamed in "
+				<< streamStatistics.bandCount << " band(s): " << streamStatistics.milliseconds << " ms, "
+				<< double(streamStatistics.width) * streamStatistics.height / (seconds * 1000000.0) << " MPix/s, read "
+				<< double(streamStatistics.bytesRead) / (seconds * double(1ull << 20ull)) << " MiB/s, written "
+				<< double(streamStatistics.bytesWritten) / (seconds * double(1ull << 20ull)) << " MiB/s, "
+				<< double(streamStatistics.hostMemory) / double(1ull << 20ull) << " MiB of host buffers, peak RSS "
+				<< double(streamStatistics.peakResidentMemory) / double(1ull << 20ull) << " MiB\n";
+		}
+		CProfiler::setCurrentFrame(CProfiler::InvalidFrame);
+	}
+	else
+	{
+		CDDSFrameLoader ddsLoader(frames, profiler.get());
+		ddsLoader.setComputeHDRParameters(hostIntensity || validateIntensity || hostTiling);
+		ddsLoader.setSanitizeMode(sanitizeMode, sanitizeRequested);
+		ddsLoader.setGuidePreprocessing(guidePreprocessing);
+		if (!replaying)
+			ddsLoader.setPrefetchDistance(prefetchDistance);
+		CCaptureFrameLoader captureLoader(capture, profiler.get());
+		IFrameLoader* loader = replaying ? static_cast<IFrameLoader*>(&captureLoader) : &ddsLoader;
+
+		CCaptureWriter captureWriter;
+		CCapturingFrameLoader capturingLoader(*loader, captureWriter, profiler.get());
+		if (!capturePath.empty())
+		{
+			SCaptureSettings settings;
+			settings.model = sessionConfig.model;
+			settings.inputKind = sessionConfig.inputKind;
+			settings.outputFormat = sessionConfig.format;
+			settings.tileWidth = tileWidth;
+			settings.tileHeight = tileHeight;
+			settings.overlap = overlap;
+			settings.memoryBudgetMiB = memoryBudgetMiB;
+			settings.hostTileWidth = hostTileWidth;
+			settings.hostTileHeight = hostTileHeight;
+			settings.feather = feather;
+			if (!captureWriter.open(capturePath, settings))
+			{
+				std::cerr << "ERROR: Could not create the capture " << capturePath << "\n";
+				return 1;
+			}
+			loader = &capturingLoader;
+		}
 
-	/*
-		Fill CUDA buffers with appropriate texture data
-	*/
+		CSessionFrameDenoiser sessionDenoiser(session);
+		CHostTiledFrameDenoiser hostTiledFrameDenoiser(hostTiledDenoiser);
+		IFrameDenoiser* denoiser = hostTiling ? static_cast<IFrameDenoiser*>(&hostTiledFrameDenoiser) : &sessionDenoiser;
+		CDDSFrameSaver saver(frames, profiler.get());
+		saver.setRegionOfInterest(regionOfInterest);
+		if (ldrPreview)
+			saver.setLDROutput(tonemapParameters);
+		if (streamOutput)
+			hostTiledFrameDenoiser.setStreamingSaver(&saver);
+		CFramePipeline pipeline(loader, denoiser, &saver, stagingDepth, backend.get());
+
+		CFramePipeline::SStatistics statistics;
+		status = pipeline.run(pipelined, statistics, [&frames, &profiler](const SFrameStaging& output, const SFrameTimings& frameTimings)
+		{
+			if (profiler)
+				profiler->recordPeakResidentMemory();
+
+			std::cout << std::fixed << std::setprecision(2)
+				<< "Frame " << output.frameIndex + 1u << "/" << frames.size() << " [" << output.width << "x" << output.height << "]:"
+				<< " load " << frameTimings.load << " ms,"
+				<< " setup " << frameTimings.setup << " ms,"
+				<< " denoise " << frameTimings.denoise << " ms,"
+				<< " save " << frameTimings.save << " ms,"
+				<< " total " << frameTimings.total() << " ms\n";
+		});
+
+		if (!capturePath.empty())
+		{
+			const size_t capturedCount = captureWriter.getFrameCount();
+			if (captureWriter.close() && status)
+				std::cout << "Captured " << capturedCount << " frame(s) to " << capturePath << "\n";
+			else
+			{
+				std::cerr << "ERROR: Could not write the capture " << capturePath << "\n";
+				status = false;
+			}
+		}
 
-	{
-		uint8_t offset = {};
-		for (auto& inputKindTexture : inputKindTextures)
+		const auto& timings = statistics.frames;
+		if (status && timings.size() > 1ull)
 		{
-			void* ptrToBegginingOfData = inputKindTexture.data(0, 0, 0);
-			CU_CHECK(cuMemcpyHtoD_v2(inputPixelBuffers[offset++], ptrToBegginingOfData, singleInputBufferSize));
-			inputKindTexture.clear();
+			double setupMilliseconds = 0.0;
+			double steadyStateMilliseconds = 0.0;
+			for (size_t i = 0ull; i < timings.size(); i++)
+			{
+				setupMilliseconds += timings[i].setup;
+				if (i)
+					steadyStateMilliseconds += timings[i].total();
+			}
+			steadyStateMilliseconds /= double(timings.size() - 1ull);
+
+			const double sequenceMilliseconds = statistics.wallMilliseconds;
+			const double amortized = sequenceMilliseconds / double(timings.size());
+			std::cout << std::fixed << std::setprecision(2)
+				<< "Sequence of " << timings.size() << " frames took " << sequenceMilliseconds << " ms" << (pipelined ? " pipelined" : "") << ":"
+				<< " amortized " << amortized << " ms/frame (" << 1000.0 / amortized << " frames/s, "
+				<< double(statistics.pixels) / (sequenceMilliseconds * 1000.0) << " MPix/s),"
+				<< " first frame " << timings.front().total() << " ms, later frames " << steadyStateMilliseconds << " ms on average,"
+				<< " setup paid " << session.getPrepareCount() << " time(s) for " << setupMilliseconds << " ms\n";
+			std::cout << "Stage busy time: load " << statistics.loadMilliseconds << " ms, denoise " << statistics.denoiseMilliseconds
+				<< " ms, save " << statistics.saveMilliseconds << " ms\n";
+
+			const auto& cacheStatistics = denoiserCache.getStatistics();
+			std::cout << "Denoiser cache: " << cacheStatistics.hits << " hit(s), " << cacheStatistics.misses << " miss(es), " << cacheStatistics.evictions
+				<< " eviction(s), " << denoiserCache.getInstanceCount() << " instance(s) holding " << denoiserCache.getMemoryConsumption() << " bytes\n";
+
+			if (const CFilePrefetcher* prefetcher = ddsLoader.getPrefetcher())
+			{
+				const auto prefetchStatistics = prefetcher->getStatistics();
+				std::cout << "Prefetch: " << prefetchStatistics.files << " input file(s) read ahead, " << double(prefetchStatistics.bytes) / double(1ull << 20ull)
+					<< " MiB in " << prefetchStatistics.milliseconds << " ms of background reads, " << prefetchStatistics.skipped << " skipped since the loader got there first\n";
+			}
 		}
 	}
 
-	OPTIX_CHECK(optixDenoiserSetup(denoiser, stream, outputDimensions[0], outputDimensions[1], denoiserState, denoiserStateBufferSize, scratch, scratchBufferSize));
+	if (status && hostTiling)
+		printTileSchedulerStatistics(hostTiledDenoiser);
+	if (status && tileCache && !outOfCore)
+	{
+		const auto& cacheStatistics = hostTiledDenoiser.getTileCacheStatistics();
+		std::cout << std::fixed << std::setprecision(1) << "Tile cache: " << cacheStatistics.hits << " hit(s), " << cacheStatistics.misses << " miss(es), "
+			<< 100.0 * cacheStatistics.getHitRate() << "% hit rate, about " << cacheStatistics.getSavedMilliseconds() << " ms saved\n";
+	}
 
-	OptixImage2D denoiserInputs[3];
-	OptixImage2D denoiserOutput;
+	session.release();
+	for (auto& workerSession : workerSessions)
+		workerSession->release();
+	printMemoryPools();
 
-	for (size_t k = 0; k < hardcodedInputs.size(); k++)
+	if (profiler)
 	{
-		denoiserInputs[k].data = inputPixelBuffers[k];
-		denoiserInputs[k].width = resolution[0];
-		denoiserInputs[k].height = resolution[1];
-		denoiserInputs[k].rowStrideInBytes = resolution[0] * forcedOptiXFormatPixelStride;
-		denoiserInputs[k].format = forcedOptiXFormat;
-		denoiserInputs[k].pixelStrideInBytes = forcedOptiXFormatPixelStride;
+		if (!statsPath.empty() && !profiler->writeJSONLines(statsPath))
+			status = false;
+		if (!tracePath.empty() && !profiler->writeChromeTrace(tracePath))
+			status = false;
 	}
 
-	denoiserOutput.data = outputPixelBuffer;
-	denoiserOutput.width = resolution[0];
-	denoiserOutput.height = resolution[1];
-	denoiserOutput.rowStrideInBytes = resolution[0] * forcedOptiXFormatPixelStride;
-	denoiserOutput.format = forcedOptiXFormat;
-	denoiserOutput.pixelStrideInBytes = forcedOptiXFormatPixelStride;
-
-	// This function needs scratch memory with a size of at least sizeof(int)*(2+inputImage::width*inputImage::height)
-	assert(singleInputBufferSize>=sizeof(int)*(2u+resolution[0]*resolution[1]));
-	OPTIX_CHECK(optixDenoiserComputeIntensity(denoiser, stream, denoiserInputs+0u, imageIntensity, outputPixelBuffer, singleInputBufferSize));
-
-	OptixDenoiserParams optixDenoiserParams;
-	optixDenoiserParams.denoiseAlpha = 0;
-	optixDenoiserParams.blendFactor = 0;
-	optixDenoiserParams.hdrIntensity = imageIntensity;
-	optixDenoiserParams.hdrAverageColor = 0u;
-
-	OPTIX_CHECK(optixUtilDenoiserInvokeTiled(
-		denoiser,
-		stream,
-		&optixDenoiserParams,
-		denoiserState,
-		denoiserStateBufferSize,
-		denoiserInputs,
-		hardcodedInputs.size(),
-		&denoiserOutput,
-		scratch,
-		scratchBufferSize,
-		overlap,
-		tileWidth,
-		tileHeight));
-	CU_CHECK(cuStreamSynchronize(stream));
-
-	CU_CHECK(cuMemcpyDtoH_v2(outputTexture.data(0, 0, 0), outputPixelBuffer, singleInputBufferSize));
-
-	status = gli::save_dds(outputTexture, std::string(DBR_ROOT) + "/outputResult.dds");
-	assert(status); // Could not save output texture!
-}
\ No newline at end of file
+	return status ? 0 : 1;
+}
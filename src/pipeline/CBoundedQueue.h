@@ -0,0 +1,83 @@
+#ifndef __DBR_C_BOUNDED_QUEUE_H_INCLUDED__
+#define __DBR_C_BOUNDED_QUEUE_H_INCLUDED__
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <condition_variable>
+
+namespace dbr
+{
+
+//! Blocking FIFO with a fixed capacity, closing it wakes up everyone waiting and makes `pop` drain what's left
+template<typename T>
+class CBoundedQueue
+{
+	public:
+		explicit CBoundedQueue(size_t capacity) : m_capacity(capacity) {}
+
+		//! Blocks while full, returns false if the queue got closed
+		bool push(T&& item)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_notFull.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+			if (m_closed)
+				return false;
+
+			m_items.push_back(std::move(item));
+			m_notEmpty.notify_one();
+			return true;
+		}
+
+		//! Returns false right away if full or closed, for producers that would rather turn work away than wait
+		bool tryPush(T&& item)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_closed || m_items.size() >= m_capacity)
+				return false;
+
+			m_items.push_back(std::move(item));
+			m_notEmpty.notify_one();
+			return true;
+		}
+
+		//! Blocks while empty, returns nothing once the queue is closed and drained
+		std::optional<T> pop()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_notEmpty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+			if (m_items.empty())
+				return std::nullopt;
+
+			T item = std::move(m_items.front());
+			m_items.pop_front();
+			m_notFull.notify_one();
+			return item;
+		}
+
+		inline size_t size()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_items.size();
+		}
+
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+			m_notEmpty.notify_all();
+			m_notFull.notify_all();
+		}
+
+	private:
+		const size_t m_capacity;
+		std::deque<T> m_items;
+		std::mutex m_mutex;
+		std::condition_variable m_notEmpty;
+		std::condition_variable m_notFull;
+		bool m_closed = false;
+};
+
+}
+
+#endif // __DBR_C_BOUNDED_QUEUE_H_INCLUDED__
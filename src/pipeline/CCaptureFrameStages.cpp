@@ -0,0 +1,48 @@
+#include "pipeline/CCaptureFrameStages.h"
+
+#include <iostream>
+
+using namespace dbr;
+
+bool CCaptureFrameLoader::load(SFrameStaging& outInputs)
+{
+	const size_t frameIndex = outInputs.frameIndex;
+	const SCaptureFrame& frame = m_capture.getFrames()[frameIndex];
+	CProfiler::CScope scope(m_profiler, "capture_load", frame.payloadSize);
+
+	if (frameIndex == 0ull)
+		m_capture.prefetch(frameIndex);
+	if (frameIndex + 1ull < getFrameCount())
+		m_capture.prefetch(frameIndex + 1ull);
+
+	std::array<E_PIXEL_FORMAT, SFrameStaging::MaxLayerCount> formats;
+	for (uint32_t k = 0u; k < frame.layerCount; k++)
+		formats[k] = static_cast<E_PIXEL_FORMAT>(frame.formats[k]);
+	outInputs.borrow(frame.width, frame.height, formats.data(), frame.layerCount, m_capture.getPayload(frameIndex));
+	outInputs.hasHDRParameters = frame.hasHDRParameters;
+	outInputs.hdrParameters = frame.hdrParameters;
+	return true;
+}
+
+bool CCapturingFrameLoader::load(SFrameStaging& outInputs)
+{
+	if (!m_loader.load(outInputs))
+		return false;
+
+	CProfiler::CScope scope(m_profiler, "capture_write", outInputs.getSize());
+	SCaptureFrame frame;
+	frame.width = outInputs.width;
+	frame.height = outInputs.height;
+	frame.layerCount = outInputs.layerCount;
+	for (uint32_t k = 0u; k < outInputs.layerCount; k++)
+		frame.formats[k] = outInputs.formats[k];
+	frame.hasHDRParameters = outInputs.hasHDRParameters;
+	frame.hdrParameters = outInputs.hdrParameters;
+	frame.payloadSize = outInputs.getSize();
+	if (!m_writer.addFrame(frame, outInputs.storage))
+	{
+		std::cerr << "ERROR: Could not append frame " << outInputs.frameIndex + 1u << " to the capture\n";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,47 @@
+#ifndef __DBR_C_CAPTURE_FRAME_STAGES_H_INCLUDED__
+#define __DBR_C_CAPTURE_FRAME_STAGES_H_INCLUDED__
+
+#include "pipeline/IFrameStages.h"
+#include "io/CCaptureFile.h"
+#include "core/CProfiler.h"
+
+namespace dbr
+{
+
+/*
+	Replays the frames of a capture, the input staging borrows each frame's payload straight from the mapping.
+
+	There's nothing to parse, convert or copy on the host, the pages get faulted in from the page cache
+	as the denoiser uploads them. The next frame's payload gets read ahead while the current one is denoised.
+*/
+class CCaptureFrameLoader final : public IFrameLoader
+{
+	public:
+		CCaptureFrameLoader(const CCaptureReader& capture, CProfiler* profiler = nullptr) : m_capture(capture), m_profiler(profiler) {}
+
+		size_t getFrameCount() const override { return m_capture.getFrames().size(); }
+		bool load(SFrameStaging& outInputs) override;
+
+	private:
+		const CCaptureReader& m_capture;
+		CProfiler* const m_profiler;
+};
+
+//! Loads frames with another loader and appends every one of them to a capture on the way through
+class CCapturingFrameLoader final : public IFrameLoader
+{
+	public:
+		CCapturingFrameLoader(IFrameLoader& loader, CCaptureWriter& writer, CProfiler* profiler = nullptr) : m_loader(loader), m_writer(writer), m_profiler(profiler) {}
+
+		size_t getFrameCount() const override { return m_loader.getFrameCount(); }
+		bool load(SFrameStaging& outInputs) override;
+
+	private:
+		IFrameLoader& m_loader;
+		CCaptureWriter& m_writer;
+		CProfiler* const m_profiler;
+};
+
+}
+
+#endif // __DBR_C_CAPTURE_FRAME_STAGES_H_INCLUDED__
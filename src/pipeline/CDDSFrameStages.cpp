@@ -0,0 +1,569 @@
+#include "pipeline/CDDSFrameStages.h"
+
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+
+#include "gli/gli.hpp"
+
+using namespace dbr;
+
+namespace
+{
+
+constexpr std::string_view loadScopeNames[EIK_RGB_ALBEDO_NORMAL] = { "dds_load_color","dds_load_albedo","dds_load_normal" };
+// big enough to amortize the task overhead, small enough to spread a single layer over all threads
+constexpr size_t ConversionChunkPixels = 64ull * 1024ull;
+
+}
+
+CDDSFrameLoader::CDDSFrameLoader(const std::vector<SFrameDesc>& frames, CProfiler* profiler)
+	: m_frames(frames), m_profiler(profiler), m_pool(std::make_unique<CThreadPool>(std::max(std::thread::hardware_concurrency(), uint32_t(EIK_RGB_ALBEDO_NORMAL)) - 1u))
+{
+}
+
+void CDDSFrameLoader::setPrefetchDistance(uint32_t distance)
+{
+	m_prefetchDistance = distance;
+	if (!distance)
+		m_prefetcher.reset();
+	else if (!m_prefetcher)
+		m_prefetcher = std::make_unique<CFilePrefetcher>();
+}
+
+void CDDSFrameLoader::prefetchAhead(size_t frameIndex)
+{
+	if (frameIndex == 0ull)
+		m_prefetchBase = m_prefetchEnd;
+	const uint64_t current = m_prefetchBase + frameIndex;
+	m_prefetcher->setCurrentFrame(current);
+
+	const uint64_t end = m_prefetchBase + std::min<uint64_t>(frameIndex + 1ull + m_prefetchDistance, m_frames.size());
+	for (uint64_t i = std::max<uint64_t>(m_prefetchEnd, current + 1ull); i < end; i++)
+	{
+		const auto& inputs = m_frames[i - m_prefetchBase].inputs;
+		m_prefetcher->prefetch(i, { inputs.begin(),inputs.end() });
+	}
+	m_prefetchEnd = std::max<uint64_t>(end, current + 1ull);
+}
+
+bool CDDSFrameLoader::load(SFrameStaging& outInputs)
+{
+	const SFrameDesc& frame = m_frames[outInputs.frameIndex];
+	// before this frame's reads, so the next ones are already on their way while they block
+	if (m_prefetcher)
+		prefetchAhead(outInputs.frameIndex);
+
+	// the inputs are separate files, so the time spent waiting on storage is bounded by the slowest one instead of the sum
+	std::array<CDDSReader, EIK_RGB_ALBEDO_NORMAL> readers;
+	std::array<bool, EIK_RGB_ALBEDO_NORMAL> opened;
+	m_pool->parallelFor(readers.size(), [&](size_t k)
+	{
+		opened[k] = readers[k].open(frame.inputs[k]);
+	});
+
+	uint32_t resolution[2] = { 0,0 };
+	std::array<STransferFormat, EIK_RGB_ALBEDO_NORMAL> transfers;
+	std::array<E_PIXEL_FORMAT, EIK_RGB_ALBEDO_NORMAL> transferFormats;
+	for (size_t k = 0ull; k < readers.size(); k++)
+	{
+		const std::string& inputFile = frame.inputs[k];
+		if (!opened[k])
+		{
+			std::cerr << "ERROR: Could not load " << inputFile << "\n";
+			return false;
+		}
+
+		const auto& info = readers[k].getInfo();
+		if (!negotiateTransferFormat(info.format, uint32_t(k), transfers[k]))
+		{
+			std::cerr << "ERROR: " << inputFile << " is in a format that can't be converted for the denoiser\n";
+			return false;
+		}
+		transferFormats[k] = transfers[k].format;
+
+		const uint32_t extent[2] = { info.width,info.height };
+		for (auto i=0; i<2; i++)
+		if (resolution[i])
+		{
+			if (resolution[i] != extent[i])
+			{
+				std::cerr << "ERROR: " << inputFile << " has a different resolution than the other inputs\n";
+				return false;
+			}
+		}
+		else
+			resolution[i] = extent[i];
+	}
+
+	if (!outInputs.resize(resolution[0], resolution[1], transferFormats.data(), EIK_RGB_ALBEDO_NORMAL))
+	{
+		std::cerr << "ERROR: Could not allocate staging memory for " << resolution[0] << "x" << resolution[1] << "\n";
+		return false;
+	}
+	reportTransferFormats(readers, transfers);
+
+	// payloads already in the transfer format go straight from the files into the staging buffer, the rest needs converting first
+	for (size_t k = 0ull; k < readers.size(); k++)
+	if (!transfers[k].direct && m_sourceSizes[k] < readers[k].getInfo().imageSize)
+	{
+		m_sourceSizes[k] = readers[k].getInfo().imageSize;
+		m_sourceBuffers[k] = std::make_unique<uint8_t[]>(m_sourceSizes[k]);
+	}
+
+	std::array<bool, EIK_RGB_ALBEDO_NORMAL> loaded;
+	const uint32_t frameIndex = CProfiler::getCurrentFrame();
+	m_pool->parallelFor(readers.size(), [&](size_t k)
+	{
+		CProfiler::setCurrentFrame(frameIndex);
+		const size_t size = readers[k].getInfo().imageSize;
+		CProfiler::CScope scope(m_profiler, loadScopeNames[k], size);
+		if (transfers[k].direct)
+			loaded[k] = readers[k].read(outInputs.getLayer(uint32_t(k)), outInputs.getLayerSize(uint32_t(k)));
+		else
+			loaded[k] = readers[k].read(m_sourceBuffers[k].get(), m_sourceSizes[k]);
+	});
+
+	for (size_t k = 0ull; k < readers.size(); k++)
+	if (!loaded[k])
+	{
+		std::cerr << "ERROR: " << frame.inputs[k] << " is truncated\n";
+		return false;
+	}
+
+	/*
+		Chunks of all the layers that need converting go through the pool together. The non finite values get found, the guides
+		preprocessed and the color statistics gathered from the same chunks right after converting them, while they're still in cache,
+		instead of more passes over the frame. Layers read in their transfer format only get chunked for those, and for sanitizing
+		only when it got asked for.
+	*/
+	struct SChunk
+	{
+		uint32_t layer;
+		size_t begin, end;
+	};
+	std::vector<SChunk> chunks;
+	size_t convertedSize = 0ull;
+	const size_t pixelCount = size_t(resolution[0]) * resolution[1];
+	for (uint32_t k = 0u; k < EIK_RGB_ALBEDO_NORMAL; k++)
+	if (!transfers[k].direct || (m_sanitizeDirectLayers && m_sanitizeMode != ESM_OFF) || (k == 0u && m_computeHDRParameters) || (k == 1u && m_guidePreprocessing.processesAlbedo()) || (k == 2u && m_guidePreprocessing.processesNormals()))
+	{
+		for (size_t begin = 0ull; begin < pixelCount; begin += ConversionChunkPixels)
+			chunks.push_back({ k,begin,std::min(begin + ConversionChunkPixels,pixelCount) });
+		if (!transfers[k].direct)
+			convertedSize += outInputs.getLayerSize(k);
+	}
+
+	// one partial sum per chunk, merged in order so the result doesn't depend on scheduling
+	std::vector<SColorStatistics> chunkStatistics(chunks.size());
+	std::vector<SSanitizeStatistics> chunkSanitizeStatistics(chunks.size());
+	if (!chunks.empty())
+	{
+		CProfiler::CScope scope(m_profiler, "convert_inputs", convertedSize);
+		m_pool->parallelFor(chunks.size(), [&](size_t i)
+		{
+			const SChunk& chunk = chunks[i];
+			if (!transfers[chunk.layer].direct)
+				convertPixels(readers[chunk.layer].getInfo().format, m_sourceBuffers[chunk.layer].get(), transfers[chunk.layer].format, outInputs.getLayer(chunk.layer), chunk.begin, chunk.end);
+			// before the statistics, so clamped values are what they see
+			sanitizePixels(transfers[chunk.layer].format, outInputs.getLayer(chunk.layer), resolution[0], chunk.begin, chunk.end, chunk.layer == 2u, m_sanitizeMode, chunkSanitizeStatistics[i]);
+			// after it, so NaN doesn't spread through the normal transform to the other channels
+			if (chunk.layer == 1u)
+				preprocessAlbedo(transfers[1].format, outInputs.getLayer(1u), m_guidePreprocessing, chunk.begin, chunk.end);
+			else if (chunk.layer == 2u)
+				preprocessNormals(transfers[2].format, outInputs.getLayer(2u), m_guidePreprocessing, chunk.begin, chunk.end);
+			if (chunk.layer == 0u && m_computeHDRParameters)
+				accumulateColorStatistics(transfers[0].format, outInputs.getLayer(0u), chunk.begin, chunk.end, chunkStatistics[i]);
+		});
+	}
+
+	m_sanitizeStatistics = {};
+	for (size_t i = 0ull; i < chunks.size(); i++)
+		m_sanitizeStatistics[chunks[i].layer].merge(chunkSanitizeStatistics[i]);
+	reportSanitizeStatistics(outInputs.frameIndex);
+
+	outInputs.hasHDRParameters = m_computeHDRParameters;
+	if (m_computeHDRParameters)
+	{
+		SColorStatistics statistics;
+		for (size_t i = 0ull; i < chunks.size(); i++)
+		if (chunks[i].layer == 0u)
+			statistics.merge(chunkStatistics[i]);
+		outInputs.hdrParameters = statistics.getHDRParameters();
+	}
+	return true;
+}
+
+void CDDSFrameLoader::reportSanitizeStatistics(size_t frameIndex) const
+{
+	constexpr const char* layerNames[EIK_RGB_ALBEDO_NORMAL] = { "color","albedo","normal" };
+	for (size_t k = 0ull; k < m_sanitizeStatistics.size(); k++)
+	{
+		const SSanitizeStatistics& statistics = m_sanitizeStatistics[k];
+		if (!statistics.getCount())
+			continue;
+
+		std::ostringstream message;
+		message << "Frame " << frameIndex + 1u << " " << layerNames[k] << " input: " << statistics.nans << " NaN, " << statistics.infinities << " Inf and "
+			<< statistics.negatives << " negative value(s) within the " << statistics.maxX - statistics.minX + 1u << "x" << statistics.maxY - statistics.minY + 1u
+			<< " rectangle at " << statistics.minX << "," << statistics.minY << (m_sanitizeMode == ESM_CLAMP ? ", clamped" : ", left as they are") << "\n";
+		std::cout << message.str();
+	}
+}
+
+void CDDSFrameLoader::reportTransferFormats(const std::array<CDDSReader, EIK_RGB_ALBEDO_NORMAL>& readers, const std::array<STransferFormat, EIK_RGB_ALBEDO_NORMAL>& transfers)
+{
+	std::array<gli::format, EIK_RGB_ALBEDO_NORMAL> sourceFormats;
+	for (size_t k = 0ull; k < readers.size(); k++)
+		sourceFormats[k] = readers[k].getInfo().format;
+	if (sourceFormats == m_reportedFormats)
+		return;
+	m_reportedFormats = sourceFormats;
+
+	constexpr const char* layerNames[EIK_RGB_ALBEDO_NORMAL] = { "color","albedo","normal" };
+	std::string message = "Input transfer formats:";
+	for (size_t k = 0ull; k < readers.size(); k++)
+	{
+		message += std::string(k ? ", " : " ") + layerNames[k] + " " + getSourceFormatName(sourceFormats[k]) + " -> " + getPixelFormatName(transfers[k].format);
+		message += transfers[k].direct ? " (direct)" : " (converted)";
+	}
+	std::cout << message + "\n";
+}
+
+bool CSessionFrameDenoiser::prepare(const SFrameStaging& inputs)
+{
+	if (inputs.layerCount < m_session.getConfig().inputKind)
+		return false;
+
+	const uint32_t prepareCount = m_session.getPrepareCount();
+	if (!m_session.prepare(inputs.width, inputs.height, inputs.formats))
+	{
+		std::cerr << "ERROR: Could not set up the " << m_session.getBackend()->getName() << " denoiser for " << inputs.width << "x" << inputs.height << "\n";
+		return false;
+	}
+
+	if (prepareCount != m_session.getPrepareCount())
+	{
+		std::string message = "Total " + std::string(m_session.getBackend()->getName()) + " backend memory consumption for Denoiser algorithm: ";
+		std::cout << message + std::to_string(m_session.getMemoryConsumption()) << "\n";
+
+		const STilePlan& plan = m_session.getTilePlan();
+		std::cout << "Tile plan for " << plan.imageWidth << "x" << plan.imageHeight << ": " << plan.tiles.size() << " tile(s) of "
+			<< plan.tileWidth << "x" << plan.tileHeight << " with " << plan.overlap << " px overlap" << (m_session.isTilingTuned() ? ", from the tuning profile" : "") << "\n";
+
+		// what the same frame would cost with every input forced to the output format, like before negotiation
+		const size_t transferSize = m_session.getInputTransferSize();
+		const size_t uniformSize = m_session.getImageSize() * m_session.getConfig().inputKind;
+		std::cout << "Host to device transfer per frame: " << transferSize << " bytes, " << std::fixed << std::setprecision(1)
+			<< 100.0 * double(transferSize) / double(uniformSize) << "% of the " << uniformSize << " bytes with all inputs as "
+			<< getPixelFormatName(m_session.getConfig().format) << "\n";
+	}
+	return true;
+}
+
+bool CSessionFrameDenoiser::denoise(const SFrameStaging& inputs, SFrameStaging& output)
+{
+	if (!output.resizeLike(inputs, m_session.getConfig().format))
+		return false;
+
+	const void* inputLayers[EIK_RGB_ALBEDO_NORMAL];
+	for (uint32_t k = 0u; k < m_session.getConfig().inputKind; k++)
+		inputLayers[k] = inputs.getLayer(k);
+
+	if (!m_session.denoise(inputLayers, output.getLayer(0u), inputs.hasHDRParameters ? &inputs.hdrParameters : nullptr))
+		return false;
+
+	const auto& comparison = m_session.getIntensityComparison();
+	if (inputs.hasHDRParameters && comparison.valid)
+	{
+		std::cout << "Frame " << inputs.frameIndex + 1u << " intensity: host " << std::defaultfloat << std::setprecision(9) << comparison.host << ", " << m_session.getBackend()->getName()
+			<< " backend " << comparison.backend << ", relative difference " << std::scientific << std::setprecision(2) << comparison.getRelativeDifference() << std::defaultfloat << "\n";
+	}
+	return true;
+}
+
+bool CHostTiledFrameDenoiser::prepare(const SFrameStaging& inputs)
+{
+	if (inputs.layerCount < m_denoiser.getInputKind())
+		return false;
+
+	const uint32_t prepareCount = m_denoiser.getPrepareCount();
+	if (!m_denoiser.prepare(inputs.width, inputs.height, inputs.formats))
+	{
+		std::cerr << "ERROR: Could not set up host tiling for " << inputs.width << "x" << inputs.height << "\n";
+		return false;
+	}
+
+	if (prepareCount != m_denoiser.getPrepareCount())
+	{
+		std::cout << "Host tiling for " << inputs.width << "x" << inputs.height << ": " << m_denoiser.getTiles().size() << " tile(s) padded to "
+			<< m_denoiser.getPaddedTileWidth() << "x" << m_denoiser.getPaddedTileHeight() << ", " << m_denoiser.getOverlap() << " px overlap, "
+			<< m_denoiser.getFeather() << " px feather, " << m_denoiser.getWorkerCount() << " worker(s)\n";
+
+		const auto& region = m_denoiser.getRegionOfInterest();
+		if (region.width != inputs.width || region.height != inputs.height)
+		{
+			std::cout << "Region of interest " << region.width << "x" << region.height << " at " << region.x << "," << region.y << ": "
+				<< m_denoiser.getActiveTiles().size() << " of the tiles get denoised\n";
+		}
+	}
+	return true;
+}
+
+bool CHostTiledFrameDenoiser::denoise(const SFrameStaging& inputs, SFrameStaging& output)
+{
+	if (!output.resizeLike(inputs, m_denoiser.getOutputFormat()))
+		return false;
+
+	/*
+		The noisy color stands in outside the region of interest, in case there's no earlier output to update. Whether there is only
+		comes out when the saver opens it, and converting once per staging buffer would leave an older frame's color in recycled ones.
+		It's one pass over the pixels outside the region, which the tiles inside cost many times over, and the region itself gets skipped.
+	*/
+	const auto& region = m_denoiser.getRegionOfInterest();
+	if (region.width != inputs.width || region.height != inputs.height)
+	{
+		const gli::format colorFormat = getDDSFormat(inputs.formats[0]);
+		auto fill = [&](const size_t begin, const size_t end) -> void
+		{
+			convertPixels(colorFormat, inputs.getLayer(0u), output.formats[0], output.getLayer(0u), begin, end);
+		};
+		const size_t width = inputs.width;
+		const uint32_t endY = region.y + region.height;
+		fill(0ull, region.y * width);
+		for (uint32_t y = region.y; y < endY; y++)
+		{
+			fill(y * width, y * width + region.x);
+			fill(y * width + region.x + region.width, (y + 1ull) * width);
+		}
+		fill(endY * width, inputs.height * width);
+	}
+
+	const void* inputLayers[SFrameStaging::MaxLayerCount];
+	for (uint32_t k = 0u; k < inputs.layerCount; k++)
+		inputLayers[k] = inputs.getLayer(k);
+
+	CHostTiledDenoiser::rows_done_callback_t onRowsDone;
+	if (m_streamingSaver)
+	{
+		if (!m_streamingSaver->beginStreaming(output))
+			return false;
+		onRowsDone = [this, &output](uint32_t beginY, uint32_t endY) -> bool
+		{
+			return m_streamingSaver->streamRows(output, beginY, endY);
+		};
+	}
+
+	if (!m_denoiser.denoise(inputLayers, output.getLayer(0u), inputs.hasHDRParameters ? &inputs.hdrParameters : nullptr, onRowsDone))
+	{
+		if (m_streamingSaver)
+			m_streamingSaver->abortStreaming(output.frameIndex);
+		return false;
+	}
+
+	if (m_denoiser.getConfig().tileCache)
+	{
+		const auto& statistics = m_denoiser.getFrameTileCacheStatistics();
+		// at the average miss of all frames so far, a frame reusing every tile has none of its own
+		const double savedMilliseconds = statistics.hits * m_denoiser.getTileCacheStatistics().getAverageMissMilliseconds();
+		std::cout << "Frame " << inputs.frameIndex + 1u << " tile cache: " << statistics.hits << "/" << statistics.hits + statistics.misses << " tile(s) reused ("
+			<< std::fixed << std::setprecision(1) << 100.0 * statistics.getHitRate() << "%), about " << savedMilliseconds << " ms saved\n";
+	}
+	return true;
+}
+
+bool CDDSFrameSaver::updateRegionOfInterest(const SFrameStaging& output, const std::string& outputFile)
+{
+	const auto& region = m_regionOfInterest;
+	if (!region.width || !region.height || region.x >= output.width || region.y >= output.height)
+		return false;
+
+	CDDSWriter writer;
+	if (!writer.openForUpdate(outputFile, getDDSFormat(output.formats[0]), output.width, output.height))
+		return false;
+
+	const size_t stride = getPixelFormatStride(output.formats[0]);
+	const uint32_t width = std::min(region.width, output.width - region.x);
+	const uint32_t endY = region.y + std::min(region.height, output.height - region.y);
+	CProfiler::CScope scope(m_profiler, "dds_save", size_t(width) * (endY - region.y) * stride);
+	for (uint32_t y = region.y; y < endY; y++)
+	{
+		const size_t offset = (size_t(y) * output.width + region.x) * stride;
+		if (!writer.writeRange(offset, output.getLayer(0u) + offset, width * stride))
+			return false;
+	}
+	return writer.close();
+}
+
+bool CDDSFrameSaver::beginStreaming(const SFrameStaging& output)
+{
+	const std::string& outputFile = m_frames[output.frameIndex].output;
+	auto writer = std::make_unique<CDDSWriter>();
+	if (!writer->open(outputFile, getDDSFormat(output.formats[0]), output.width, output.height))
+	{
+		std::cerr << "ERROR: Could not save " << outputFile << "\n";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_streamsMutex);
+	m_streams[output.frameIndex] = std::move(writer);
+	return true;
+}
+
+bool CDDSFrameSaver::streamRows(const SFrameStaging& output, uint32_t beginY, uint32_t endY)
+{
+	CDDSWriter* writer;
+	{
+		std::lock_guard<std::mutex> lock(m_streamsMutex);
+		auto found = m_streams.find(output.frameIndex);
+		if (found == m_streams.end())
+			return false;
+		writer = found->second.get();
+	}
+
+	const size_t rowSize = output.getLayerSize(0u) / output.height;
+	CProfiler::CScope scope(m_profiler, "stream_write", rowSize * (endY - beginY));
+	if (!writer->writeTile(0u, beginY, output.width, endY - beginY, output.getLayer(0u) + rowSize * beginY, rowSize))
+	{
+		std::cerr << "ERROR: Could not save " << m_frames[output.frameIndex].output << "\n";
+		return false;
+	}
+	return true;
+}
+
+void CDDSFrameSaver::abortStreaming(size_t frameIndex)
+{
+	auto stream = takeStream(frameIndex);
+	if (!stream)
+		return;
+
+	// incomplete, so closing it can only fail
+	stream->close();
+	std::error_code error;
+	std::filesystem::remove(m_frames[frameIndex].output, error);
+}
+
+void CDDSFrameSaver::setLDROutput(const STonemapParameters& parameters)
+{
+	m_ldrOutput = true;
+	m_tonemapParameters = parameters;
+	if (!m_pool)
+		m_pool = std::make_unique<CThreadPool>(std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+}
+
+std::string CDDSFrameSaver::getLDROutputPath(const std::string& outputFile)
+{
+	std::filesystem::path path(outputFile);
+	return (path.parent_path() / (path.stem().string() + "_ldr" + path.extension().string())).string();
+}
+
+bool CDDSFrameSaver::saveLDR(const SFrameStaging& output, const std::string& outputFile, CDDSWriter* hdrWriter)
+{
+	const size_t pixelCount = size_t(output.width) * output.height;
+	const size_t size = pixelCount * 4ull;
+	if (m_ldrCapacity < size)
+	{
+		m_ldrBuffer.reset(new (std::nothrow) uint8_t[size]);
+		m_ldrCapacity = m_ldrBuffer ? size : 0ull;
+	}
+	const std::string ldrFile = getLDROutputPath(outputFile);
+	if (!m_ldrBuffer)
+	{
+		std::cerr << "ERROR: Could not allocate the preview " << ldrFile << "\n";
+		return false;
+	}
+
+	{
+		CProfiler::CScope scope(m_profiler, hdrWriter ? "dds_save_tonemap" : "tonemap", output.getLayerSize(0u));
+		const uint32_t frameIndex = CProfiler::getCurrentFrame();
+		const size_t stride = getPixelFormatStride(output.formats[0]);
+		std::atomic<bool> written = true;
+		m_pool->parallelFor((pixelCount + ConversionChunkPixels - 1ull) / ConversionChunkPixels, [&](size_t i)
+		{
+			CProfiler::setCurrentFrame(frameIndex);
+			const size_t begin = i * ConversionChunkPixels;
+			const size_t end = std::min<size_t>(pixelCount, begin + ConversionChunkPixels);
+			if (hdrWriter && !hdrWriter->writeRange(begin * stride, output.getLayer(0u) + begin * stride, (end - begin) * stride))
+				written = false;
+			tonemapPixels(output.formats[0], output.getLayer(0u), m_tonemapParameters, m_ldrBuffer.get(), begin, end);
+		});
+		if (hdrWriter && (!written || !hdrWriter->close()))
+		{
+			std::cerr << "ERROR: Could not save " << outputFile << "\n";
+			return false;
+		}
+	}
+
+	CProfiler::CScope scope(m_profiler, "ldr_save", size);
+	if (!CDDSWriter::save(ldrFile, gli::FORMAT_RGBA8_SRGB_PACK8, output.width, output.height, m_ldrBuffer.get()))
+	{
+		std::cerr << "ERROR: Could not save " << ldrFile << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool CDDSFrameSaver::save(const SFrameStaging& output)
+{
+	const std::string& outputFile = m_frames[output.frameIndex].output;
+	if (!m_ldrOutput)
+		return saveHDR(output, outputFile);
+
+	// streamed outputs are on disk already, the others get written by the pass that tonemaps them instead of one of their own
+	if (auto stream = takeStream(output.frameIndex))
+		return closeStream(*stream, outputFile) && saveLDR(output, outputFile, nullptr);
+
+	CDDSWriter hdrWriter;
+	if (!hdrWriter.open(outputFile, getDDSFormat(output.formats[0]), output.width, output.height))
+	{
+		std::cerr << "ERROR: Could not save " << outputFile << "\n";
+		return false;
+	}
+	return saveLDR(output, outputFile, &hdrWriter);
+}
+
+std::unique_ptr<CDDSWriter> CDDSFrameSaver::takeStream(size_t frameIndex)
+{
+	std::unique_ptr<CDDSWriter> retval;
+	std::lock_guard<std::mutex> lock(m_streamsMutex);
+	auto found = m_streams.find(frameIndex);
+	if (found != m_streams.end())
+	{
+		retval = std::move(found->second);
+		m_streams.erase(found);
+	}
+	return retval;
+}
+
+bool CDDSFrameSaver::closeStream(CDDSWriter& stream, const std::string& outputFile)
+{
+	CProfiler::CScope scope(m_profiler, "dds_save");
+	const size_t writtenSize = stream.getWrittenSize(), imageSize = stream.getImageSize();
+	if (!stream.close())
+	{
+		std::cerr << "ERROR: Could not save " << outputFile << ", " << writtenSize << " of its " << imageSize << " bytes got streamed\n";
+		return false;
+	}
+	return true;
+}
+
+bool CDDSFrameSaver::saveHDR(const SFrameStaging& output, const std::string& outputFile)
+{
+	if (auto stream = takeStream(output.frameIndex))
+		return closeStream(*stream, outputFile);
+
+	if (updateRegionOfInterest(output, outputFile))
+		return true;
+
+	// straight from the staging buffer, which stays the saver's until it returns
+	CProfiler::CScope scope(m_profiler, "dds_save", output.getLayerSize(0u));
+	if (!CDDSWriter::save(outputFile, getDDSFormat(output.formats[0]), output.width, output.height, output.getLayer(0u)))
+	{
+		std::cerr << "ERROR: Could not save " << outputFile << "\n";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,174 @@
+#ifndef __DBR_C_DDS_FRAME_STAGES_H_INCLUDED__
+#define __DBR_C_DDS_FRAME_STAGES_H_INCLUDED__
+
+#include "pipeline/IFrameStages.h"
+#include "denoiser/CDenoiserSession.h"
+#include "denoiser/CHostTiledDenoiser.h"
+#include "io/FrameList.h"
+#include "core/CProfiler.h"
+#include "core/CThreadPool.h"
+#include "io/CDDSReader.h"
+#include "io/CDDSWriter.h"
+#include "io/CFilePrefetcher.h"
+#include "io/TransferFormat.h"
+#include "io/Tonemap.h"
+#include "io/PixelSanitizer.h"
+#include "io/GuidePreprocessing.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace dbr
+{
+
+/*
+	Loads the color, albedo and normal DDS files of every frame in a frame list, all inputs of a frame concurrently.
+
+	Each input goes to the denoiser in the cheapest format `negotiateTransferFormat` allows for it,
+	so the layers of a loaded frame can differ in format.
+*/
+class CDDSFrameLoader final : public IFrameLoader
+{
+	public:
+		CDDSFrameLoader(const std::vector<SFrameDesc>& frames, CProfiler* profiler = nullptr);
+
+		size_t getFrameCount() const override { return m_frames.size(); }
+		bool load(SFrameStaging& outInputs) override;
+
+		//! Gathers the HDR intensity and average color of the color input while it's in cache from the conversion, on by default
+		inline void setComputeHDRParameters(bool enable) { m_computeHDRParameters = enable; }
+		/*
+			Checks the inputs for NaN, Inf and (but for normals) negative values in the conversion pass, detecting them by default.
+			Inputs read in their transfer format only get a pass of their own for it with `directLayers`, by default they only get
+			checked when the color statistics or guide preprocessing go over them anyway.
+		*/
+		inline void setSanitizeMode(E_SANITIZE_MODE mode, bool directLayers = true)
+		{
+			m_sanitizeMode = mode;
+			m_sanitizeDirectLayers = directLayers;
+		}
+		//! Decodes, transforms and renormalizes the normals and clamps the albedo in the conversion pass, nothing by default
+		inline void setGuidePreprocessing(const SGuidePreprocessing& preprocessing) { m_guidePreprocessing = preprocessing; }
+		//! Per input of the last frame loaded
+		inline const std::array<SSanitizeStatistics, EIK_RGB_ALBEDO_NORMAL>& getSanitizeStatistics() const { return m_sanitizeStatistics; }
+		//! Reads the inputs of up to `distance` frames after the one being loaded into the page cache in the background, 0 turns it off
+		void setPrefetchDistance(uint32_t distance);
+		//! Null while prefetching is off
+		inline const CFilePrefetcher* getPrefetcher() const { return m_prefetcher.get(); }
+
+	private:
+		//! Queues the frames that came into reach, `frameIndex` is the one about to be loaded
+		void prefetchAhead(size_t frameIndex);
+		//! Prints what sanitizing found in every input of the frame, if anything
+		void reportSanitizeStatistics(size_t frameIndex) const;
+		//! Prints the negotiated formats whenever the input formats change
+		void reportTransferFormats(const std::array<CDDSReader, EIK_RGB_ALBEDO_NORMAL>& readers, const std::array<STransferFormat, EIK_RGB_ALBEDO_NORMAL>& transfers);
+
+		const std::vector<SFrameDesc>& m_frames;
+		CProfiler* const m_profiler;
+		//! reads every input on its own thread, then converts the ones that aren't in their transfer format already
+		std::unique_ptr<CThreadPool> m_pool;
+		//! payloads that need converting get read here first, grow only
+		std::array<std::unique_ptr<uint8_t[]>, EIK_RGB_ALBEDO_NORMAL> m_sourceBuffers;
+		std::array<size_t, EIK_RGB_ALBEDO_NORMAL> m_sourceSizes = {};
+		std::array<gli::format, EIK_RGB_ALBEDO_NORMAL> m_reportedFormats = {};
+		bool m_computeHDRParameters = true;
+		E_SANITIZE_MODE m_sanitizeMode = ESM_DETECT;
+		bool m_sanitizeDirectLayers = false;
+		std::array<SSanitizeStatistics, EIK_RGB_ALBEDO_NORMAL> m_sanitizeStatistics = {};
+		SGuidePreprocessing m_guidePreprocessing = {};
+		uint32_t m_prefetchDistance = 0u;
+		std::unique_ptr<CFilePrefetcher> m_prefetcher;
+		//! the prefetcher counts frames across frame lists, which start over at 0 with every daemon job
+		uint64_t m_prefetchBase = 0ull;
+		//! one past the last frame queued or loaded
+		uint64_t m_prefetchEnd = 0ull;
+};
+
+//! Runs frames through a `CDenoiserSession`, which only sets up again if the resolution changes
+class CSessionFrameDenoiser final : public IFrameDenoiser
+{
+	public:
+		explicit CSessionFrameDenoiser(CDenoiserSession& session) : m_session(session) {}
+
+		bool prepare(const SFrameStaging& inputs) override;
+		bool denoise(const SFrameStaging& inputs, SFrameStaging& output) override;
+
+	private:
+		CDenoiserSession& m_session;
+};
+
+class CDDSFrameSaver;
+
+//! Runs frames through a `CHostTiledDenoiser`, tiled on the host instead of by the backend.
+//! With a region of interest the rest of the output is the noisy color, for when there's no earlier output to update.
+class CHostTiledFrameDenoiser final : public IFrameDenoiser
+{
+	public:
+		explicit CHostTiledFrameDenoiser(CHostTiledDenoiser& denoiser) : m_denoiser(denoiser) {}
+
+		bool prepare(const SFrameStaging& inputs) override;
+		bool denoise(const SFrameStaging& inputs, SFrameStaging& output) override;
+
+		//! Output rows go to `saver`'s file as soon as they're composited instead of all at once when the frame gets saved, not with a region of interest
+		inline void setStreamingSaver(CDDSFrameSaver* saver) { m_streamingSaver = saver; }
+
+	private:
+		CHostTiledDenoiser& m_denoiser;
+		CDDSFrameSaver* m_streamingSaver = nullptr;
+};
+
+//! Writes the denoised frames to the output paths of the frame list
+class CDDSFrameSaver final : public IFrameSaver
+{
+	public:
+		CDDSFrameSaver(const std::vector<SFrameDesc>& frames, CProfiler* profiler = nullptr) : m_frames(frames), m_profiler(profiler) {}
+
+		bool save(const SFrameStaging& output) override;
+
+		//! Only this rectangle gets written into outputs that already exist with the same format and extent, the rest of them stays untouched
+		inline void setRegionOfInterest(const CHostTiledDenoiser::STileRegion& region) { m_regionOfInterest = region; }
+
+		/*
+			Opens the file of `output` for the denoiser stage to `streamRows` into while it's still working on the frame,
+			`save` then only has to close it. The saver stage can be saving an earlier frame meanwhile.
+		*/
+		bool beginStreaming(const SFrameStaging& output);
+		//! Writes rows `[beginY,endY)` of `output` to their place in its file, thread safe
+		bool streamRows(const SFrameStaging& output, uint32_t beginY, uint32_t endY);
+		//! Closes the file of a frame that failed after `beginStreaming` and removes it, so no truncated output stays behind
+		void abortStreaming(size_t frameIndex);
+
+		//! Also saves an 8 bit sRGB preview of every frame, tonemapped from the same staging buffer, not with a region of interest
+		void setLDROutput(const STonemapParameters& parameters);
+		//! `<name>_ldr.dds` next to the output
+		static std::string getLDROutputPath(const std::string& outputFile);
+
+	private:
+		//! Returns false if there's no output to update
+		bool updateRegionOfInterest(const SFrameStaging& output, const std::string& outputFile);
+		bool saveHDR(const SFrameStaging& output, const std::string& outputFile);
+		//! Null if `output` isn't being streamed
+		std::unique_ptr<CDDSWriter> takeStream(size_t frameIndex);
+		bool closeStream(CDDSWriter& stream, const std::string& outputFile);
+		//! With `hdrWriter` every chunk also gets written to the HDR output right before it's tonemapped, while it's in cache
+		bool saveLDR(const SFrameStaging& output, const std::string& outputFile, CDDSWriter* hdrWriter);
+
+		const std::vector<SFrameDesc>& m_frames;
+		CProfiler* const m_profiler;
+		CHostTiledDenoiser::STileRegion m_regionOfInterest = {};
+		//! by frame index, of the frames being streamed
+		std::mutex m_streamsMutex;
+		std::unordered_map<size_t, std::unique_ptr<CDDSWriter>> m_streams;
+		bool m_ldrOutput = false;
+		STonemapParameters m_tonemapParameters;
+		//! tonemaps a frame in chunks on every thread, only there with the LDR output
+		std::unique_ptr<CThreadPool> m_pool;
+		//! grow only
+		std::unique_ptr<uint8_t[]> m_ldrBuffer;
+		size_t m_ldrCapacity = 0ull;
+};
+
+}
+
+#endif // __DBR_C_DDS_FRAME_STAGES_H_INCLUDED__
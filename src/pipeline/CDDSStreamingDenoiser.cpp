@@ -0,0 +1,279 @@
+#include "pipeline/CDDSStreamingDenoiser.h"
+#include "io/CDDSWriter.h"
+#include "core/SystemInfo.h"
+
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "gli/gli.hpp"
+
+using namespace dbr;
+
+namespace
+{
+
+// same as the loader, so the color statistics get merged from exactly the same chunks as for a frame loaded whole
+constexpr size_t ConversionChunkPixels = 64ull * 1024ull;
+
+}
+
+CDDSStreamingDenoiser::CDDSStreamingDenoiser(CHostTiledDenoiser& denoiser, CProfiler* profiler)
+	: m_denoiser(denoiser), m_profiler(profiler), m_pool(std::make_unique<CThreadPool>(std::max(std::thread::hardware_concurrency(), uint32_t(EIK_RGB_ALBEDO_NORMAL)) - 1u))
+{
+}
+
+bool CDDSStreamingDenoiser::open(const SFrameDesc& frame, uint32_t& outWidth, uint32_t& outHeight)
+{
+	std::array<bool, EIK_RGB_ALBEDO_NORMAL> opened;
+	m_pool->parallelFor(m_layers.size(), [&](size_t k)
+	{
+		opened[k] = m_layers[k].reader.open(frame.inputs[k]);
+	});
+
+	outWidth = outHeight = 0u;
+	for (size_t k = 0ull; k < m_layers.size(); k++)
+	{
+		const std::string& inputFile = frame.inputs[k];
+		if (!opened[k])
+		{
+			std::cerr << "ERROR: Could not load " << inputFile << "\n";
+			return false;
+		}
+
+		SLayer& layer = m_layers[k];
+		const auto& info = layer.reader.getInfo();
+		if (!negotiateTransferFormat(info.format, uint32_t(k), layer.transfer))
+		{
+			std::cerr << "ERROR: " << inputFile << " is in a format that can't be converted for the denoiser\n";
+			return false;
+		}
+		layer.sourceStride = gli::block_size(info.format);
+
+		if (!k)
+		{
+			outWidth = info.width;
+			outHeight = info.height;
+		}
+		else if (info.width != outWidth || info.height != outHeight)
+		{
+			std::cerr << "ERROR: " << inputFile << " has a different resolution than the other inputs\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CDDSStreamingDenoiser::readPixels(uint32_t firstLayer, uint32_t lastLayer, size_t begin, size_t end, const std::string* paths, SStatistics& statistics)
+{
+	std::array<bool, EIK_RGB_ALBEDO_NORMAL> loaded = {};
+	const uint32_t frameIndex = CProfiler::getCurrentFrame();
+	m_pool->parallelFor(lastLayer - firstLayer + 1u, [&](size_t i)
+	{
+		CProfiler::setCurrentFrame(frameIndex);
+		SLayer& layer = m_layers[firstLayer + i];
+		const size_t size = (end - begin) * layer.sourceStride;
+		CProfiler::CScope scope(m_profiler, "stream_read", size);
+		uint8_t* dst = layer.transfer.direct ? layer.band.get() : layer.source.get();
+		loaded[firstLayer + i] = layer.reader.readRange(begin * layer.sourceStride, dst, size);
+	});
+
+	for (uint32_t k = firstLayer; k <= lastLayer; k++)
+	{
+		if (!loaded[k])
+		{
+			std::cerr << "ERROR: " << paths[k] << " is truncated\n";
+			return false;
+		}
+		statistics.bytesRead += (end - begin) * m_layers[k].sourceStride;
+	}
+
+	struct SChunk
+	{
+		uint32_t layer;
+		size_t begin, end;
+	};
+	std::vector<SChunk> chunks;
+	for (uint32_t k = firstLayer; k <= lastLayer; k++)
+	if (!m_layers[k].transfer.direct)
+	for (size_t chunkBegin = 0ull; chunkBegin < end - begin; chunkBegin += ConversionChunkPixels)
+		chunks.push_back({ k,chunkBegin,std::min(chunkBegin + ConversionChunkPixels,end - begin) });
+
+	if (!chunks.empty())
+	{
+		CProfiler::CScope scope(m_profiler, "stream_convert");
+		m_pool->parallelFor(chunks.size(), [&](size_t i)
+		{
+			const SChunk& chunk = chunks[i];
+			const SLayer& layer = m_layers[chunk.layer];
+			convertPixels(layer.reader.getInfo().format, layer.source.get(), layer.transfer.format, layer.band.get(), chunk.begin, chunk.end);
+		});
+	}
+	return true;
+}
+
+bool CDDSStreamingDenoiser::computeHDRParameters(size_t bandPixels, const SFrameDesc& frame, SHDRParameters& outParameters, SStatistics& statistics)
+{
+	CProfiler::CScope scope(m_profiler, "stream_hdr_parameters");
+	const SLayer& color = m_layers[0];
+	const size_t pixelCount = size_t(color.reader.getInfo().width) * color.reader.getInfo().height;
+	// whole chunks per read, so every chunk is gathered in one go like when loading the frame whole
+	const size_t readPixelCount = std::max(bandPixels / ConversionChunkPixels, size_t(1ull)) * ConversionChunkPixels;
+
+	std::vector<SColorStatistics> chunkStatistics((pixelCount + ConversionChunkPixels - 1ull) / ConversionChunkPixels);
+	for (size_t begin = 0ull; begin < pixelCount; begin += readPixelCount)
+	{
+		const size_t end = std::min(begin + readPixelCount, pixelCount);
+		if (!readPixels(0u, 0u, begin, end, frame.inputs.data(), statistics))
+			return false;
+
+		const size_t firstChunk = begin / ConversionChunkPixels;
+		m_pool->parallelFor((end - begin + ConversionChunkPixels - 1ull) / ConversionChunkPixels, [&](size_t i)
+		{
+			const size_t chunkBegin = i * ConversionChunkPixels;
+			accumulateColorStatistics(color.transfer.format, color.band.get(), chunkBegin, std::min(chunkBegin + ConversionChunkPixels, end - begin), chunkStatistics[firstChunk + i]);
+		});
+	}
+
+	SColorStatistics frameStatistics;
+	for (const auto& chunk : chunkStatistics)
+		frameStatistics.merge(chunk);
+	outParameters = frameStatistics.getHDRParameters();
+	return true;
+}
+
+size_t CDDSStreamingDenoiser::getHostMemoryConsumption() const
+{
+	size_t retval = m_outputCapacity + m_denoiser.getHostMemoryConsumption();
+	for (const SLayer& layer : m_layers)
+		retval += layer.bandCapacity + layer.sourceCapacity;
+	return retval;
+}
+
+bool CDDSStreamingDenoiser::denoise(const SFrameDesc& frame, SStatistics& outStatistics)
+{
+	const auto begin = steady_clock_t::now();
+	outStatistics = {};
+
+	uint32_t width, height;
+	if (!open(frame, width, height))
+		return false;
+
+	CDenoiserSession::input_formats_t formats;
+	for (size_t k = 0ull; k < m_layers.size(); k++)
+		formats[k] = m_layers[k].transfer.format;
+	if (!m_denoiser.prepare(width, height, formats, true))
+	{
+		std::cerr << "ERROR: Could not set up host tiling for " << width << "x" << height << "\n";
+		return false;
+	}
+
+	// the tallest band of input rows and the most output rows a band completes
+	uint32_t bandRows = 0u, outputRows = 0u;
+	for (uint32_t tileRow = 0u, completed = 0u; tileRow < m_denoiser.getTileRowCount(); tileRow++)
+	{
+		uint32_t rowBegin, rowEnd;
+		m_denoiser.getTileRowInputRows(tileRow, rowBegin, rowEnd);
+		bandRows = std::max(bandRows, rowEnd - rowBegin);
+		outputRows = std::max(outputRows, m_denoiser.getCompletedRowEnd(tileRow) - completed);
+		completed = m_denoiser.getCompletedRowEnd(tileRow);
+	}
+	// at least a whole conversion chunk, so the HDR parameters pass can reuse the band buffers
+	const size_t bandPixels = std::min(std::max(size_t(bandRows) * width, ConversionChunkPixels), size_t(width) * height);
+
+	bool allocated = true;
+	auto grow = [&allocated](std::unique_ptr<uint8_t[]>& buffer, size_t& capacity, const size_t size) -> void
+	{
+		if (capacity >= size)
+			return;
+		buffer.reset(new (std::nothrow) uint8_t[size]);
+		capacity = buffer ? size : 0ull;
+		allocated = allocated && buffer;
+	};
+	for (SLayer& layer : m_layers)
+	{
+		grow(layer.band, layer.bandCapacity, bandPixels * getPixelFormatStride(layer.transfer.format));
+		if (!layer.transfer.direct)
+			grow(layer.source, layer.sourceCapacity, bandPixels * layer.sourceStride);
+	}
+	const E_PIXEL_FORMAT outputFormat = m_denoiser.getOutputFormat();
+	const size_t outputRowSize = size_t(getPixelFormatStride(outputFormat)) * width;
+	grow(m_outputBand, m_outputCapacity, outputRowSize * outputRows);
+	if (!allocated)
+	{
+		std::cerr << "ERROR: Could not allocate the bands for streaming " << width << "x" << height << "\n";
+		return false;
+	}
+
+	SHDRParameters hdrParameters;
+	if (!computeHDRParameters(bandPixels, frame, hdrParameters, outStatistics))
+		return false;
+
+	CDDSWriter writer;
+	if (!writer.open(frame.output, getDDSFormat(outputFormat), width, height))
+	{
+		std::cerr << "ERROR: Could not save " << frame.output << "\n";
+		return false;
+	}
+	// a partial file's header would still claim the whole image
+	auto abort = [&writer,&frame]() -> bool
+	{
+		writer.close();
+		std::error_code error;
+		std::filesystem::remove(frame.output, error);
+		return false;
+	};
+
+	const void* inputs[EIK_RGB_ALBEDO_NORMAL];
+	for (size_t k = 0ull; k < m_layers.size(); k++)
+		inputs[k] = m_layers[k].band.get();
+
+	// consecutive bands share the overlap rows, reading those twice costs less than keeping them around
+	uint32_t completed = 0u;
+	for (uint32_t tileRow = 0u; tileRow < m_denoiser.getTileRowCount(); tileRow++)
+	{
+		uint32_t rowBegin, rowEnd;
+		m_denoiser.getTileRowInputRows(tileRow, rowBegin, rowEnd);
+		if (!readPixels(0u, EIK_RGB_ALBEDO_NORMAL - 1u, size_t(rowBegin) * width, size_t(rowEnd) * width, frame.inputs.data(), outStatistics))
+			return abort();
+
+		if (!m_denoiser.denoiseTileRow(tileRow, inputs, rowBegin, hdrParameters))
+		{
+			std::cerr << "ERROR: Could not denoise tile row " << tileRow << " of " << frame.output << "\n";
+			return abort();
+		}
+
+		const uint32_t completedEnd = m_denoiser.getCompletedRowEnd(tileRow);
+		m_denoiser.compositeRows(completed, completedEnd, m_outputBand.get(), completed);
+		const size_t size = outputRowSize * (completedEnd - completed);
+		{
+			CProfiler::CScope scope(m_profiler, "stream_write", size);
+			if (!writer.write(m_outputBand.get(), size))
+			{
+				std::cerr << "ERROR: Could not save " << frame.output << "\n";
+				return abort();
+			}
+		}
+		outStatistics.bytesWritten += size;
+		completed = completedEnd;
+
+		outStatistics.peakResidentMemory = getPeakResidentMemory();
+		if (m_profiler)
+			m_profiler->recordPeakResidentMemory();
+	}
+
+	for (SLayer& layer : m_layers)
+		layer.reader.close();
+	if (!writer.close())
+	{
+		std::cerr << "ERROR: Could not save " << frame.output << "\n";
+		return abort();
+	}
+
+	outStatistics.width = width;
+	outStatistics.height = height;
+	outStatistics.bandCount = m_denoiser.getTileRowCount();
+	outStatistics.hostMemory = getHostMemoryConsumption();
+	outStatistics.milliseconds = getMilliseconds(begin, steady_clock_t::now());
+	return true;
+}
@@ -0,0 +1,78 @@
+#ifndef __DBR_C_DDS_STREAMING_DENOISER_H_INCLUDED__
+#define __DBR_C_DDS_STREAMING_DENOISER_H_INCLUDED__
+
+#include "denoiser/CHostTiledDenoiser.h"
+#include "io/FrameList.h"
+#include "io/CDDSReader.h"
+#include "io/TransferFormat.h"
+#include "core/CProfiler.h"
+#include "core/CThreadPool.h"
+
+#include <array>
+#include <memory>
+
+namespace dbr
+{
+
+/*
+	Denoises frames straight from the input files into the output file one band of tile rows at a time,
+	for stills that don't fit in host memory, i.e. 16K and up.
+
+	Host memory holds one band of input rows (a tile row plus the overlap above and below), the denoised tiles
+	of the band before it for blending across the seam and the output rows the band completes, so peak memory
+	scales with the width of the frame instead of its area. The HDR parameters have to come from the whole frame,
+	so the color input gets streamed through once before the bands.
+*/
+class CDDSStreamingDenoiser
+{
+	public:
+		struct SStatistics
+		{
+			uint32_t width = 0u;
+			uint32_t height = 0u;
+			uint32_t bandCount = 0u;
+			uint64_t bytesRead = 0ull;
+			uint64_t bytesWritten = 0ull;
+			//! band buffers here and in the tiled denoiser
+			size_t hostMemory = 0ull;
+			double milliseconds = 0.0;
+			//! of the whole process, sampled after every band
+			size_t peakResidentMemory = 0ull;
+		};
+
+		CDDSStreamingDenoiser(CHostTiledDenoiser& denoiser, CProfiler* profiler = nullptr);
+
+		bool denoise(const SFrameDesc& frame, SStatistics& outStatistics);
+
+	private:
+		//! Band buffers of one input, grow only
+		struct SLayer
+		{
+			CDDSReader reader;
+			STransferFormat transfer;
+			size_t sourceStride = 0ull;
+			//! rows in the transfer format, what the tiles get extracted from
+			std::unique_ptr<uint8_t[]> band;
+			size_t bandCapacity = 0ull;
+			//! rows as read from the file, only for inputs that need converting
+			std::unique_ptr<uint8_t[]> source;
+			size_t sourceCapacity = 0ull;
+		};
+
+		bool open(const SFrameDesc& frame, uint32_t& outWidth, uint32_t& outHeight);
+		//! Reads and converts the pixels `[begin,end)` of every input in `[firstLayer,lastLayer]` into the band buffers
+		bool readPixels(uint32_t firstLayer, uint32_t lastLayer, size_t begin, size_t end, const std::string* paths, SStatistics& statistics);
+		bool computeHDRParameters(size_t bandPixels, const SFrameDesc& frame, SHDRParameters& outParameters, SStatistics& statistics);
+		size_t getHostMemoryConsumption() const;
+
+		CHostTiledDenoiser& m_denoiser;
+		CProfiler* const m_profiler;
+		std::unique_ptr<CThreadPool> m_pool;
+		std::array<SLayer, EIK_RGB_ALBEDO_NORMAL> m_layers;
+		std::unique_ptr<uint8_t[]> m_outputBand;
+		size_t m_outputCapacity = 0ull;
+};
+
+}
+
+#endif // __DBR_C_DDS_STREAMING_DENOISER_H_INCLUDED__
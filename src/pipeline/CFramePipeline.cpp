@@ -0,0 +1,215 @@
+#include "pipeline/CFramePipeline.h"
+#include "pipeline/CBoundedQueue.h"
+#include "core/Clock.h"
+#include "core/CProfiler.h"
+
+#include <atomic>
+#include <thread>
+#include <cassert>
+
+using namespace dbr;
+
+CFramePipeline::CFramePipeline(IFrameLoader* loader, IFrameDenoiser* denoiser, IFrameSaver* saver, uint32_t stagingDepth, IDenoiserBackend* stagingAllocator)
+	: m_loader(loader), m_denoiser(denoiser), m_saver(saver), m_stagingDepth(stagingDepth ? stagingDepth : 1u), m_stagingAllocator(stagingAllocator)
+{
+	assert(m_loader && m_denoiser && m_saver);
+}
+
+void CFramePipeline::resizeStaging(uint32_t count)
+{
+	for (auto* staging : { &m_inputStaging,&m_outputStaging })
+	{
+		staging->resize(count);
+		for (auto& buffer : *staging)
+			buffer.allocator = m_stagingAllocator;
+	}
+}
+
+bool CFramePipeline::run(bool overlapped, SStatistics& outStatistics, const frame_done_callback_t& onFrameDone)
+{
+	const size_t frameCount = m_loader->getFrameCount();
+	outStatistics = {};
+	outStatistics.frames.resize(frameCount);
+
+	const auto begin = steady_clock_t::now();
+	const bool status = overlapped ? runOverlapped(outStatistics, onFrameDone) : runSerial(outStatistics, onFrameDone);
+	CProfiler::setCurrentFrame(CProfiler::InvalidFrame);
+	outStatistics.wallMilliseconds = getMilliseconds(begin, steady_clock_t::now());
+
+	for (const auto& frame : outStatistics.frames)
+	{
+		outStatistics.loadMilliseconds += frame.load;
+		outStatistics.denoiseMilliseconds += frame.setup + frame.denoise;
+		outStatistics.saveMilliseconds += frame.save;
+	}
+	return status;
+}
+
+bool CFramePipeline::runSerial(SStatistics& outStatistics, const frame_done_callback_t& onFrameDone)
+{
+	resizeStaging(1u);
+	SFrameStaging& inputs = m_inputStaging.front();
+	SFrameStaging& output = m_outputStaging.front();
+
+	for (size_t frameIx = 0ull; frameIx < outStatistics.frames.size(); frameIx++)
+	{
+		SFrameTimings& timings = outStatistics.frames[frameIx];
+		inputs.frameIndex = output.frameIndex = frameIx;
+		CProfiler::setCurrentFrame(uint32_t(frameIx));
+
+		auto stageBegin = steady_clock_t::now();
+		if (!m_loader->load(inputs))
+			return false;
+		auto stageEnd = steady_clock_t::now();
+		timings.load = getMilliseconds(stageBegin, stageEnd);
+
+		stageBegin = stageEnd;
+		if (!m_denoiser->prepare(inputs))
+			return false;
+		stageEnd = steady_clock_t::now();
+		timings.setup = getMilliseconds(stageBegin, stageEnd);
+
+		stageBegin = stageEnd;
+		if (!m_denoiser->denoise(inputs, output))
+			return false;
+		stageEnd = steady_clock_t::now();
+		timings.denoise = getMilliseconds(stageBegin, stageEnd);
+
+		stageBegin = stageEnd;
+		if (!m_saver->save(output))
+			return false;
+		stageEnd = steady_clock_t::now();
+		timings.save = getMilliseconds(stageBegin, stageEnd);
+
+		outStatistics.pixels += uint64_t(output.width) * output.height;
+		if (onFrameDone)
+			onFrameDone(output, timings);
+	}
+	return true;
+}
+
+bool CFramePipeline::runOverlapped(SStatistics& outStatistics, const frame_done_callback_t& onFrameDone)
+{
+	const size_t frameCount = outStatistics.frames.size();
+
+	resizeStaging(m_stagingDepth);
+
+	// staging buffers travel between the stages as indices
+	CBoundedQueue<uint32_t> freeInputs(m_stagingDepth), loadedInputs(m_stagingDepth);
+	CBoundedQueue<uint32_t> freeOutputs(m_stagingDepth), denoisedOutputs(m_stagingDepth);
+	for (uint32_t i = 0u; i < m_stagingDepth; i++)
+	{
+		freeInputs.push(uint32_t(i));
+		freeOutputs.push(uint32_t(i));
+	}
+
+	std::atomic<bool> failed = false;
+	auto abort = [&]()
+	{
+		failed = true;
+		freeInputs.close();
+		loadedInputs.close();
+		freeOutputs.close();
+		denoisedOutputs.close();
+	};
+
+	std::thread loaderThread([&]()
+	{
+		for (size_t frameIx = 0ull; frameIx < frameCount; frameIx++)
+		{
+			const auto slot = freeInputs.pop();
+			if (!slot.has_value())
+				return;
+
+			SFrameStaging& inputs = m_inputStaging[*slot];
+			inputs.frameIndex = frameIx;
+			CProfiler::setCurrentFrame(uint32_t(frameIx));
+
+			const auto stageBegin = steady_clock_t::now();
+			if (!m_loader->load(inputs))
+			{
+				abort();
+				return;
+			}
+			outStatistics.frames[frameIx].load = getMilliseconds(stageBegin, steady_clock_t::now());
+
+			if (!loadedInputs.push(uint32_t(*slot)))
+				return;
+		}
+		loadedInputs.close();
+	});
+
+	uint64_t pixels = 0ull;
+	std::thread saverThread([&]()
+	{
+		for (size_t frameIx = 0ull; frameIx < frameCount; frameIx++)
+		{
+			const auto slot = denoisedOutputs.pop();
+			if (!slot.has_value())
+				return;
+
+			SFrameStaging& output = m_outputStaging[*slot];
+			SFrameTimings& timings = outStatistics.frames[output.frameIndex];
+			CProfiler::setCurrentFrame(uint32_t(output.frameIndex));
+
+			const auto stageBegin = steady_clock_t::now();
+			if (!m_saver->save(output))
+			{
+				abort();
+				return;
+			}
+			timings.save = getMilliseconds(stageBegin, steady_clock_t::now());
+
+			pixels += uint64_t(output.width) * output.height;
+			if (onFrameDone)
+				onFrameDone(output, timings);
+
+			if (!freeOutputs.push(uint32_t(*slot)))
+				return;
+		}
+	});
+
+	// denoising stays on this thread, some backends have thread affine state
+	for (size_t frameIx = 0ull; frameIx < frameCount && !failed; frameIx++)
+	{
+		const auto inputSlot = loadedInputs.pop();
+		if (!inputSlot.has_value())
+			break;
+		const auto outputSlot = freeOutputs.pop();
+		if (!outputSlot.has_value())
+			break;
+
+		const SFrameStaging& inputs = m_inputStaging[*inputSlot];
+		SFrameStaging& output = m_outputStaging[*outputSlot];
+		output.frameIndex = inputs.frameIndex;
+		SFrameTimings& timings = outStatistics.frames[inputs.frameIndex];
+		CProfiler::setCurrentFrame(uint32_t(inputs.frameIndex));
+
+		auto stageBegin = steady_clock_t::now();
+		if (!m_denoiser->prepare(inputs))
+		{
+			abort();
+			break;
+		}
+		auto stageEnd = steady_clock_t::now();
+		timings.setup = getMilliseconds(stageBegin, stageEnd);
+
+		stageBegin = stageEnd;
+		if (!m_denoiser->denoise(inputs, output))
+		{
+			abort();
+			break;
+		}
+		timings.denoise = getMilliseconds(stageBegin, steady_clock_t::now());
+
+		if (!freeInputs.push(uint32_t(*inputSlot)) || !denoisedOutputs.push(uint32_t(*outputSlot)))
+			break;
+	}
+	denoisedOutputs.close();
+
+	loaderThread.join();
+	saverThread.join();
+
+	outStatistics.pixels = pixels;
+	return !failed;
+}
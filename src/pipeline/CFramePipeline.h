@@ -0,0 +1,59 @@
+#ifndef __DBR_C_FRAME_PIPELINE_H_INCLUDED__
+#define __DBR_C_FRAME_PIPELINE_H_INCLUDED__
+
+#include "pipeline/IFrameStages.h"
+
+#include <functional>
+
+namespace dbr
+{
+
+/*
+	Streams frames through load -> denoise -> save.
+
+	Overlapped, the loader and saver get a thread each and the denoiser runs on the calling thread, so frame N+1 loads
+	while frame N is being denoised and frame N-1 is saved. The stages hand each other host staging buffers through
+	bounded queues, `stagingDepth` input and `stagingDepth` output buffers (double buffering by default) cap how
+	far ahead the loader can run and how much memory is in flight.
+
+	Serial, everything runs on the calling thread one frame at a time, which is the baseline to compare against.
+*/
+class CFramePipeline
+{
+	public:
+		struct SStatistics
+		{
+			std::vector<SFrameTimings> frames;
+			double wallMilliseconds = 0.0;
+			uint64_t pixels = 0ull;
+			//! busy time of every stage, in a perfectly overlapped run the largest one equals the wall time
+			double loadMilliseconds = 0.0;
+			double denoiseMilliseconds = 0.0;
+			double saveMilliseconds = 0.0;
+		};
+		//! Called from the saving thread in frame order as soon as a frame is done
+		using frame_done_callback_t = std::function<void(const SFrameStaging&, const SFrameTimings&)>;
+
+		//! With a `stagingAllocator` the staging buffers come from its `allocateHost`, it has to outlive the pipeline
+		CFramePipeline(IFrameLoader* loader, IFrameDenoiser* denoiser, IFrameSaver* saver, uint32_t stagingDepth = 2u, IDenoiserBackend* stagingAllocator = nullptr);
+
+		bool run(bool overlapped, SStatistics& outStatistics, const frame_done_callback_t& onFrameDone = {});
+
+	private:
+		bool runSerial(SStatistics& outStatistics, const frame_done_callback_t& onFrameDone);
+		bool runOverlapped(SStatistics& outStatistics, const frame_done_callback_t& onFrameDone);
+		void resizeStaging(uint32_t count);
+
+		IFrameLoader* const m_loader;
+		IFrameDenoiser* const m_denoiser;
+		IFrameSaver* const m_saver;
+		const uint32_t m_stagingDepth;
+		IDenoiserBackend* const m_stagingAllocator;
+
+		std::vector<SFrameStaging> m_inputStaging;
+		std::vector<SFrameStaging> m_outputStaging;
+};
+
+}
+
+#endif // __DBR_C_FRAME_PIPELINE_H_INCLUDED__
@@ -0,0 +1,189 @@
+#ifndef __DBR_I_FRAME_STAGES_H_INCLUDED__
+#define __DBR_I_FRAME_STAGES_H_INCLUDED__
+
+#include "denoiser/IDenoiserBackend.h"
+#include "denoiser/ColorStatistics.h"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <utility>
+
+namespace dbr
+{
+
+struct SFrameTimings
+{
+	double load = 0.0;
+	double setup = 0.0;
+	double denoise = 0.0;
+	double save = 0.0;
+
+	inline double total() const { return load + setup + denoise + save; }
+};
+
+/*
+	Host memory holding the tightly packed layers of one frame, reused for frame after frame so it only ever grows.
+
+	With an `allocator` set the memory comes from `IDenoiserBackend::allocateHost`, so loaders can decode
+	straight into memory the backend uploads from fastest, otherwise from plain `operator new`.
+	Loaders of inputs already in their final layout somewhere else, i.e. a mapped capture, can `borrow` that instead.
+*/
+struct SFrameStaging
+{
+	SFrameStaging() = default;
+	SFrameStaging(const SFrameStaging&) = delete;
+	SFrameStaging(SFrameStaging&& other) noexcept { operator=(std::move(other)); }
+	~SFrameStaging() { deallocate(); }
+
+	SFrameStaging& operator=(const SFrameStaging&) = delete;
+	inline SFrameStaging& operator=(SFrameStaging&& other) noexcept
+	{
+		std::swap(frameIndex, other.frameIndex);
+		std::swap(width, other.width);
+		std::swap(height, other.height);
+		std::swap(formats, other.formats);
+		std::swap(layerCount, other.layerCount);
+		std::swap(hasHDRParameters, other.hasHDRParameters);
+		std::swap(hdrParameters, other.hdrParameters);
+		std::swap(allocator, other.allocator);
+		std::swap(storage, other.storage);
+		std::swap(capacity, other.capacity);
+		std::swap(borrowed, other.borrowed);
+		return *this;
+	}
+
+	static constexpr uint32_t MaxLayerCount = EIK_RGB_ALBEDO_NORMAL;
+
+	size_t frameIndex = 0ull;
+	uint32_t width = 0u;
+	uint32_t height = 0u;
+	//! every layer can have its own format, i.e. a HALF4 color next to HALF3 guides
+	std::array<E_PIXEL_FORMAT, MaxLayerCount> formats = { EPF_HALF4,EPF_HALF4,EPF_HALF4 };
+	uint32_t layerCount = 0u;
+	//! set by loaders that gather the color statistics on the way in, saves the denoiser its own intensity pass
+	bool hasHDRParameters = false;
+	SHDRParameters hdrParameters;
+	//! only change while nothing is allocated
+	IDenoiserBackend* allocator = nullptr;
+
+	inline size_t getLayerSize(uint32_t layer) const { return size_t(getPixelFormatStride(formats[layer])) * width * height; }
+	inline size_t getLayerOffset(uint32_t layer) const
+	{
+		size_t offset = 0ull;
+		for (uint32_t k = 0u; k < layer; k++)
+			offset += getLayerSize(k);
+		return offset;
+	}
+	inline size_t getSize() const { return getLayerOffset(layerCount); }
+	inline uint8_t* getLayer(uint32_t layer) { return storage + getLayerOffset(layer); }
+	inline const uint8_t* getLayer(uint32_t layer) const { return storage + getLayerOffset(layer); }
+
+	//! Contents are undefined afterwards, every stage overwrites the whole frame anyway. Returns false if out of memory.
+	inline bool resize(uint32_t _width, uint32_t _height, const E_PIXEL_FORMAT* _formats, uint32_t _layerCount)
+	{
+		assert(_layerCount <= MaxLayerCount);
+		width = _width;
+		height = _height;
+		layerCount = _layerCount;
+		std::copy_n(_formats, layerCount, formats.begin());
+
+		const size_t size = getSize();
+		if (borrowed)
+			deallocate();
+		if (capacity >= size)
+			return true;
+
+		deallocate();
+		storage = static_cast<uint8_t*>(allocator ? allocator->allocateHost(size) : ::operator new(size, std::nothrow));
+		capacity = storage ? size : 0ull;
+		return storage;
+	}
+
+	inline bool resize(uint32_t _width, uint32_t _height, E_PIXEL_FORMAT _format, uint32_t _layerCount)
+	{
+		const std::array<E_PIXEL_FORMAT, MaxLayerCount> uniform = { _format,_format,_format };
+		return resize(_width, _height, uniform.data(), _layerCount);
+	}
+
+	//! Takes only the extent of `other`, i.e. an output allocated like its input, nothing gets copied or cleared
+	inline bool resizeLike(const SFrameStaging& other, E_PIXEL_FORMAT _format, uint32_t _layerCount = 1u)
+	{
+		return resize(other.width, other.height, _format, _layerCount);
+	}
+
+	/*
+		Points the layers at `data` instead of owned memory until the next `resize` or `borrow`, `data` has to outlive that.
+		Only for inputs, which no stage writes to, so `data` may as well be read only.
+	*/
+	inline void borrow(uint32_t _width, uint32_t _height, const E_PIXEL_FORMAT* _formats, uint32_t _layerCount, const uint8_t* data)
+	{
+		assert(_layerCount <= MaxLayerCount);
+		deallocate();
+		width = _width;
+		height = _height;
+		layerCount = _layerCount;
+		std::copy_n(_formats, layerCount, formats.begin());
+		storage = const_cast<uint8_t*>(data);
+		capacity = getSize();
+		borrowed = true;
+	}
+
+	uint8_t* storage = nullptr;
+	size_t capacity = 0ull;
+	bool borrowed = false;
+
+	private:
+		inline void deallocate()
+		{
+			if (!storage)
+				return;
+			if (borrowed)
+				borrowed = false;
+			else if (allocator)
+				allocator->deallocateHost(storage);
+			else
+				::operator delete(storage);
+			storage = nullptr;
+			capacity = 0ull;
+		}
+};
+
+/*
+	The three stages of `CFramePipeline`, each one only ever gets called from a single thread
+	but the three stages run on different threads at the same time.
+*/
+class IFrameLoader
+{
+	public:
+		virtual ~IFrameLoader() = default;
+
+		virtual size_t getFrameCount() const = 0;
+		//! Fills all the input layers, `outInputs.frameIndex` is already set
+		virtual bool load(SFrameStaging& outInputs) = 0;
+};
+
+class IFrameDenoiser
+{
+	public:
+		virtual ~IFrameDenoiser() = default;
+
+		//! Called before every `denoise`, should be close to free when nothing changed since the last frame
+		virtual bool prepare(const SFrameStaging& inputs) = 0;
+		//! Has to size `output` itself, its `frameIndex` is already set
+		virtual bool denoise(const SFrameStaging& inputs, SFrameStaging& output) = 0;
+};
+
+class IFrameSaver
+{
+	public:
+		virtual ~IFrameSaver() = default;
+
+		virtual bool save(const SFrameStaging& output) = 0;
+};
+
+}
+
+#endif // __DBR_I_FRAME_STAGES_H_INCLUDED__
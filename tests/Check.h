@@ -0,0 +1,31 @@
+#ifndef __DBR_TESTS_CHECK_H_INCLUDED__
+#define __DBR_TESTS_CHECK_H_INCLUDED__
+
+#include <iostream>
+
+namespace dbr::tests
+{
+
+//! Failed checks of the suite being run, a suite passes while it's 0
+inline uint32_t& getFailureCount()
+{
+	static uint32_t failures = 0u;
+	return failures;
+}
+
+inline bool check(const bool condition, const char* expression, const char* file, const int line)
+{
+	if (!condition)
+	{
+		std::cerr << "ERROR: " << file << ":" << line << ": check failed: " << expression << "\n";
+		getFailureCount()++;
+	}
+	return condition;
+}
+
+}
+
+//! Keeps going after a failure so one run reports all of them, returns the condition for checks later ones depend on
+#define DBR_CHECK(condition) dbr::tests::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#endif // __DBR_TESTS_CHECK_H_INCLUDED__
@@ -0,0 +1,255 @@
+#include "Check.h"
+#include "pipeline/CFramePipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace dbr;
+
+namespace
+{
+
+constexpr uint32_t StubWidth = 4u, StubHeight = 2u;
+constexpr size_t NoFailure = ~size_t(0u);
+
+enum E_STAGE : uint32_t
+{
+	ES_LOAD = 0u,
+	ES_PREPARE,
+	ES_DENOISE,
+	ES_SAVE,
+	ES_COUNT
+};
+
+//! What the fake stages saw, shared between them since they run on different threads
+struct SRecord
+{
+	explicit SRecord(size_t _frameCount, std::chrono::milliseconds _stageTime = {}) : frameCount(_frameCount), stageTime(_stageTime) {}
+
+	const size_t frameCount;
+	const std::chrono::milliseconds stageTime;
+	size_t failingFrame[ES_COUNT] = { NoFailure,NoFailure,NoFailure,NoFailure };
+
+	std::atomic<uint32_t> started[ES_COUNT] = {};
+	std::atomic<uint32_t> finished[ES_COUNT] = {};
+	std::atomic<bool> busy[ES_COUNT] = {};
+	std::atomic<bool> overlapped = false;
+	//! frames loaded but not yet denoised and frames denoised but not yet saved, at most
+	std::atomic<uint32_t> maxInputsInFlight = 0u, maxOutputsInFlight = 0u;
+
+	std::mutex mutex;
+	std::vector<size_t> saved;
+	std::set<const uint8_t*> inputStorage;
+
+	//! Returns false if the stage should fail on this frame
+	bool enter(E_STAGE stage, size_t frameIndex)
+	{
+		started[stage]++;
+		busy[stage] = true;
+		for (uint32_t other = 0u; other < ES_COUNT; other++)
+		if (other != stage && busy[other])
+			overlapped = true;
+		if (stageTime.count())
+			std::this_thread::sleep_for(stageTime);
+		return frameIndex != failingFrame[stage];
+	}
+	void leave(E_STAGE stage)
+	{
+		finished[stage]++;
+		busy[stage] = false;
+	}
+
+	static void updateMax(std::atomic<uint32_t>& max, uint32_t value)
+	{
+		uint32_t previous = max;
+		while (previous < value && !max.compare_exchange_weak(previous, value)) {}
+	}
+};
+
+class CStubLoader final : public IFrameLoader
+{
+	public:
+		explicit CStubLoader(SRecord& record) : m_record(record) {}
+
+		size_t getFrameCount() const override { return m_record.frameCount; }
+		bool load(SFrameStaging& outInputs) override
+		{
+			// a staging buffer only comes back once the denoiser is done with its frame
+			SRecord::updateMax(m_record.maxInputsInFlight, m_record.started[ES_LOAD] + 1u - m_record.finished[ES_DENOISE]);
+			if (!m_record.enter(ES_LOAD, outInputs.frameIndex))
+				return false;
+
+			const bool allocated = outInputs.resize(StubWidth, StubHeight, EPF_FLOAT4, 1u);
+			if (allocated)
+			{
+				std::memcpy(outInputs.getLayer(0u), &outInputs.frameIndex, sizeof(size_t));
+				std::lock_guard<std::mutex> lock(m_record.mutex);
+				m_record.inputStorage.insert(outInputs.storage);
+			}
+			m_record.leave(ES_LOAD);
+			return allocated;
+		}
+
+	private:
+		SRecord& m_record;
+};
+
+class CStubDenoiser final : public IFrameDenoiser
+{
+	public:
+		explicit CStubDenoiser(SRecord& record) : m_record(record) {}
+
+		bool prepare(const SFrameStaging& inputs) override
+		{
+			if (!m_record.enter(ES_PREPARE, inputs.frameIndex))
+				return false;
+			m_record.leave(ES_PREPARE);
+			return true;
+		}
+		bool denoise(const SFrameStaging& inputs, SFrameStaging& output) override
+		{
+			SRecord::updateMax(m_record.maxOutputsInFlight, m_record.started[ES_DENOISE] + 1u - m_record.finished[ES_SAVE]);
+			if (!m_record.enter(ES_DENOISE, inputs.frameIndex))
+				return false;
+
+			// passes on which input it got, so the saver can tell the frames didn't get mixed up
+			const bool allocated = output.resizeLike(inputs, EPF_FLOAT4);
+			if (allocated)
+				std::memcpy(output.getLayer(0u), inputs.getLayer(0u), sizeof(size_t));
+			m_record.leave(ES_DENOISE);
+			return allocated;
+		}
+
+	private:
+		SRecord& m_record;
+};
+
+class CStubSaver final : public IFrameSaver
+{
+	public:
+		explicit CStubSaver(SRecord& record) : m_record(record) {}
+
+		bool save(const SFrameStaging& output) override
+		{
+			if (!m_record.enter(ES_SAVE, output.frameIndex))
+				return false;
+
+			size_t loadedIndex;
+			std::memcpy(&loadedIndex, output.getLayer(0u), sizeof(size_t));
+			DBR_CHECK(loadedIndex == output.frameIndex);
+			{
+				std::lock_guard<std::mutex> lock(m_record.mutex);
+				m_record.saved.push_back(output.frameIndex);
+			}
+			m_record.leave(ES_SAVE);
+			return true;
+		}
+
+	private:
+		SRecord& m_record;
+};
+
+void checkInOrder(const std::vector<size_t>& frames, const size_t count)
+{
+	if (!DBR_CHECK(frames.size() == count))
+		return;
+	for (size_t i = 0ull; i < count; i++)
+		DBR_CHECK(frames[i] == i);
+}
+
+void testOrdering(const bool overlapped, const uint32_t stagingDepth)
+{
+	constexpr size_t FrameCount = 17ull;
+	SRecord record(FrameCount);
+	CStubLoader loader(record);
+	CStubDenoiser denoiser(record);
+	CStubSaver saver(record);
+	CFramePipeline pipeline(&loader, &denoiser, &saver, stagingDepth);
+
+	std::vector<size_t> done;
+	CFramePipeline::SStatistics statistics;
+	const bool success = pipeline.run(overlapped, statistics, [&done](const SFrameStaging& output, const SFrameTimings&)
+	{
+		done.push_back(output.frameIndex);
+	});
+	DBR_CHECK(success);
+
+	// every frame through every stage exactly once, saved in order
+	for (uint32_t stage = 0u; stage < ES_COUNT; stage++)
+		DBR_CHECK(record.started[stage] == FrameCount && record.finished[stage] == FrameCount);
+	checkInOrder(record.saved, FrameCount);
+	checkInOrder(done, FrameCount);
+	DBR_CHECK(statistics.frames.size() == FrameCount);
+	DBR_CHECK(statistics.pixels == FrameCount * StubWidth * StubHeight);
+
+	// the loader never gets ahead by more than the staging buffers there are
+	const uint32_t depth = overlapped ? stagingDepth : 1u;
+	DBR_CHECK(record.maxInputsInFlight <= depth);
+	DBR_CHECK(record.maxOutputsInFlight <= depth);
+	DBR_CHECK(!record.inputStorage.empty() && record.inputStorage.size() <= depth);
+	if (!overlapped)
+		DBR_CHECK(!record.overlapped);
+}
+
+void testOverlap()
+{
+	// long enough for the loader to start on the next frame while this one is denoised, on any scheduler
+	constexpr size_t FrameCount = 8ull;
+	SRecord record(FrameCount, std::chrono::milliseconds(5));
+	CStubLoader loader(record);
+	CStubDenoiser denoiser(record);
+	CStubSaver saver(record);
+	CFramePipeline pipeline(&loader, &denoiser, &saver, 2u);
+
+	CFramePipeline::SStatistics statistics;
+	DBR_CHECK(pipeline.run(true, statistics));
+	DBR_CHECK(record.overlapped);
+	DBR_CHECK(record.maxInputsInFlight >= 2u);
+	checkInOrder(record.saved, FrameCount);
+	// each stage is busy for every frame, so busy time adds up beyond the wall time once they overlap
+	DBR_CHECK(statistics.loadMilliseconds + statistics.denoiseMilliseconds + statistics.saveMilliseconds > statistics.wallMilliseconds);
+}
+
+void testFailure(const bool overlapped, const E_STAGE failingStage)
+{
+	constexpr size_t FrameCount = 64ull, FailingFrame = 5ull;
+	constexpr uint32_t StagingDepth = 2u;
+	SRecord record(FrameCount);
+	record.failingFrame[failingStage] = FailingFrame;
+	CStubLoader loader(record);
+	CStubDenoiser denoiser(record);
+	CStubSaver saver(record);
+	CFramePipeline pipeline(&loader, &denoiser, &saver, StagingDepth);
+
+	CFramePipeline::SStatistics statistics;
+	DBR_CHECK(!pipeline.run(overlapped, statistics));
+
+	// saved in order and none from the failing one on, overlapped an abort may drop the frames still in flight
+	if (overlapped)
+		DBR_CHECK(record.saved.size() <= FailingFrame);
+	checkInOrder(record.saved, overlapped ? std::min(record.saved.size(), FailingFrame) : FailingFrame);
+	DBR_CHECK(record.started[failingStage] == FailingFrame + 1u);
+	// no stage gets further than the staging buffers would have let it
+	const uint32_t slack = overlapped ? 2u * StagingDepth + 2u : 0u;
+	for (uint32_t stage = 0u; stage < ES_COUNT; stage++)
+		DBR_CHECK(record.started[stage] <= FailingFrame + 1u + slack);
+}
+
+}
+
+void runFramePipelineTests()
+{
+	for (const bool overlapped : { false,true })
+	{
+		for (const uint32_t stagingDepth : { 1u,2u,4u })
+			testOrdering(overlapped, stagingDepth);
+		for (uint32_t stage = 0u; stage < ES_COUNT; stage++)
+			testFailure(overlapped, E_STAGE(stage));
+	}
+	testOverlap();
+}
@@ -0,0 +1,209 @@
+#include "Check.h"
+#include "denoiser/CMemoryPool.h"
+
+#include <cstring>
+#include <unordered_map>
+
+using namespace dbr;
+
+namespace
+{
+
+//! Plain host memory with a capacity, remembering what got handed back upstream and in which order
+class CRecordingAllocator final : public IMemoryAllocator
+{
+	public:
+		explicit CRecordingAllocator(size_t capacity = ~size_t(0u)) : m_capacity(capacity) {}
+
+		address_t allocate(size_t size) override
+		{
+			if (size > m_capacity - m_allocatedBytes)
+				return 0ull;
+			const address_t retval = m_host.allocate(size);
+			if (retval)
+			{
+				m_sizes[retval] = size;
+				m_allocatedBytes += size;
+			}
+			return retval;
+		}
+		void deallocate(address_t address) override
+		{
+			auto found = m_sizes.find(address);
+			if (!DBR_CHECK(found != m_sizes.end()))
+				return;
+			m_allocatedBytes -= found->second;
+			m_deallocatedSizes.push_back(found->second);
+			m_sizes.erase(found);
+			m_host.deallocate(address);
+		}
+		size_t getAvailableMemory() const override { return m_capacity - m_allocatedBytes; }
+
+		inline size_t getAllocatedBytes() const { return m_allocatedBytes; }
+		inline const std::vector<size_t>& getDeallocatedSizes() const { return m_deallocatedSizes; }
+
+	private:
+		CHostMemoryAllocator m_host;
+		const size_t m_capacity;
+		size_t m_allocatedBytes = 0ull;
+		std::unordered_map<address_t, size_t> m_sizes;
+		std::vector<size_t> m_deallocatedSizes;
+};
+
+void testSizeClasses()
+{
+	DBR_CHECK(CMemoryPool::getSizeClass(1ull) == CMemoryPool::MinClassSize);
+	DBR_CHECK(CMemoryPool::getSizeClass(256ull) == 256ull);
+	DBR_CHECK(CMemoryPool::getSizeClass(257ull) == 320ull);
+	DBR_CHECK(CMemoryPool::getSizeClass(320ull) == 320ull);
+	DBR_CHECK(CMemoryPool::getSizeClass(321ull) == 384ull);
+	DBR_CHECK(CMemoryPool::getSizeClass(511ull) == 512ull);
+
+	// powers of two are classes of their own, one byte more goes to the next quarter step
+	for (uint32_t exponent = 9u; exponent < 48u; exponent++)
+	{
+		const size_t power = 1ull << exponent;
+		DBR_CHECK(CMemoryPool::getSizeClass(power) == power);
+		DBR_CHECK(CMemoryPool::getSizeClass(power + 1ull) == power + power / 4ull);
+		DBR_CHECK(CMemoryPool::getSizeClass(power - 1ull) == power);
+	}
+
+	// never smaller than requested and less than 25% wasted
+	for (size_t size = 257ull; size < (1ull << 20ull); size = size * 9ull / 8ull + 1ull)
+	{
+		const size_t classSize = CMemoryPool::getSizeClass(size);
+		DBR_CHECK(classSize >= size && (classSize - size) * 4ull < classSize);
+		DBR_CHECK(CMemoryPool::getSizeClass(classSize) == classSize);
+	}
+}
+
+void testReuseAndAccounting()
+{
+	CRecordingAllocator upstream;
+	{
+		CMemoryPool pool(&upstream, 1ull << 20ull);
+		DBR_CHECK(pool.allocate(0ull) == 0ull);
+		pool.deallocate(0ull);
+
+		const address_t a = pool.allocate(1000ull);
+		const address_t b = pool.allocate(1010ull);
+		if (!DBR_CHECK(a && b && a != b))
+			return;
+
+		auto statistics = pool.getStatistics();
+		DBR_CHECK(statistics.allocations == 2ull && statistics.reuses == 0ull && statistics.upstreamAllocations == 2ull);
+		DBR_CHECK(statistics.requestedBytes == 2010ull && statistics.usedBytes == 2048ull && statistics.cachedBytes == 0ull);
+		DBR_CHECK(statistics.getInternalFragmentation() == 1.0 - 2010.0 / 2048.0);
+		DBR_CHECK(upstream.getAllocatedBytes() == 2048ull);
+
+		// the most recently freed block of a class comes back first
+		pool.deallocate(a);
+		pool.deallocate(b);
+		statistics = pool.getStatistics();
+		DBR_CHECK(statistics.usedBytes == 0ull && statistics.requestedBytes == 0ull && statistics.cachedBytes == 2048ull);
+		DBR_CHECK(statistics.getIdleFraction() == 1.0);
+		DBR_CHECK(pool.getAvailableMemory() == upstream.getAvailableMemory() + 2048ull);
+
+		const address_t c = pool.allocate(900ull);
+		DBR_CHECK(c == b);
+		const address_t d = pool.allocate(1024ull);
+		DBR_CHECK(d == a);
+		const address_t e = pool.allocate(1025ull);
+		DBR_CHECK(e && e != a && e != b);
+
+		statistics = pool.getStatistics();
+		DBR_CHECK(statistics.allocations == 5ull && statistics.reuses == 2ull && statistics.upstreamAllocations == 3ull);
+		DBR_CHECK(statistics.getReuseRate() == 0.4);
+		DBR_CHECK(statistics.usedBytes == 1024ull + 1024ull + 1280ull && statistics.cachedBytes == 0ull);
+		DBR_CHECK(statistics.peakUsedBytes == statistics.usedBytes && statistics.peakReservedBytes == statistics.usedBytes);
+		DBR_CHECK(upstream.getDeallocatedSizes().empty());
+
+		pool.deallocate(c);
+		pool.deallocate(d);
+		pool.deallocate(e);
+		DBR_CHECK(pool.getStatistics().peakReservedBytes == 1024ull + 1024ull + 1280ull);
+	}
+	// the pool gives its cache back when it goes
+	DBR_CHECK(upstream.getAllocatedBytes() == 0ull);
+	DBR_CHECK(upstream.getDeallocatedSizes().size() == 3ull);
+}
+
+void testTrim()
+{
+	CRecordingAllocator upstream;
+	CMemoryPool pool(&upstream, 1ull << 30ull);
+
+	const size_t sizes[] = { 300ull,5000ull,1000ull,70000ull,1000ull };
+	std::vector<address_t> blocks;
+	for (const size_t size : sizes)
+		blocks.push_back(pool.allocate(size));
+	for (const address_t block : blocks)
+		pool.deallocate(block);
+	DBR_CHECK(pool.getStatistics().cachedBytes == 320ull + 5120ull + 1024ull + 81920ull + 1024ull);
+
+	// biggest first, until no more than asked for are left
+	pool.trim(6000ull);
+	DBR_CHECK(upstream.getDeallocatedSizes() == std::vector<size_t>({ 81920ull,5120ull }));
+	DBR_CHECK(pool.getStatistics().cachedBytes == 320ull + 1024ull + 1024ull);
+	DBR_CHECK(pool.getStatistics().upstreamDeallocations == 2ull);
+
+	pool.trim(0ull);
+	DBR_CHECK(upstream.getDeallocatedSizes() == std::vector<size_t>({ 81920ull,5120ull,1024ull,1024ull,320ull }));
+	DBR_CHECK(pool.getStatistics().cachedBytes == 0ull && upstream.getAllocatedBytes() == 0ull);
+}
+
+void testLimits()
+{
+	// freed blocks beyond the cache limit go straight back upstream
+	{
+		CRecordingAllocator upstream;
+		CMemoryPool pool(&upstream, 2048ull);
+		const address_t small = pool.allocate(2000ull);
+		const address_t big = pool.allocate(5000ull);
+		pool.deallocate(small);
+		pool.deallocate(big);
+		DBR_CHECK(upstream.getDeallocatedSizes() == std::vector<size_t>({ 5120ull }));
+		DBR_CHECK(pool.getStatistics().cachedBytes == 2048ull);
+	}
+
+	// an upstream allocation that fails gets retried once the cache is given back
+	{
+		CRecordingAllocator upstream(6000ull);
+		CMemoryPool pool(&upstream, 1ull << 20ull);
+		pool.deallocate(pool.allocate(4096ull));
+		const address_t block = pool.allocate(3000ull);
+		DBR_CHECK(block != 0ull);
+		DBR_CHECK(upstream.getDeallocatedSizes() == std::vector<size_t>({ 4096ull }));
+		DBR_CHECK(pool.getStatistics().cachedBytes == 0ull && pool.getStatistics().upstreamAllocations == 2ull);
+
+		// and fails for good if it still doesn't fit
+		DBR_CHECK(pool.allocate(4096ull) == 0ull);
+		DBR_CHECK(pool.getStatistics().allocations == 2ull);
+		pool.deallocate(block);
+	}
+}
+
+void testHostAllocator()
+{
+	CHostMemoryAllocator host;
+	CMemoryPool pool(&host, 1ull << 20ull);
+	const address_t block = pool.allocate(100000ull);
+	if (!DBR_CHECK(block))
+		return;
+	DBR_CHECK(block % CHostMemoryAllocator::Alignment == 0ull);
+	std::memset(reinterpret_cast<void*>(block), 0xab, 100000ull);
+	pool.deallocate(block);
+	DBR_CHECK(pool.allocate(99000ull) == block);
+	pool.deallocate(block);
+}
+
+}
+
+void runMemoryPoolTests()
+{
+	testSizeClasses();
+	testReuseAndAccounting();
+	testTrim();
+	testLimits();
+	testHostAllocator();
+}
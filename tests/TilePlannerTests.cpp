@@ -0,0 +1,177 @@
+#include "Check.h"
+#include "denoiser/CTilePlanner.h"
+
+#include <vector>
+
+using namespace dbr;
+
+namespace
+{
+
+constexpr uint32_t StubOverlap = 64u;
+
+// grows like the OptiX HDR model does, state and scratch linear in the tile area padded by the overlap on every side
+bool getStubRequirements(uint32_t tileWidth, uint32_t tileHeight, SDenoiserMemoryRequirements& outRequirements)
+{
+	const size_t paddedArea = size_t(tileWidth + 2u * StubOverlap) * (tileHeight + 2u * StubOverlap);
+	outRequirements.stateSizeInBytes = (16ull << 20ull) + paddedArea * 64ull;
+	outRequirements.scratchSizeInBytes = paddedArea * 176ull;
+	outRequirements.overlapWindowSizeInPixels = StubOverlap;
+	return true;
+}
+
+size_t getStubTotalSize(const CTilePlanner::SRequest& request, uint32_t tileWidth, uint32_t tileHeight)
+{
+	SDenoiserMemoryRequirements requirements;
+	getStubRequirements(tileWidth, tileHeight, requirements);
+	return requirements.stateSizeInBytes + requirements.scratchSizeInBytes + CTilePlanner::getPixelBufferSize(request);
+}
+
+//! Every tile extent a grid of 1, 2, 3... tiles along an image extent produces, independent of the planner's own enumeration
+std::vector<uint32_t> getGridExtents(const uint32_t imageExtent, const uint32_t granularity, const uint32_t minTileSize)
+{
+	std::vector<uint32_t> extents = { imageExtent };
+	for (uint32_t count = 2u; count <= imageExtent; count++)
+	{
+		const uint32_t even = (imageExtent + count - 1u) / count;
+		const uint32_t extent = std::min((even + granularity - 1u) / granularity * granularity, imageExtent);
+		if (extent < minTileSize)
+			break;
+		if (extent < extents.back())
+			extents.push_back(extent);
+	}
+	return extents;
+}
+
+//! The tiles partition the image and every input rectangle is its tile grown by the overlap, clamped to the image
+void checkCoverage(const std::vector<STile>& tiles, const uint32_t width, const uint32_t height, const uint32_t overlap)
+{
+	uint64_t area = 0ull;
+	for (size_t i = 0ull; i < tiles.size(); i++)
+	{
+		const STile& tile = tiles[i];
+		if (!DBR_CHECK(tile.width && tile.height && tile.x + tile.width <= width && tile.y + tile.height <= height))
+			continue;
+		area += uint64_t(tile.width) * tile.height;
+
+		DBR_CHECK(tile.inputX == (tile.x > overlap ? tile.x - overlap : 0u));
+		DBR_CHECK(tile.inputY == (tile.y > overlap ? tile.y - overlap : 0u));
+		DBR_CHECK(tile.inputX + tile.inputWidth == std::min(tile.x + tile.width + overlap, width));
+		DBR_CHECK(tile.inputY + tile.inputHeight == std::min(tile.y + tile.height + overlap, height));
+
+		for (size_t j = 0ull; j < i; j++)
+		{
+			const STile& other = tiles[j];
+			const bool disjoint = tile.x >= other.x + other.width || other.x >= tile.x + tile.width || tile.y >= other.y + other.height || other.y >= tile.y + tile.height;
+			DBR_CHECK(disjoint);
+		}
+	}
+	// disjoint and inside the image, so the areas only add up if nothing is left out
+	DBR_CHECK(area == uint64_t(width) * height);
+}
+
+void testMakeTiles()
+{
+	struct SCase
+	{
+		uint32_t width, height, tileWidth, tileHeight, overlap;
+	};
+	const SCase cases[] = {
+		{ 3840u,2160u,1920u,1080u,64u },
+		{ 3840u,2160u,1000u,700u,7u },
+		{ 7680u,4320u,4096u,4096u,64u },
+		{ 1023u,517u,64u,64u,0u },
+		{ 640u,480u,1024u,1024u,64u },
+		{ 5u,3u,1u,1u,2u }
+	};
+	for (const auto& c : cases)
+	{
+		const auto tiles = CTilePlanner::makeTiles(c.width, c.height, c.tileWidth, c.tileHeight, c.overlap);
+		const size_t expectedCount = size_t((c.width + c.tileWidth - 1u) / c.tileWidth) * ((c.height + c.tileHeight - 1u) / c.tileHeight);
+		DBR_CHECK(tiles.size() == expectedCount);
+		checkCoverage(tiles, c.width, c.height, c.overlap);
+	}
+
+	DBR_CHECK(CTilePlanner::makeTiles(0u, 2160u, 512u, 512u, 64u).empty());
+	DBR_CHECK(CTilePlanner::makeTiles(3840u, 2160u, 0u, 512u, 64u).empty());
+}
+
+void testPlan(const uint32_t width, const uint32_t height, const size_t tilingBudget)
+{
+	CTilePlanner::SRequest request;
+	request.width = width;
+	request.height = height;
+	request.memoryBudget = CTilePlanner::getPixelBufferSize(request) + tilingBudget;
+
+	STilePlan plan;
+	if (!DBR_CHECK(CTilePlanner::plan(request, getStubRequirements, plan)))
+		return;
+
+	DBR_CHECK(plan.imageWidth == width && plan.imageHeight == height);
+	DBR_CHECK(plan.overlap == StubOverlap);
+	DBR_CHECK(plan.getTotalSizeInBytes() <= request.memoryBudget);
+	DBR_CHECK(plan.getTotalSizeInBytes() == getStubTotalSize(request, plan.tileWidth, plan.tileHeight));
+	DBR_CHECK(plan.tileWidth == width || plan.tileWidth % request.granularity == 0u);
+	DBR_CHECK(plan.tileHeight == height || plan.tileHeight % request.granularity == 0u);
+	DBR_CHECK(plan.tileWidth >= request.minTileSize && plan.tileHeight >= request.minTileSize);
+	checkCoverage(plan.tiles, width, height, plan.overlap);
+
+	// no grid tile shape of a larger area fits
+	const uint64_t area = uint64_t(plan.tileWidth) * plan.tileHeight;
+	for (const uint32_t tileWidth : getGridExtents(width, request.granularity, request.minTileSize))
+	for (const uint32_t tileHeight : getGridExtents(height, request.granularity, request.minTileSize))
+	if (uint64_t(tileWidth) * tileHeight > area)
+		DBR_CHECK(getStubTotalSize(request, tileWidth, tileHeight) > request.memoryBudget);
+
+	// the budget is a hard limit, a byte less than the plan takes has to shrink the tiles
+	STilePlan tighter;
+	request.memoryBudget = plan.getTotalSizeInBytes();
+	DBR_CHECK(CTilePlanner::plan(request, getStubRequirements, tighter) && tighter.tileWidth == plan.tileWidth && tighter.tileHeight == plan.tileHeight);
+	request.memoryBudget--;
+	if (DBR_CHECK(CTilePlanner::plan(request, getStubRequirements, tighter)))
+	{
+		DBR_CHECK(uint64_t(tighter.tileWidth) * tighter.tileHeight < area);
+		DBR_CHECK(tighter.getTotalSizeInBytes() <= request.memoryBudget);
+	}
+}
+
+void testPlanLimits()
+{
+	CTilePlanner::SRequest request;
+	request.width = 3840u;
+	request.height = 2160u;
+
+	// the full frame buffers alone don't fit
+	STilePlan plan;
+	request.memoryBudget = CTilePlanner::getPixelBufferSize(request) - 1ull;
+	DBR_CHECK(!CTilePlanner::plan(request, getStubRequirements, plan));
+	// they do, but not even the smallest tile
+	request.memoryBudget = CTilePlanner::getPixelBufferSize(request) + (16ull << 20ull);
+	DBR_CHECK(!CTilePlanner::plan(request, getStubRequirements, plan));
+	// everything fits, one tile
+	request.memoryBudget = ~size_t(0u) / 2u;
+	if (DBR_CHECK(CTilePlanner::plan(request, getStubRequirements, plan)))
+		DBR_CHECK(plan.tileWidth == request.width && plan.tileHeight == request.height && plan.tiles.size() == 1ull);
+
+	// a fixed size ignores the budget and gets clamped to the frame
+	request.memoryBudget = 0ull;
+	if (DBR_CHECK(CTilePlanner::planFixed(request, 8192u, 1024u, getStubRequirements, plan)))
+	{
+		DBR_CHECK(plan.tileWidth == request.width && plan.tileHeight == 1024u && plan.tiles.size() == 3ull);
+		checkCoverage(plan.tiles, request.width, request.height, plan.overlap);
+	}
+}
+
+}
+
+void runTilePlannerTests()
+{
+	testMakeTiles();
+	testPlanLimits();
+	for (const size_t tilingMiB : { 256ull,1024ull,4096ull })
+	{
+		testPlan(3840u, 2160u, tilingMiB << 20ull);
+		testPlan(7680u, 4320u, tilingMiB << 20ull);
+		testPlan(15360u, 8640u, tilingMiB << 20ull);
+	}
+}
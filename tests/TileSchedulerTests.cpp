@@ -0,0 +1,130 @@
+#include "Check.h"
+#include "denoiser/CTileScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+using namespace dbr;
+
+namespace
+{
+
+void testLatencyHistogram()
+{
+	CTileScheduler::SLatencyHistogram histogram;
+	DBR_CHECK(histogram.getQuantileBound(0.5) == 0.0);
+
+	// on a bound goes into that bucket, past the last bound into the last one
+	histogram.add(0.1);
+	histogram.add(0.25);
+	histogram.add(0.3);
+	histogram.add(1000000.0);
+	DBR_CHECK(histogram.count == 4u);
+	DBR_CHECK(histogram.counts[0] == 2u && histogram.counts[1] == 1u && histogram.counts[CTileScheduler::SLatencyHistogram::BucketCount - 1u] == 1u);
+	DBR_CHECK(histogram.maxMilliseconds == 1000000.0);
+	DBR_CHECK(histogram.getQuantileBound(0.5) == 0.25);
+	DBR_CHECK(histogram.getQuantileBound(0.75) == 0.5);
+	DBR_CHECK(histogram.getQuantileBound(1.0) == 1000000.0);
+
+	// a bound never exceeds the slowest latency seen
+	CTileScheduler::SLatencyHistogram other;
+	other.add(3.0);
+	DBR_CHECK(other.getQuantileBound(0.5) == 3.0);
+
+	histogram.merge(other);
+	DBR_CHECK(histogram.count == 5u && histogram.counts[4] == 1u && histogram.maxMilliseconds == 1000000.0);
+}
+
+//! Worker 0 stands in for a straggler, every tile takes it a few milliseconds while the others take none
+void testUnevenWorkers()
+{
+	constexpr uint32_t WorkerCount = 4u;
+	constexpr size_t BeginTile = 10ull, EndTile = 74ull;
+	constexpr auto SlowTileTime = std::chrono::milliseconds(2);
+
+	CThreadPool pool(WorkerCount);
+	CTileScheduler scheduler(WorkerCount);
+	for (uint32_t run = 0u; run < 2u; run++)
+	{
+		std::unique_ptr<std::atomic<uint32_t>[]> calls(new std::atomic<uint32_t>[EndTile]);
+		std::unique_ptr<std::atomic<bool>[]> busy(new std::atomic<bool>[WorkerCount]);
+		for (size_t i = 0ull; i < EndTile; i++)
+			calls[i] = 0u;
+		for (uint32_t w = 0u; w < WorkerCount; w++)
+			busy[w] = false;
+
+		std::atomic<uint32_t> overlappingCalls = 0u;
+		const bool success = scheduler.run(pool, BeginTile, EndTile, [&](uint32_t worker, size_t tile) -> bool
+		{
+			if (busy[worker].exchange(true))
+				overlappingCalls++;
+			if (tile < EndTile)
+				calls[tile]++;
+			if (worker == 0u)
+				std::this_thread::sleep_for(SlowTileTime);
+			busy[worker] = false;
+			return true;
+		});
+		DBR_CHECK(success);
+		DBR_CHECK(overlappingCalls == 0u);
+
+		// every tile of the range exactly once and nothing outside it
+		for (size_t i = 0ull; i < EndTile; i++)
+			DBR_CHECK(calls[i] == (i >= BeginTile ? 1u : 0u));
+	}
+
+	const auto& statistics = scheduler.getStatistics();
+	DBR_CHECK(statistics.runCount == 2u);
+	DBR_CHECK(statistics.wallMilliseconds > 0.0);
+	if (!DBR_CHECK(statistics.workers.size() == WorkerCount))
+		return;
+
+	uint32_t tileCount = 0u, stolenCount = 0u;
+	for (uint32_t w = 0u; w < WorkerCount; w++)
+	{
+		const auto& worker = statistics.workers[w];
+		tileCount += worker.tileCount;
+		stolenCount += worker.stolenCount;
+		DBR_CHECK(worker.latencies.count == worker.tileCount);
+		DBR_CHECK(worker.stolenCount <= worker.tileCount);
+		DBR_CHECK(statistics.getUtilization(w) >= 0.0 && statistics.getUtilization(w) <= 1.0);
+	}
+	DBR_CHECK(tileCount == 2u * (EndTile - BeginTile));
+	// the fast workers run out long before the straggler gets through its quarter
+	DBR_CHECK(stolenCount > 0u);
+	DBR_CHECK(statistics.workers[0].tileCount < (EndTile - BeginTile) / WorkerCount * 2u);
+	DBR_CHECK(statistics.workers[0].tileCount == 0u || statistics.workers[0].latencies.maxMilliseconds >= 2.0);
+
+	scheduler.resetStatistics();
+	DBR_CHECK(scheduler.getStatistics().runCount == 0u && scheduler.getStatistics().workers.size() == WorkerCount);
+	DBR_CHECK(scheduler.getStatistics().workers[0].tileCount == 0u);
+}
+
+void testFailure()
+{
+	constexpr size_t TileCount = 256ull;
+	CThreadPool pool(2u);
+	CTileScheduler scheduler(2u);
+
+	// once a tile fails no more get handed out
+	std::atomic<uint32_t> callCount = 0u;
+	const bool success = scheduler.run(pool, 0ull, TileCount, [&](uint32_t, size_t tile) -> bool
+	{
+		callCount++;
+		return tile != 3ull;
+	});
+	DBR_CHECK(!success);
+	DBR_CHECK(callCount < TileCount);
+
+	DBR_CHECK(scheduler.run(pool, 5ull, 5ull, [](uint32_t, size_t) { return false; }));
+}
+
+}
+
+void runTileSchedulerTests()
+{
+	testLatencyHistogram();
+	testUnevenWorkers();
+	testFailure();
+}
@@ -0,0 +1,48 @@
+#include "Check.h"
+
+#include <string_view>
+
+void runTilePlannerTests();
+void runTileSchedulerTests();
+void runMemoryPoolTests();
+void runFramePipelineTests();
+
+namespace
+{
+
+struct SSuite
+{
+	std::string_view name;
+	void (*run)();
+};
+
+constexpr SSuite suites[] = {
+	{ "tile_planner",runTilePlannerTests },
+	{ "tile_scheduler",runTileSchedulerTests },
+	{ "memory_pool",runMemoryPoolTests },
+	{ "frame_pipeline",runFramePipelineTests }
+};
+
+}
+
+//! Runs the suite named on the command line, or all of them, and fails if any check did
+int main(int argc, char** argv)
+{
+	const std::string_view requested = argc > 1 ? argv[1] : "";
+	bool found = false;
+	for (const auto& suite : suites)
+	if (requested.empty() || requested == suite.name)
+	{
+		suite.run();
+		found = true;
+	}
+
+	if (!found)
+	{
+		std::cerr << "ERROR: No test suite named " << requested << "\n";
+		return 1;
+	}
+	const uint32_t failures = dbr::tests::getFailureCount();
+	std::cout << (failures ? "FAILED " : "PASSED ") << (requested.empty() ? "all" : requested) << ", " << failures << " failed check(s)\n";
+	return failures ? 1 : 0;
+}